@@ -2,4 +2,207 @@
  * @see ADC.h for description.
  * @author Adrien RICCIARDI
  */
-#include <ADC.h>
\ No newline at end of file
+#include <system.h>
+#include "ADC.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+#ifndef ADC_TEMPERATURE_SENSORS_ANALOG_CHANNELS
+	/** The analog channel of each temperature sensor, separated by commas (the pins must be left configured as inputs). */
+	#define ADC_TEMPERATURE_SENSORS_ANALOG_CHANNELS 1
+#endif
+
+/** How many conversion requests can be queued (it must be a power of two). All the temperature sensors and the battery voltage must fit. */
+#if ADC_TEMPERATURE_SENSORS_COUNT < 4
+	#define ADC_QUEUE_SIZE 4
+#elif ADC_TEMPERATURE_SENSORS_COUNT < 8
+	#define ADC_QUEUE_SIZE 8
+#else
+	#define ADC_QUEUE_SIZE 16
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// Private types
+//--------------------------------------------------------------------------------------------------
+/** The ADC registers configuration needed to convert a channel. */
+typedef struct
+{
+	unsigned char Control_0; //!< ADCON0 value, selecting the channel with the ADC enabled.
+	unsigned char Control_1; //!< ADCON1 value, selecting the voltage references.
+	unsigned char Control_2; //!< ADCON2 value, selecting the result justification, the acquisition time and the conversion clock.
+} TADCChannelConfiguration;
+
+/** Some conversions of a channel waiting to be done. */
+typedef struct
+{
+	TADCChannel Channel;
+	unsigned char Conversions_Count;
+	TADCConversionCallback Callback;
+} TADCRequest;
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The temperature sensors configuration, only the channel differs (all conversions are right justified and clocked by the dedicated RC oscillator to keep converting while the core is idle). */
+static const TADCChannelConfiguration ADC_Temperature_Configuration = {0x01, 0x08, 0x8B}; // Positive reference voltage comes from the Fixed Voltage Reference, charge the sampling capacitor for almost 2 Tad as the TMP36 output impedance is low
+
+/** The battery voltage configuration. */
+static const TADCChannelConfiguration ADC_Battery_Voltage_Configuration = {0x3D, 0x00, 0xAB}; // Fixed Voltage Reference channel, positive reference voltage is Vdd, charge the sampling capacitor for 12 Tad
+
+/** The temperature sensors analog channel. */
+static const unsigned char ADC_Temperature_Sensors_Analog_Channels[ADC_TEMPERATURE_SENSORS_COUNT] = {ADC_TEMPERATURE_SENSORS_ANALOG_CHANNELS};
+
+/** The conversion requests queue. */
+static TADCRequest ADC_Requests_Queue[ADC_QUEUE_SIZE];
+/** The request being serviced. */
+static unsigned char ADC_Requests_Queue_Read_Index = 0;
+/** How many requests are queued (the serviced one included). */
+static unsigned char ADC_Requests_Queue_Count = 0;
+
+/** The last conversion result of each channel. */
+static unsigned short ADC_Channel_Values[ADC_CHANNELS_COUNT];
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Configure the ADC for the request being serviced and start a conversion. */
+static void ADCStartConversion(void)
+{
+	TADCChannel Channel;
+	
+	Channel = ADC_Requests_Queue[ADC_Requests_Queue_Read_Index].Channel;
+	if (Channel == ADC_CHANNEL_BATTERY_VOLTAGE)
+	{
+		adcon2 = ADC_Battery_Voltage_Configuration.Control_2;
+		adcon1 = ADC_Battery_Voltage_Configuration.Control_1;
+		adcon0 = ADC_Battery_Voltage_Configuration.Control_0;
+	}
+	else
+	{
+		adcon2 = ADC_Temperature_Configuration.Control_2;
+		adcon1 = ADC_Temperature_Configuration.Control_1;
+		adcon0 = ADC_Temperature_Configuration.Control_0 | (ADC_Temperature_Sensors_Analog_Channels[Channel - ADC_CHANNEL_TEMPERATURE] << 2);
+	}
+	adcon0.GO = 1; // The acquisition time is automatically inserted before the conversion
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void ADCInitialize(void)
+{
+	unsigned char i, Analog_Channel;
+	
+	// Initialize the temperature sensors pins as analog inputs (they are inputs on reset)
+	for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++)
+	{
+		Analog_Channel = ADC_Temperature_Sensors_Analog_Channels[i];
+		if (Analog_Channel < 8) ansel |= 1 << Analog_Channel;
+		else anselh |= 1 << (Analog_Channel - 8);
+	}
+	
+	// Configure the module for the temperature sensors and keep it disabled
+	adcon2 = ADC_Temperature_Configuration.Control_2;
+	adcon1 = ADC_Temperature_Configuration.Control_1;
+	adcon0 = 0;
+	
+	// Signal the conversion end with an interrupt instead of polling the GO bit
+	pir1.ADIF = 0;
+	pie1.ADIE = 1;
+}
+
+void ADCSetPowerMode(unsigned char Is_Low_Power_Required)
+{
+	if (Is_Low_Power_Required)
+	{
+		// Stop the module, aborting any running conversion
+		adcon0.ADON = 0;
+		ADC_Requests_Queue_Count = 0;
+		
+		// Disable the Fixed Voltage Reference
+		vrefcon0.FVR1EN = 0;
+	}
+	else
+	{
+		// Do not wait for the reference to become stable, the function is called from the interrupt handler
+		vrefcon0 = 0x90; // Enable the Fixed Voltage Reference at 1,024V
+		adcon0.ADON = 1;
+	}
+}
+
+unsigned char ADCIsReady(void)
+{
+	return vrefcon0.FVR1ST;
+}
+
+unsigned char ADCQueueConversions(TADCChannel Channel, unsigned char Conversions_Count, TADCConversionCallback Callback)
+{
+	TADCRequest *Pointer_Request;
+	unsigned char Index;
+	
+	if (ADC_Requests_Queue_Count >= ADC_QUEUE_SIZE) return 1;
+	
+	// Append the request
+	Index = (ADC_Requests_Queue_Read_Index + ADC_Requests_Queue_Count) & (ADC_QUEUE_SIZE - 1);
+	Pointer_Request = &ADC_Requests_Queue[Index];
+	Pointer_Request->Channel = Channel;
+	Pointer_Request->Conversions_Count = Conversions_Count;
+	Pointer_Request->Callback = Callback;
+	ADC_Requests_Queue_Count++;
+	
+	// Start converting if the ADC was idle
+	if (ADC_Requests_Queue_Count == 1)
+	{
+		pir1.ADIF = 0;
+		ADCStartConversion();
+	}
+	return 0;
+}
+
+unsigned char ADCProcessConversion(void)
+{
+	TADCRequest *Pointer_Request;
+	unsigned short Value;
+	
+	// Ignore a conversion end that occurred while the queue was flushed
+	if (ADC_Requests_Queue_Count == 0) return 1;
+	
+	// Store the result
+	Pointer_Request = &ADC_Requests_Queue[ADC_Requests_Queue_Read_Index];
+	Value = (adresh << 8) | adresl;
+	ADC_Channel_Values[Pointer_Request->Channel] = Value;
+	if (Pointer_Request->Callback) Pointer_Request->Callback(Value);
+	
+	// Go to the next conversion of the same channel (the ADC is already configured)
+	Pointer_Request->Conversions_Count--;
+	if (Pointer_Request->Conversions_Count > 0)
+	{
+		adcon0.GO = 1;
+		return 0;
+	}
+	
+	// Go to the next request
+	ADC_Requests_Queue_Read_Index = (ADC_Requests_Queue_Read_Index + 1) & (ADC_QUEUE_SIZE - 1);
+	ADC_Requests_Queue_Count--;
+	if (ADC_Requests_Queue_Count == 0) return 1;
+	
+	ADCStartConversion();
+	return 0;
+}
+
+unsigned short ADCReadTemperatureValue(unsigned char Sensor_Index)
+{
+	return ADC_Channel_Values[ADC_CHANNEL_TEMPERATURE + Sensor_Index];
+}
+
+unsigned short ADCReadBatteryVoltageValue(void)
+{
+	return ADC_Channel_Values[ADC_CHANNEL_BATTERY_VOLTAGE];
+}
+
+unsigned char ADCIsBatteryLow(void)
+{
+	if (ADC_Channel_Values[ADC_CHANNEL_BATTERY_VOLTAGE] > ADC_BATTERY_LOW_VOLTAGE_VALUE) return 1;
+	return 0;
+}
\ No newline at end of file
@@ -1,27 +1,94 @@
 /** @file ADC.h
  * Read the battery and the temperature sensor values using two Analog to Digital Converter channels.
+ * Conversions are queued and serviced back to back by the ADC interrupt, so all channels share the same Fixed Voltage Reference and ADC power-on.
  * @author Adrien RICCIARDI
  * @version 1.0 : 09/06/2014
  */
 #ifndef H_ADC_H
 #define H_ADC_H
 
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+#ifndef ADC_TEMPERATURE_SENSORS_COUNT
+	/** How many TMP36 sensors are connected (their analog channels are listed by ADC_TEMPERATURE_SENSORS_ANALOG_CHANNELS in ADC.c). */
+	#define ADC_TEMPERATURE_SENSORS_COUNT 1
+#endif
+
+#ifndef ADC_BATTERY_LOW_VOLTAGE
+	/** The battery voltage under which the battery needs to be replaced (in millivolts). */
+	#define ADC_BATTERY_LOW_VOLTAGE 2800
+#endif
+
+/** The battery voltage conversion result corresponding to ADC_BATTERY_LOW_VOLTAGE (the 1024mV reference is converted against the battery voltage). */
+#define ADC_BATTERY_LOW_VOLTAGE_VALUE ((unsigned short) (1024UL * 1023 / ADC_BATTERY_LOW_VOLTAGE))
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** All converted channels. */
+typedef enum
+{
+	ADC_CHANNEL_TEMPERATURE, //!< The first TMP36 output measured against the Fixed Voltage Reference, the other sensors channels follow.
+	ADC_CHANNEL_BATTERY_VOLTAGE = ADC_CHANNEL_TEMPERATURE + ADC_TEMPERATURE_SENSORS_COUNT, //!< The Fixed Voltage Reference measured against the battery voltage.
+	ADC_CHANNELS_COUNT
+} TADCChannel;
+
+/** A function called from the ADC interrupt at the end of each conversion.
+ * @param Value The conversion result in range [0..1023].
+ */
+typedef void (*TADCConversionCallback)(unsigned short Value);
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
 /** Initialize the ADC module. */
 void ADCInitialize(void);
 
-/** Put the ADC module in sleep mode to save power.
+/** Put the ADC module and the Fixed Voltage Reference in sleep mode to save power.
  * @param Is_Low_Power_Required Set to 1 to enable low power mode or to 0 to wake up the module.
+ * @note Waking up does not wait for the Fixed Voltage Reference to become stable, see ADCIsReady(). Entering low power mode aborts all queued conversions.
  */
 void ADCSetPowerMode(unsigned char Is_Low_Power_Required);
 
-/** Sample the temperature sensor voltage value.
+/** Tell whether the Fixed Voltage Reference is stable after the module was woken up, so conversions can be queued.
+ * @return 1 if the conversions can be queued,
+ * @return 0 if the Fixed Voltage Reference is still starting up.
+ */
+unsigned char ADCIsReady(void);
+
+/** Queue conversions of a channel. The conversions start immediately if the ADC is not busy, they are executed after the previously queued ones otherwise.
+ * @param Channel The channel to convert.
+ * @param Conversions_Count How many conversions to do back to back (it must not be zero).
+ * @param Callback The function to call at the end of each conversion, set to 0 if no function needs to be called.
+ * @return 0 if the conversions were queued,
+ * @return 1 if the queue is full.
+ * @note The module must be awake.
+ */
+unsigned char ADCQueueConversions(TADCChannel Channel, unsigned char Conversions_Count, TADCConversionCallback Callback);
+
+/** Handle the end of a conversion and start the next queued one. This function must be called by the ADC interrupt handler.
+ * @return 1 if all queued conversions are terminated,
+ * @return 0 if more conversions are running.
+ * @note Clear the ADC interrupt flag prior calling this function.
+ */
+unsigned char ADCProcessConversion(void);
+
+/** Get the last temperature sensor voltage conversion result.
+ * @param Sensor_Index The sensor index in range [0..ADC_TEMPERATURE_SENSORS_COUNT - 1].
  * @return The temperature sensor value in range [0..1023].
  */
-unsigned short ADCReadTemperatureValue(void);
+unsigned short ADCReadTemperatureValue(unsigned char Sensor_Index);
 
-/** Sample the battery voltage value.
+/** Get the last battery voltage conversion result. As the Fixed Voltage Reference is measured against the battery voltage, the value increases when the battery voltage decreases.
  * @return The battery value in range [0..1023].
  */
 unsigned short ADCReadBatteryVoltageValue(void);
 
+/** Tell whether the battery needs to be replaced, according to the last battery voltage conversion result.
+ * @return 1 if the battery voltage is lower than ADC_BATTERY_LOW_VOLTAGE,
+ * @return 0 if the battery voltage is high enough.
+ */
+unsigned char ADCIsBatteryLow(void);
+
 #endif
\ No newline at end of file
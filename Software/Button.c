@@ -0,0 +1,143 @@
+/** @file Button.c
+ * @see Button.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "Button.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+/** The button pin (high when the button is pushed). */
+#define BUTTON_PIN porta.RA0
+
+/** How many consecutive ticks the pin must keep a new level before it is taken into account (~50ms). */
+#define BUTTON_DEBOUNCE_TICKS 6
+/** How many ticks the button must be held to make a long press (~1s). */
+#define BUTTON_LONG_PRESS_TICKS 122
+/** How many ticks a second press can wait after a short press release to make a double click (~300ms). */
+#define BUTTON_DOUBLE_CLICK_TICKS 37
+
+//--------------------------------------------------------------------------------------------------
+// Private types
+//--------------------------------------------------------------------------------------------------
+/** The gestures recognition states. */
+typedef enum
+{
+	BUTTON_STATE_RELEASED, //!< Wait for a press.
+	BUTTON_STATE_PRESSED, //!< A press is held, it becomes a long press if it lasts long enough.
+	BUTTON_STATE_WAITING_SECOND_PRESS, //!< A short press has been released, another press would make a double click.
+	BUTTON_STATE_WAITING_RELEASE //!< The current press has already made a gesture, ignore it until the button is released.
+} TButtonState;
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The gestures recognition state. */
+static TButtonState Button_State = BUTTON_STATE_RELEASED;
+
+/** How many ticks have been spent in the current state (saturated to 255). */
+static unsigned char Button_State_Ticks_Count = 0;
+
+/** The debounced button level (1 when pushed). */
+static unsigned char Button_Is_Pushed = 0;
+
+/** How many consecutive ticks the pin level differed from the debounced level. */
+static unsigned char Button_Debounce_Ticks_Count = 0;
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void ButtonInitialize(void)
+{
+	// Configure the button pin as digital input
+	ansel.AN0 = 0;
+	trisa.RA0 = 1;
+	
+	// Wake the system up when the button is pushed (rising edge)
+	intcon2.INTEDG0 = 1;
+}
+
+unsigned char ButtonProcessTick(void)
+{
+	unsigned char Events = 0;
+	
+	// Keep the new pin level only when it has been stable long enough
+	if (BUTTON_PIN != Button_Is_Pushed)
+	{
+		Button_Debounce_Ticks_Count++;
+		if (Button_Debounce_Ticks_Count >= BUTTON_DEBOUNCE_TICKS)
+		{
+			Button_Debounce_Ticks_Count = 0;
+			Button_Is_Pushed = !Button_Is_Pushed;
+			if (Button_Is_Pushed) Events = BUTTON_EVENT_PRESSED;
+			else Events = BUTTON_EVENT_RELEASED;
+		}
+	}
+	else Button_Debounce_Ticks_Count = 0;
+	
+	// Recognize the gestures
+	if (Button_State_Ticks_Count < 255) Button_State_Ticks_Count++;
+	switch (Button_State)
+	{
+		case BUTTON_STATE_RELEASED:
+			if (Events & BUTTON_EVENT_PRESSED)
+			{
+				Button_State = BUTTON_STATE_PRESSED;
+				Button_State_Ticks_Count = 0;
+			}
+			break;
+			
+		case BUTTON_STATE_PRESSED:
+			if (Events & BUTTON_EVENT_RELEASED)
+			{
+				Button_State = BUTTON_STATE_WAITING_SECOND_PRESS;
+				Button_State_Ticks_Count = 0;
+			}
+			else if (Button_State_Ticks_Count >= BUTTON_LONG_PRESS_TICKS)
+			{
+				Events |= BUTTON_EVENT_LONG_PRESSED;
+				Button_State = BUTTON_STATE_WAITING_RELEASE;
+			}
+			break;
+			
+		case BUTTON_STATE_WAITING_SECOND_PRESS:
+			if (Events & BUTTON_EVENT_PRESSED)
+			{
+				Events |= BUTTON_EVENT_DOUBLE_CLICKED;
+				Button_State = BUTTON_STATE_WAITING_RELEASE;
+			}
+			else if (Button_State_Ticks_Count >= BUTTON_DOUBLE_CLICK_TICKS)
+			{
+				Events |= BUTTON_EVENT_CLICKED;
+				Button_State = BUTTON_STATE_RELEASED;
+			}
+			break;
+			
+		default:
+			if (Events & BUTTON_EVENT_RELEASED) Button_State = BUTTON_STATE_RELEASED;
+			break;
+	}
+	
+	return Events;
+}
+
+void ButtonSetLowPowerMode(unsigned char Is_Low_Power_Enabled)
+{
+	// Wake the system up on the next press
+	if (Is_Low_Power_Enabled)
+	{
+		intcon.INT0IF = 0; // The flag may have been set by previous presses
+		intcon.INT0IE = 1;
+	}
+	// Ignore the press that woke the system up
+	else
+	{
+		intcon.INT0IE = 0;
+		intcon.INT0IF = 0;
+		
+		Button_Is_Pushed = 1;
+		Button_Debounce_Ticks_Count = 0;
+		Button_State = BUTTON_STATE_WAITING_RELEASE;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+/** @file Button.h
+ * Debounce the button and recognize the gestures the user makes with it, without blocking the main loop.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#ifndef H_BUTTON_H
+#define H_BUTTON_H
+
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+// The events returned by ButtonProcessTick() (several ones can be returned by the same tick)
+/** The debounced button has been pushed. */
+#define BUTTON_EVENT_PRESSED 0x01
+/** The debounced button has been released. */
+#define BUTTON_EVENT_RELEASED 0x02
+/** A short press has been released and no second press followed it. */
+#define BUTTON_EVENT_CLICKED 0x04
+/** A second press quickly followed a short press. */
+#define BUTTON_EVENT_DOUBLE_CLICKED 0x08
+/** The button has been held for a while, it is still pushed. */
+#define BUTTON_EVENT_LONG_PRESSED 0x10
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Configure the button pin as a digital input. */
+void ButtonInitialize(void);
+
+/** Sample the button pin and advance the debouncing and gestures state machine.
+ * @return The events that occurred during this tick (a combination of BUTTON_EVENT_xxx flags), 0 if nothing happened.
+ * @note This function must be called every 8.192ms (the Timer 0 screen refresh interrupt period), all timings are expressed in ticks of this period.
+ */
+unsigned char ButtonProcessTick(void);
+
+/** Make the button wake the system up from low power mode.
+ * @param Is_Low_Power_Enabled Set to 1 to enable the button interrupt, so a press wakes the core up, or to 0 to disable it when the system is awoken. In the latter case the waking press is ignored until the button is released, so it does not make a gesture.
+ * @note The button interrupt is never handled by the interrupt handler, it is only used as a wake-up source.
+ */
+void ButtonSetLowPowerMode(unsigned char Is_Low_Power_Enabled);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+/** @file CRC.c
+ * @see CRC.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "CRC.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+/** The CRC-8 generator polynomial (x^8 + x^2 + x + 1). */
+#define CRC_POLYNOMIAL 0x07
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+unsigned char CRCUpdate(unsigned char CRC, unsigned char Byte)
+{
+	unsigned char i;
+	
+	CRC ^= Byte;
+	for (i = 0; i < 8; i++)
+	{
+		if (CRC & 0x80) CRC = (CRC << 1) ^ CRC_POLYNOMIAL;
+		else CRC <<= 1;
+	}
+	return CRC;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+/** @file CRC.h
+ * Compute the CRC-8 (polynomial x^8 + x^2 + x + 1) protecting the data EEPROM records and the telemetry frames.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#ifndef H_CRC_H
+#define H_CRC_H
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Add a byte to a CRC-8.
+ * @param CRC The CRC of the previous bytes (the initial value is chosen by the caller).
+ * @param Byte The byte to add.
+ * @return The new CRC.
+ */
+unsigned char CRCUpdate(unsigned char CRC, unsigned char Byte);
+
+#endif
\ No newline at end of file
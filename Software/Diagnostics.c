@@ -0,0 +1,215 @@
+/** @file Diagnostics.c
+ * @see Diagnostics.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "Diagnostics.h"
+
+#if DIAGNOSTICS_IS_ENABLED
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+/** Timer 1 configuration : clocked by the instruction clock without prescaler, 16-bit read mode so the counter is read atomically, timer started. */
+#define DIAGNOSTICS_TIMER_CONFIGURATION 0x81
+
+/** The servicing times average gives a weight of 1 / 2^DIAGNOSTICS_AVERAGE_SHIFT to the newest time. */
+#define DIAGNOSTICS_AVERAGE_SHIFT 4
+/** The longest servicing time the average can hold in 16 bits, longer times are saturated (they are kept by the maximum). */
+#define DIAGNOSTICS_AVERAGE_MAXIMUM_CYCLES (0xFFFF >> DIAGNOSTICS_AVERAGE_SHIFT)
+
+//--------------------------------------------------------------------------------------------------
+// Private types
+//--------------------------------------------------------------------------------------------------
+/** The measurements of an interrupt source. */
+typedef struct
+{
+	unsigned long Count; //!< How many times the source was serviced.
+	unsigned short Average_Cycles; //!< The exponential moving average of the servicing times, in 1 / 2^DIAGNOSTICS_AVERAGE_SHIFT instruction cycles.
+	unsigned short Maximum_Cycles; //!< The longest servicing time in instruction cycles.
+} TDiagnosticsInterruptStatistics;
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The measurements of each interrupt source. */
+static TDiagnosticsInterruptStatistics Diagnostics_Interrupt_Statistics[DIAGNOSTICS_SOURCES_COUNT];
+
+/** The deepest return address stack level seen. */
+static unsigned char Diagnostics_Stack_Depth;
+
+/** The minutes spent running (index 0) and in low power mode (index 1). */
+static unsigned long Diagnostics_Power_Mode_Minutes_Counts[2];
+
+/** How many times each source woke the system up. */
+static unsigned long Diagnostics_Wake_Ups_Counts[DIAGNOSTICS_WAKE_UP_SOURCES_COUNT];
+
+/** Tell whether the system is in low power mode. */
+static unsigned char Diagnostics_Is_Low_Power_Enabled = 0;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Read the free-running timer, the code is copied in the functions of each interrupt priority.
+ * @return The timer value.
+ */
+inline unsigned short DiagnosticsReadTimer(void)
+{
+	unsigned short Time;
+	
+	// Reading the low byte latches the high byte
+	Time = tmr1l;
+	Time |= (unsigned short) tmr1h << 8;
+	return Time;
+}
+
+/** Read the free-running timer from the low priority interrupt handler.
+ * @return The timer value.
+ */
+inline unsigned short DiagnosticsReadTimerFromLowPriority(void)
+{
+	unsigned short Time;
+	
+	// A high priority interrupt reading the timer between the two bytes reads would latch a newer high byte, so it is masked during a few cycles
+	intcon.GIEH = 0;
+	Time = DiagnosticsReadTimer();
+	intcon.GIEH = 1;
+	return Time;
+}
+
+/** Account an interrupt handler branch and sample the stack depth, the code is copied in the functions of each interrupt priority.
+ * @param Source The serviced interrupt source.
+ * @param Cycles How many instruction cycles the branch lasted.
+ * @param Is_Low_Priority Set to 1 when called from the low priority interrupt handler.
+ */
+inline void DiagnosticsCountInterrupt(TDiagnosticsSource Source, unsigned short Cycles, unsigned char Is_Low_Priority)
+{
+	TDiagnosticsInterruptStatistics *Pointer_Statistics = &Diagnostics_Interrupt_Statistics[Source];
+	unsigned char Depth;
+	
+	Pointer_Statistics->Count++;
+	if (Cycles > Pointer_Statistics->Maximum_Cycles) Pointer_Statistics->Maximum_Cycles = Cycles;
+	
+	// Average the servicing times with shifts only, the first servicing time initializing the average
+	if (Cycles > DIAGNOSTICS_AVERAGE_MAXIMUM_CYCLES) Cycles = DIAGNOSTICS_AVERAGE_MAXIMUM_CYCLES;
+	if (Pointer_Statistics->Count == 1) Pointer_Statistics->Average_Cycles = Cycles << DIAGNOSTICS_AVERAGE_SHIFT;
+	else Pointer_Statistics->Average_Cycles += Cycles - (Pointer_Statistics->Average_Cycles >> DIAGNOSTICS_AVERAGE_SHIFT);
+	
+	// The handlers preempt the code at random places, so the depth seen here includes the deepest calls of the preempted code over time (the functions called by the handler branch have returned, STKFUL catches them if they overflow)
+	// A high priority interrupt sampling a deeper level between the comparison and the write would be overwritten, so it is masked during a few cycles
+	if (Is_Low_Priority) intcon.GIEH = 0;
+	Depth = stkptr & 0x1F;
+	if (Depth > Diagnostics_Stack_Depth) Diagnostics_Stack_Depth = Depth;
+	if (Is_Low_Priority) intcon.GIEH = 1;
+}
+
+/** Compute a measurement from the variables the interrupt handlers update.
+ * @param Value_Index Which value to compute (see TDiagnosticsValue).
+ * @return The value.
+ */
+static unsigned long DiagnosticsComputeValue(unsigned char Value_Index)
+{
+	TDiagnosticsInterruptStatistics *Pointer_Statistics = Diagnostics_Interrupt_Statistics;
+	
+	if (Value_Index == DIAGNOSTICS_VALUE_STACK_DEPTH)
+	{
+		if (stkptr.STKFUL) return DIAGNOSTICS_STACK_OVERFLOWED; // The hardware sets STKFUL on overflow even if no sample caught it
+		return Diagnostics_Stack_Depth;
+	}
+	if (Value_Index == DIAGNOSTICS_VALUE_RUNNING_MINUTES) return Diagnostics_Power_Mode_Minutes_Counts[0];
+	if (Value_Index == DIAGNOSTICS_VALUE_STANDBY_MINUTES) return Diagnostics_Power_Mode_Minutes_Counts[1];
+	if (Value_Index < DIAGNOSTICS_VALUE_INTERRUPTS) return Diagnostics_Wake_Ups_Counts[Value_Index - DIAGNOSTICS_VALUE_WAKE_UPS];
+	
+	// Find the interrupt source the value belongs to, each source having 3 values (there are at most 4 subtractions)
+	Value_Index -= DIAGNOSTICS_VALUE_INTERRUPTS;
+	while (Value_Index >= 3)
+	{
+		Value_Index -= 3;
+		Pointer_Statistics++;
+	}
+	
+	if (Value_Index == 0) return Pointer_Statistics->Count;
+	if (Value_Index == 1) return Pointer_Statistics->Average_Cycles >> DIAGNOSTICS_AVERAGE_SHIFT;
+	return Pointer_Statistics->Maximum_Cycles;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void DiagnosticsInitialize(void)
+{
+	t1con = DIAGNOSTICS_TIMER_CONFIGURATION; // The timer overflow interrupt is not used, the servicing times being far shorter than the timer period
+	DiagnosticsReset();
+}
+
+void DiagnosticsReset(void)
+{
+	unsigned char i;
+	
+	// An interrupt handler may update a measurement while it is cleared, the value is only off by one servicing
+	for (i = 0; i < DIAGNOSTICS_SOURCES_COUNT; i++)
+	{
+		Diagnostics_Interrupt_Statistics[i].Count = 0;
+		Diagnostics_Interrupt_Statistics[i].Average_Cycles = 0;
+		Diagnostics_Interrupt_Statistics[i].Maximum_Cycles = 0;
+	}
+	for (i = 0; i < DIAGNOSTICS_WAKE_UP_SOURCES_COUNT; i++) Diagnostics_Wake_Ups_Counts[i] = 0;
+	Diagnostics_Power_Mode_Minutes_Counts[0] = 0;
+	Diagnostics_Power_Mode_Minutes_Counts[1] = 0;
+	Diagnostics_Stack_Depth = 0;
+	stkptr.STKFUL = 0;
+}
+
+unsigned short DiagnosticsStartHighPriorityInterrupt(void)
+{
+	return DiagnosticsReadTimer();
+}
+
+void DiagnosticsStopHighPriorityInterrupt(TDiagnosticsSource Source, unsigned short Start_Time)
+{
+	DiagnosticsCountInterrupt(Source, DiagnosticsReadTimer() - Start_Time, 0);
+}
+
+unsigned short DiagnosticsStartLowPriorityInterrupt(void)
+{
+	return DiagnosticsReadTimerFromLowPriority();
+}
+
+void DiagnosticsStopLowPriorityInterrupt(TDiagnosticsSource Source, unsigned short Start_Time)
+{
+	DiagnosticsCountInterrupt(Source, DiagnosticsReadTimerFromLowPriority() - Start_Time, 1);
+}
+
+void DiagnosticsCountMinute(void)
+{
+	Diagnostics_Power_Mode_Minutes_Counts[Diagnostics_Is_Low_Power_Enabled]++;
+}
+
+void DiagnosticsCountWakeUp(TDiagnosticsWakeUpSource Source)
+{
+	Diagnostics_Wake_Ups_Counts[Source]++;
+}
+
+void DiagnosticsSetLowPowerMode(unsigned char Is_Low_Power_Enabled)
+{
+	Diagnostics_Is_Low_Power_Enabled = Is_Low_Power_Enabled;
+	
+	// Do not keep the timer running for nothing, the interrupt handlers are not called in low power mode
+	if (Is_Low_Power_Enabled) t1con = 0;
+	else t1con = DIAGNOSTICS_TIMER_CONFIGURATION;
+}
+
+unsigned long DiagnosticsReadValue(unsigned char Value_Index)
+{
+	unsigned long Value;
+	
+	// The multi-byte measurements can be updated by an interrupt handler while they are read, so read them until two reads match
+	do
+	{
+		Value = DiagnosticsComputeValue(Value_Index);
+	} while (Value != DiagnosticsComputeValue(Value_Index));
+	
+	return Value;
+}
+
+#endif
\ No newline at end of file
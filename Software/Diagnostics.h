@@ -0,0 +1,133 @@
+/** @file Diagnostics.h
+ * Profile the interrupt handlers and the power modes on the running board. Each interrupt handler branch is timed with Timer 1 free-running on the instruction clock, the return address stack depth is sampled at the end of each branch (STKFUL catching any overflow, the stack overflow reset being disabled), and the minutes and the wake-ups of each power mode are counted.
+ * The diagnostics are meant for debug builds only, they are compiled out of release builds (and they take Timer 1 and about 60 bytes of RAM).
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#ifndef H_DIAGNOSTICS_H
+#define H_DIAGNOSTICS_H
+
+#include "Telemetry.h"
+
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+#ifndef DIAGNOSTICS_IS_ENABLED
+	/** Set to 1 to build the diagnostics and their hidden display page in, they are enabled in debug builds and compiled out when _RELEASE is defined. */
+	#ifdef _RELEASE
+		#define DIAGNOSTICS_IS_ENABLED 0
+	#else
+		#define DIAGNOSTICS_IS_ENABLED 1
+	#endif
+#endif
+
+/** The value read when the return address stack overflowed. */
+#define DIAGNOSTICS_STACK_OVERFLOWED 0xFFFFFFFF
+
+#if DIAGNOSTICS_IS_ENABLED
+	/** Start timing a high priority interrupt handler branch, it must be the first statement of the branch block. */
+	#define DIAGNOSTICS_START_HIGH_PRIORITY_INTERRUPT() unsigned short Diagnostics_Interrupt_Start_Time = DiagnosticsStartHighPriorityInterrupt()
+	/** Stop timing a high priority interrupt handler branch.
+	 * @param Source The interrupt source the branch serviced.
+	 */
+	#define DIAGNOSTICS_STOP_HIGH_PRIORITY_INTERRUPT(Source) DiagnosticsStopHighPriorityInterrupt(Source, Diagnostics_Interrupt_Start_Time)
+	/** Start timing a low priority interrupt handler branch, it must be the first statement of the branch block. */
+	#define DIAGNOSTICS_START_LOW_PRIORITY_INTERRUPT() unsigned short Diagnostics_Interrupt_Start_Time = DiagnosticsStartLowPriorityInterrupt()
+	/** Stop timing a low priority interrupt handler branch.
+	 * @param Source The interrupt source the branch serviced.
+	 */
+	#define DIAGNOSTICS_STOP_LOW_PRIORITY_INTERRUPT(Source) DiagnosticsStopLowPriorityInterrupt(Source, Diagnostics_Interrupt_Start_Time)
+#else
+	#define DIAGNOSTICS_START_HIGH_PRIORITY_INTERRUPT()
+	#define DIAGNOSTICS_STOP_HIGH_PRIORITY_INTERRUPT(Source)
+	#define DIAGNOSTICS_START_LOW_PRIORITY_INTERRUPT()
+	#define DIAGNOSTICS_STOP_LOW_PRIORITY_INTERRUPT(Source)
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** All profiled interrupt sources. */
+typedef enum
+{
+	DIAGNOSTICS_SOURCE_SCREEN_REFRESH, //!< Timer 0, the high priority tick.
+	DIAGNOSTICS_SOURCE_SCREEN_BLANKING, //!< Timer 3, the high priority brightness lowering.
+	DIAGNOSTICS_SOURCE_SOFTWARE_TIMERS, //!< Timer 2, the low priority tick.
+	DIAGNOSTICS_SOURCE_ADC, //!< The conversions end.
+#if TELEMETRY_IS_ENABLED
+	DIAGNOSTICS_SOURCE_TELEMETRY, //!< The EUSART transmit register being empty.
+#endif
+	DIAGNOSTICS_SOURCES_COUNT
+} TDiagnosticsSource;
+
+/** What can wake the system up from low power mode. */
+typedef enum
+{
+	DIAGNOSTICS_WAKE_UP_SOURCE_TIMER, //!< The watchdog timer, or Timer 1 in RC_IDLE mode.
+	DIAGNOSTICS_WAKE_UP_SOURCE_BUTTON, //!< INT0, the system leaves low power mode.
+	DIAGNOSTICS_WAKE_UP_SOURCES_COUNT
+} TDiagnosticsWakeUpSource;
+
+/** All values that can be read. */
+typedef enum
+{
+	DIAGNOSTICS_VALUE_STACK_DEPTH, //!< The deepest return address stack level seen (out of 31), or DIAGNOSTICS_STACK_OVERFLOWED.
+	DIAGNOSTICS_VALUE_RUNNING_MINUTES, //!< How many minutes the system spent running.
+	DIAGNOSTICS_VALUE_STANDBY_MINUTES, //!< How many minutes the system spent in low power mode.
+	DIAGNOSTICS_VALUE_WAKE_UPS, //!< How many times each wake-up source woke the system up, in TDiagnosticsWakeUpSource order.
+	DIAGNOSTICS_VALUE_INTERRUPTS = DIAGNOSTICS_VALUE_WAKE_UPS + DIAGNOSTICS_WAKE_UP_SOURCES_COUNT, //!< Then, for each interrupt source in TDiagnosticsSource order : how many times it was serviced, its average and its maximum servicing time in instruction cycles.
+	DIAGNOSTICS_VALUES_COUNT = DIAGNOSTICS_VALUE_INTERRUPTS + 3 * DIAGNOSTICS_SOURCES_COUNT
+} TDiagnosticsValue;
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Start Timer 1 free-running on the instruction clock and clear all measurements. */
+void DiagnosticsInitialize(void);
+
+/** Clear all measurements. */
+void DiagnosticsReset(void);
+
+/** Read the free-running timer when a high priority interrupt handler branch starts, use DIAGNOSTICS_START_HIGH_PRIORITY_INTERRUPT() instead.
+ * @return The timer value.
+ * @note BoostC functions are not reentrant, so each interrupt priority has its own functions.
+ */
+unsigned short DiagnosticsStartHighPriorityInterrupt(void);
+
+/** Account a high priority interrupt handler branch and sample the stack depth, use DIAGNOSTICS_STOP_HIGH_PRIORITY_INTERRUPT() instead.
+ * @param Source The serviced interrupt source.
+ * @param Start_Time The free-running timer value when the branch started.
+ */
+void DiagnosticsStopHighPriorityInterrupt(TDiagnosticsSource Source, unsigned short Start_Time);
+
+/** Read the free-running timer when a low priority interrupt handler branch starts, use DIAGNOSTICS_START_LOW_PRIORITY_INTERRUPT() instead.
+ * @return The timer value.
+ */
+unsigned short DiagnosticsStartLowPriorityInterrupt(void);
+
+/** Account a low priority interrupt handler branch and sample the stack depth, use DIAGNOSTICS_STOP_LOW_PRIORITY_INTERRUPT() instead.
+ * @param Source The serviced interrupt source.
+ * @param Start_Time The free-running timer value when the branch started.
+ */
+void DiagnosticsStopLowPriorityInterrupt(TDiagnosticsSource Source, unsigned short Start_Time);
+
+/** Account a minute in the current power mode (called each minute while running and each time the wake-up timer elapses in low power mode). */
+void DiagnosticsCountMinute(void);
+
+/** Account a system wake-up.
+ * @param Source What woke the system up.
+ */
+void DiagnosticsCountWakeUp(TDiagnosticsWakeUpSource Source);
+
+/** Stop the free-running timer in low power mode, and restart it when the system is woken up (the RC_IDLE wake-up timer uses Timer 1 too).
+ * @param Is_Low_Power_Enabled Set to 1 when the system enters low power mode, set to 0 when the system is woken up.
+ */
+void DiagnosticsSetLowPowerMode(unsigned char Is_Low_Power_Enabled);
+
+/** Read a measurement.
+ * @param Value_Index Which value to read (see TDiagnosticsValue).
+ * @return The value.
+ */
+unsigned long DiagnosticsReadValue(unsigned char Value_Index);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,169 @@
+/** @file EEPROM.c
+ * @see EEPROM.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "CRC.h"
+#include "EEPROM.h"
+#include "Processor.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+/** The sequence number value that an erased slot holds, it is never used by a record so a blank EEPROM has no valid slot. */
+#define EEPROM_ERASED_SEQUENCE 0xFF
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** Where the next record will be written. */
+static unsigned char EEPROM_Next_Slot_Address = 0;
+
+/** The next record sequence number. */
+static unsigned char EEPROM_Next_Sequence = 0;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Tell whether a slot holds a complete record.
+ * @param Address The slot address.
+ * @param Size The record size in bytes.
+ * @return 1 if the slot is valid,
+ * @return 0 if the slot is erased or corrupted.
+ */
+static unsigned char EEPROMIsSlotValid(unsigned char Address, unsigned char Size)
+{
+	unsigned char CRC, i, Byte;
+	
+	Byte = EEPROMReadByte(Address);
+	if (Byte == EEPROM_ERASED_SEQUENCE) return 0;
+	
+	// The record size is the CRC initial value, so the records written with another size are not valid
+	CRC = CRCUpdate(Size, Byte);
+	for (i = 0; i < Size; i++)
+	{
+		Address++;
+		CRC = CRCUpdate(CRC, EEPROMReadByte(Address));
+	}
+	
+	if (EEPROMReadByte(Address + 1) == CRC) return 1;
+	return 0;
+}
+
+/** Select the slot following the last written one, and the sequence number following the last written one.
+ * @param Slot_Size The slot size in bytes.
+ */
+static void EEPROMGoToNextSlot(unsigned char Slot_Size)
+{
+	if (EEPROM_Next_Sequence == EEPROM_ERASED_SEQUENCE - 1) EEPROM_Next_Sequence = 0;
+	else EEPROM_Next_Sequence++;
+	
+	// Wrap around when the next slot does not fit in the area
+	if ((unsigned short) EEPROM_Next_Slot_Address + 2 * Slot_Size <= EEPROM_RECORDS_AREA_SIZE) EEPROM_Next_Slot_Address += Slot_Size;
+	else EEPROM_Next_Slot_Address = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+unsigned char EEPROMReadByte(unsigned char Address)
+{
+	eeadr = Address;
+	eecon1 = 0; // Access the data EEPROM
+	eecon1.RD = 1;
+	return eedata;
+}
+
+void EEPROMWriteByte(unsigned char Address, unsigned char Value)
+{
+	unsigned char Is_Low_Priority_Interrupt_Enabled, Is_High_Priority_Interrupt_Enabled;
+	
+	// Spare the write energy and the cell wear
+	if (EEPROMReadByte(Address) == Value) return;
+	
+	// The write end interrupt wakes the idle core up, the low priority interrupt handler disables it and leaves its flag set
+	ipr2.EEIP = 0;
+	pir2.EEIF = 0;
+	pie2.EEIE = 1;
+	
+	eedata = Value;
+	eecon1 = 0x04; // Access the data EEPROM, allow writes
+	
+	// The unlock sequence must not be interrupted, even by the screen refresh
+	Is_High_Priority_Interrupt_Enabled = intcon.GIEH;
+	intcon.GIEH = 0;
+	eecon2 = 0x55;
+	eecon2 = 0xAA;
+	eecon1.WR = 1;
+	intcon.GIEH = Is_High_Priority_Interrupt_Enabled;
+	eecon1.WREN = 0; // The started write is not affected
+	
+	// Only mask the low priority interrupts between the write end check and the core stop, so they are still served during the write
+	Is_Low_Priority_Interrupt_Enabled = intcon.GIEL;
+	intcon.GIEL = 0;
+	while (!pir2.EEIF)
+	{
+		ProcessorWaitForInterrupt();
+		
+		// Let the interrupt handler serve the interrupt which woke the core up
+		intcon.GIEL = Is_Low_Priority_Interrupt_Enabled;
+		intcon.GIEL = 0;
+	}
+	
+	pie2.EEIE = 0;
+	pir2.EEIF = 0;
+	intcon.GIEL = Is_Low_Priority_Interrupt_Enabled;
+}
+
+unsigned char EEPROMReadRecord(unsigned char *Pointer_Data, unsigned char Size)
+{
+	unsigned short Address;
+	unsigned char Slot_Size = Size + 2, Is_Found = 0, Newest_Address = 0, Newest_Sequence = 0, Sequence, Age, i;
+	
+	// Find the newest valid slot, the sequence numbers wrap around after 254 as the erased value is skipped
+	for (Address = 0; Address + Slot_Size <= EEPROM_RECORDS_AREA_SIZE; Address += Slot_Size)
+	{
+		if (!EEPROMIsSlotValid((unsigned char) Address, Size)) continue;
+		
+		Sequence = EEPROMReadByte((unsigned char) Address);
+		if (Is_Found)
+		{
+			// The slots sequence numbers are close to each other as there are less than 127 slots, so a small difference tells that the slot is newer
+			Age = Sequence - Newest_Sequence;
+			if (Sequence < Newest_Sequence) Age--;
+			if ((Age == 0) || (Age >= 128)) continue;
+		}
+		
+		Newest_Address = (unsigned char) Address;
+		Newest_Sequence = Sequence;
+		Is_Found = 1;
+	}
+	if (!Is_Found) return 1;
+	
+	for (i = 0; i < Size; i++) Pointer_Data[i] = EEPROMReadByte(Newest_Address + 1 + i);
+	
+	// Keep writing after the newest slot
+	EEPROM_Next_Slot_Address = Newest_Address;
+	EEPROM_Next_Sequence = Newest_Sequence;
+	EEPROMGoToNextSlot(Slot_Size);
+	
+	return 0;
+}
+
+void EEPROMWriteRecord(unsigned char *Pointer_Data, unsigned char Size)
+{
+	unsigned char Address = EEPROM_Next_Slot_Address, CRC, i;
+	
+	// Write the CRC last, so a reset during the write leaves an invalid slot and the previous record is still found
+	EEPROMWriteByte(Address, EEPROM_Next_Sequence);
+	CRC = CRCUpdate(Size, EEPROM_Next_Sequence);
+	for (i = 0; i < Size; i++)
+	{
+		Address++;
+		EEPROMWriteByte(Address, Pointer_Data[i]);
+		CRC = CRCUpdate(CRC, Pointer_Data[i]);
+	}
+	EEPROMWriteByte(Address + 1, CRC);
+	
+	EEPROMGoToNextSlot(Size + 2);
+}
\ No newline at end of file
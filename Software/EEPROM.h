@@ -0,0 +1,52 @@
+/** @file EEPROM.h
+ * Access the data EEPROM bytes, and keep a record in the data EEPROM across resets. Each record write goes to the next slot of a ring, so the writes are spread over all the ring cells. A slot holds a sequence number, the record data and a CRC, so the newest complete record can be found at boot even if a write was interrupted by a reset.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#ifndef H_EEPROM_H
+#define H_EEPROM_H
+
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+/** The data EEPROM size in bytes. */
+#define EEPROM_SIZE 256
+
+#ifndef EEPROM_RECORDS_AREA_SIZE
+	/** How many bytes of the data EEPROM the records ring uses, starting from address 0 (the value must be in range [record size + 2..255]). The more slots fit, the less each cell is written. The following bytes are left to the other modules. */
+	#define EEPROM_RECORDS_AREA_SIZE 128
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Read a byte from the data EEPROM.
+ * @param Address The byte address.
+ * @return The byte value.
+ */
+unsigned char EEPROMReadByte(unsigned char Address);
+
+/** Write a byte to the data EEPROM if it does not already hold this value, keeping the core idle until the write is terminated.
+ * @param Address The byte address.
+ * @param Value The byte value.
+ * @note A write lasts up to 4ms, the interrupts are served meanwhile. The low priority interrupt handler must disable the write end interrupt (EEIE) without clearing its flag.
+ */
+void EEPROMWriteByte(unsigned char Address, unsigned char Value);
+
+/** Find the newest valid record and read it. The next write will go to the following slot.
+ * @param Pointer_Data On output, contain the record data. The buffer is left untouched if no valid record is found.
+ * @param Size The record size in bytes, it must be the same for all reads and writes.
+ * @return 0 if a record was read,
+ * @return 1 if no valid record was found (the EEPROM is blank, or the record size changed).
+ * @note This function must be called once before the first write.
+ */
+unsigned char EEPROMReadRecord(unsigned char *Pointer_Data, unsigned char Size);
+
+/** Write a record to the next slot of the ring. The core is kept idle during each byte write, the bytes whose value is already stored are not written.
+ * @param Pointer_Data The record data.
+ * @param Size The record size in bytes.
+ * @note A write lasts up to 4ms per byte, the interrupts are served meanwhile.
+ */
+void EEPROMWriteRecord(unsigned char *Pointer_Data, unsigned char Size);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,246 @@
+/** @file Energy.c
+ * @see Energy.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "ADC.h"
+#include "Energy.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+/** The charges are accounted in 2^ENERGY_CHARGE_UNIT_SHIFT uAs units, so 32 bits hold more than 19Ah. */
+#define ENERGY_CHARGE_UNIT_SHIFT 4
+/** How many uA.ms make a charge unit. */
+#define ENERGY_CHARGE_UNIT_MICROAMPERE_MILLISECONDS (1000UL << ENERGY_CHARGE_UNIT_SHIFT)
+/** The battery capacity in charge units (a mAh lasts 3600000uAs). */
+#define ENERGY_BATTERY_CHARGE (ENERGY_BATTERY_CAPACITY * (3600000UL >> ENERGY_CHARGE_UNIT_SHIFT))
+
+/** The data EEPROM keeps the charges upper 16 bits (2^20uAs steps, about 0.29mAh). */
+#define ENERGY_STATE_CHARGE_SHIFT 16
+/** The data EEPROM keeps the elapsed time in 2^12s steps (about 68 minutes). */
+#define ENERGY_STATE_TIME_SHIFT 12
+
+/** The average charge is computed over 2^ENERGY_RUNTIME_TIME_SHIFT seconds units (64s). */
+#define ENERGY_RUNTIME_TIME_SHIFT 6
+/** How many time units last one day. */
+#define ENERGY_RUNTIME_DAY_UNITS (86400 >> ENERGY_RUNTIME_TIME_SHIFT)
+
+#if ENERGY_BATTERY_FULL_VOLTAGE <= ADC_BATTERY_LOW_VOLTAGE
+	#error "ENERGY_BATTERY_FULL_VOLTAGE must be greater than ADC_BATTERY_LOW_VOLTAGE."
+#endif
+
+/** The battery voltage conversion result corresponding to ENERGY_BATTERY_FULL_VOLTAGE. */
+#define ENERGY_BATTERY_FULL_VOLTAGE_VALUE ((unsigned short) (1024UL * 1023 / ENERGY_BATTERY_FULL_VOLTAGE))
+/** The charge left per battery voltage conversion result step above ADC_BATTERY_LOW_VOLTAGE_VALUE (the result is the inverse of the voltage, which is nearly linear over this small range). */
+#define ENERGY_BATTERY_CHARGE_PER_VOLTAGE_STEP (ENERGY_BATTERY_CHARGE / (ADC_BATTERY_LOW_VOLTAGE_VALUE - ENERGY_BATTERY_FULL_VOLTAGE_VALUE))
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The running seconds counted by the interrupt handler since the last accounting. */
+static volatile unsigned char Energy_Running_Seconds_Count = 0;
+
+/** The display loads summed by the interrupt handler since the last accounting. */
+static volatile unsigned short Energy_Display_Load_Sum = 0;
+
+/** The lit leds seconds counted by the interrupt handler since the last accounting. */
+static volatile unsigned short Energy_Lit_Leds_Seconds_Count = 0;
+
+/** The measurements started since the last accounting. */
+static volatile unsigned char Energy_Measurements_Count = 0;
+
+/** The measurements charge not yet accounted because it is smaller than a charge unit, in uA.ms. */
+static unsigned short Energy_Measurements_Pending_Charge = 0;
+
+/** The charge drawn by each power state, in charge units. */
+static unsigned long Energy_Consumed_Charges[ENERGY_CONSUMERS_COUNT];
+
+/** How many seconds the battery has been used. */
+static unsigned long Energy_Elapsed_Seconds = 0;
+
+/** Tell whether the system is in low power mode. */
+static unsigned char Energy_Is_Low_Power_Enabled = 0;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Account a charge to a power state.
+ * @param Consumer The power state.
+ * @param Charge The charge in uAs.
+ * @return 1 if the charge kept in the data EEPROM changed,
+ * @return 0 if it did not.
+ */
+static unsigned char EnergyAddCharge(TEnergyConsumer Consumer, unsigned long Charge)
+{
+	unsigned long Previous_Charge;
+	
+	Previous_Charge = Energy_Consumed_Charges[Consumer];
+	Energy_Consumed_Charges[Consumer] += Charge >> ENERGY_CHARGE_UNIT_SHIFT;
+	
+	if ((Previous_Charge ^ Energy_Consumed_Charges[Consumer]) >> ENERGY_STATE_CHARGE_SHIFT) return 1;
+	return 0;
+}
+
+/** Divide with shifts and subtractions, the loops lasting as many iterations as the quotient has bits instead of the 32 iterations of a generic 32-bit division.
+ * @param Dividend The value to divide.
+ * @param Divisor The value to divide by, it must not be zero.
+ * @return The quotient.
+ */
+static unsigned long EnergyDivide(unsigned long Dividend, unsigned long Divisor)
+{
+	unsigned long Quotient = 0, Quotient_Bit = 1;
+	
+	// Align the divisor on the dividend most significant bit
+	while ((Divisor < Dividend) && !(Divisor & 0x80000000))
+	{
+		Divisor <<= 1;
+		Quotient_Bit <<= 1;
+	}
+	
+	// Subtract the shifted divisor each time it fits, from the most significant quotient bit
+	while (Quotient_Bit != 0)
+	{
+		if (Dividend >= Divisor)
+		{
+			Dividend -= Divisor;
+			Quotient |= Quotient_Bit;
+		}
+		Divisor >>= 1;
+		Quotient_Bit >>= 1;
+	}
+	return Quotient;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void EnergyCountSecond(unsigned char Display_Load, unsigned char Lit_Leds_Count)
+{
+	Energy_Running_Seconds_Count++;
+	Energy_Display_Load_Sum += Display_Load;
+	Energy_Lit_Leds_Seconds_Count += Lit_Leds_Count;
+}
+
+void EnergyCountMeasurement(void)
+{
+	Energy_Measurements_Count++;
+}
+
+unsigned char EnergyCountMinute(void)
+{
+	unsigned char Running_Seconds_Count, Measurements_Count, Is_State_Modified, Is_Low_Priority_Interrupt_Enabled;
+	unsigned short Display_Load_Sum, Lit_Leds_Seconds_Count;
+	unsigned long Charge;
+	
+	// Take the counts of the interrupt handler, the computations are done with the interrupts enabled (the caller may have masked them, like the standby loop does)
+	Is_Low_Priority_Interrupt_Enabled = intcon.GIEL;
+	intcon.GIEL = 0;
+	Running_Seconds_Count = Energy_Running_Seconds_Count;
+	Energy_Running_Seconds_Count = 0;
+	Display_Load_Sum = Energy_Display_Load_Sum;
+	Energy_Display_Load_Sum = 0;
+	Lit_Leds_Seconds_Count = Energy_Lit_Leds_Seconds_Count;
+	Energy_Lit_Leds_Seconds_Count = 0;
+	Measurements_Count = Energy_Measurements_Count;
+	Energy_Measurements_Count = 0;
+	intcon.GIEL = Is_Low_Priority_Interrupt_Enabled;
+	
+	Is_State_Modified = EnergyAddCharge(ENERGY_CONSUMER_RUNNING, (unsigned long) Running_Seconds_Count * ENERGY_CURRENT_RUNNING);
+	Energy_Elapsed_Seconds += Running_Seconds_Count;
+	
+	// The load is counted in eighths of the brightest level, each display being lit half of the time
+	Charge = (((unsigned long) Display_Load_Sum * ENERGY_CURRENT_SEGMENT) >> 4) + (unsigned long) Lit_Leds_Seconds_Count * ENERGY_CURRENT_LED;
+	Is_State_Modified |= EnergyAddCharge(ENERGY_CONSUMER_DISPLAY, Charge);
+	
+	// Keep the measurements charge remainder, a measurement being far smaller than a charge unit (a minute of measurements makes a few units at most, so they are subtracted instead of divided)
+	Charge = Energy_Measurements_Pending_Charge + (unsigned long) Measurements_Count * ENERGY_CHARGE_MEASUREMENT;
+	while (Charge >= ENERGY_CHARGE_UNIT_MICROAMPERE_MILLISECONDS)
+	{
+		Charge -= ENERGY_CHARGE_UNIT_MICROAMPERE_MILLISECONDS;
+		Energy_Consumed_Charges[ENERGY_CONSUMER_MEASUREMENTS]++;
+	}
+	Energy_Measurements_Pending_Charge = (unsigned short) Charge;
+	
+	// Each wake-up timer period is spent in standby, the running seconds before entering low power mode being counted by the interrupt handler
+	if (Energy_Is_Low_Power_Enabled)
+	{
+		Is_State_Modified |= EnergyAddCharge(ENERGY_CONSUMER_STANDBY, (unsigned long) PROCESSOR_WAKE_UP_PERIOD * ENERGY_CURRENT_STANDBY);
+		Energy_Elapsed_Seconds += PROCESSOR_WAKE_UP_PERIOD;
+	}
+	
+	return Is_State_Modified;
+}
+
+void EnergyGetState(TEnergyState *Pointer_State)
+{
+	unsigned char i;
+	
+	for (i = 0; i < ENERGY_CONSUMERS_COUNT; i++) Pointer_State->Consumed_Charges[i] = Energy_Consumed_Charges[i] >> ENERGY_STATE_CHARGE_SHIFT;
+	Pointer_State->Elapsed_Time = Energy_Elapsed_Seconds >> ENERGY_STATE_TIME_SHIFT;
+}
+
+void EnergySetState(TEnergyState *Pointer_State)
+{
+	unsigned char i;
+	
+	for (i = 0; i < ENERGY_CONSUMERS_COUNT; i++) Energy_Consumed_Charges[i] = (unsigned long) Pointer_State->Consumed_Charges[i] << ENERGY_STATE_CHARGE_SHIFT;
+	Energy_Elapsed_Seconds = (unsigned long) Pointer_State->Elapsed_Time << ENERGY_STATE_TIME_SHIFT;
+}
+
+void EnergyReset(void)
+{
+	unsigned char i;
+	
+	// The counts of the interrupt handler belong to the new battery
+	for (i = 0; i < ENERGY_CONSUMERS_COUNT; i++) Energy_Consumed_Charges[i] = 0;
+	Energy_Elapsed_Seconds = 0;
+}
+
+unsigned long EnergyReadConsumedCharge(TEnergyConsumer Consumer)
+{
+	return Energy_Consumed_Charges[Consumer];
+}
+
+unsigned long EnergyReadElapsedTime(void)
+{
+	return Energy_Elapsed_Seconds;
+}
+
+unsigned short EnergyComputeRemainingRuntime(void)
+{
+	unsigned long Consumed_Charge = 0, Remaining_Charge, Voltage_Remaining_Charge, Daily_Charge, Days;
+	unsigned short Voltage_Value;
+	unsigned char i;
+	
+	// The battery voltage tells better than the accounting that the battery is nearly empty
+	if (ADCIsBatteryLow()) return 0;
+	
+	for (i = 0; i < ENERGY_CONSUMERS_COUNT; i++) Consumed_Charge += Energy_Consumed_Charges[i];
+	if (Consumed_Charge >= ENERGY_BATTERY_CHARGE) return ENERGY_RUNTIME_UNKNOWN; // The battery is better than expected, or it was replaced without clearing the accounting
+	if (Energy_Elapsed_Seconds < 3600) return ENERGY_RUNTIME_UNKNOWN;
+	
+	// A battery weaker than its nominal capacity, or used before, shows a lower voltage than the accounting expects (no voltage has been measured yet when the value is zero)
+	Remaining_Charge = ENERGY_BATTERY_CHARGE - Consumed_Charge;
+	Voltage_Value = ADCReadBatteryVoltageValue();
+	if (Voltage_Value > ENERGY_BATTERY_FULL_VOLTAGE_VALUE)
+	{
+		Voltage_Remaining_Charge = (unsigned long) (ADC_BATTERY_LOW_VOLTAGE_VALUE - Voltage_Value) * ENERGY_BATTERY_CHARGE_PER_VOLTAGE_STEP;
+		if (Voltage_Remaining_Charge < Remaining_Charge) Remaining_Charge = Voltage_Remaining_Charge;
+	}
+	
+	// Compute the average charge drawn in one day, the product must fit in 32 bits
+	Daily_Charge = EnergyDivide(Consumed_Charge, Energy_Elapsed_Seconds >> ENERGY_RUNTIME_TIME_SHIFT);
+	if (Daily_Charge == 0) return ENERGY_RUNTIME_UNKNOWN;
+	if (Daily_Charge > 0xFFFFFFFF / ENERGY_RUNTIME_DAY_UNITS) return 0; // More than 795mA on average, the battery can't last one day
+	Daily_Charge *= ENERGY_RUNTIME_DAY_UNITS;
+	
+	Days = EnergyDivide(Remaining_Charge, Daily_Charge);
+	if (Days >= ENERGY_RUNTIME_UNKNOWN) return ENERGY_RUNTIME_UNKNOWN;
+	return (unsigned short) Days;
+}
+
+void EnergySetLowPowerMode(unsigned char Is_Low_Power_Enabled)
+{
+	Energy_Is_Low_Power_Enabled = Is_Low_Power_Enabled;
+}
\ No newline at end of file
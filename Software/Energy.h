@@ -0,0 +1,133 @@
+/** @file Energy.h
+ * Account the battery charge drawn by each power state, and estimate the remaining runtime. The interrupt handlers only count the residency of each state (the running seconds, the lit segments and leds seconds, the measurements), the counts are turned into charges once per minute by the main loop using the board current table.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#ifndef H_ENERGY_H
+#define H_ENERGY_H
+
+#include "Processor.h"
+#include "Temperature.h"
+
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+#ifndef ENERGY_BATTERY_CAPACITY
+	/** The charge a new battery can deliver, in mAh (the value must be in range [1..19000]). The default value is a conservative capacity for two AA alkaline cells. */
+	#define ENERGY_BATTERY_CAPACITY 2000
+#endif
+
+#ifndef ENERGY_BATTERY_FULL_VOLTAGE
+	/** The voltage of a new battery, in millivolts (it must be greater than ADC_BATTERY_LOW_VOLTAGE). The remaining runtime is bounded by the charge left between this voltage and ADC_BATTERY_LOW_VOLTAGE, so a battery weaker than ENERGY_BATTERY_CAPACITY is not overestimated. */
+	#define ENERGY_BATTERY_FULL_VOLTAGE 3200
+#endif
+
+#ifndef ENERGY_CURRENT_RUNNING
+	/** The average current drawn while the system is running, without the screen and the leds, in uA (the core switching between 31KHz and 1MHz, and the always powered temperature sensors). */
+	#define ENERGY_CURRENT_RUNNING 145
+#endif
+
+#ifndef ENERGY_CURRENT_SEGMENT
+	/** The current drawn by a lit segment while its display is enabled, in uA. */
+	#define ENERGY_CURRENT_SEGMENT 2000
+#endif
+
+#ifndef ENERGY_CURRENT_LED
+	/** The current drawn by a lit led, in uA. */
+	#define ENERGY_CURRENT_LED 2000
+#endif
+
+#ifndef ENERGY_CURRENT_STANDBY
+	/** The average current drawn in low power mode, in uA. */
+	#if PROCESSOR_IS_SLEEP_MODE_ENABLED
+		#define ENERGY_CURRENT_STANDBY 51
+	#else
+		#define ENERGY_CURRENT_STANDBY 62 // The core is idle at 31KHz
+	#endif
+#endif
+
+#ifndef ENERGY_CHARGE_MEASUREMENT
+	/** The charge drawn by a measurement (the Fixed Voltage Reference start-up and the conversions), in uA.ms. The reference is powered one tick before the conversions are queued while the system is running. */
+	#define ENERGY_CHARGE_MEASUREMENT 560
+#endif
+
+/** The remaining runtime value telling that it can't be estimated yet. */
+#define ENERGY_RUNTIME_UNKNOWN 0xFFFF
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** The power states the charge is accounted for. */
+typedef enum
+{
+	ENERGY_CONSUMER_RUNNING, //!< The system running, whatever the clock frequency.
+	ENERGY_CONSUMER_DISPLAY, //!< The lit segments and leds.
+	ENERGY_CONSUMER_STANDBY, //!< The system in low power mode (sleep or RC_IDLE).
+	ENERGY_CONSUMER_MEASUREMENTS, //!< The Fixed Voltage Reference and the ADC powered up.
+	ENERGY_CONSUMERS_COUNT
+} TEnergyConsumer;
+
+/** The accounting kept in the data EEPROM across resets. */
+typedef struct
+{
+	unsigned short Consumed_Charges[ENERGY_CONSUMERS_COUNT]; //!< The charge drawn by each power state since the battery was replaced, in steps of about 0.29mAh.
+	unsigned short Elapsed_Time; //!< How long the battery has been used, in steps of about 68 minutes.
+} TEnergyState;
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Account a running second.
+ * @param Display_Load The lit segments load returned by ScreenGetLitSegmentsLoad().
+ * @param Lit_Leds_Count How many leds are lit.
+ * @note This function must be called every second by the low priority interrupt handler.
+ */
+void EnergyCountSecond(unsigned char Display_Load, unsigned char Lit_Leds_Count);
+
+/** Account a measurement start, call it each time the analog modules are powered up. */
+void EnergyCountMeasurement(void);
+
+/** Turn the counted residencies into charges, and account a wake-up timer period in low power mode.
+ * @return 1 if the accounting to keep in the data EEPROM changed,
+ * @return 0 if it did not.
+ * @note Call this function each minute when the system is running, and each time the wake-up timer elapses in low power mode.
+ */
+unsigned char EnergyCountMinute(void);
+
+/** Get the accounting to keep in the data EEPROM.
+ * @param Pointer_State On output, will contain the accounting.
+ */
+void EnergyGetState(TEnergyState *Pointer_State);
+
+/** Restore the accounting read from the data EEPROM.
+ * @param Pointer_State The accounting.
+ */
+void EnergySetState(TEnergyState *Pointer_State);
+
+/** Clear the accounting, call it when the battery is replaced. */
+void EnergyReset(void);
+
+/** Read the charge drawn by a power state since the battery was replaced.
+ * @param Consumer The power state.
+ * @return The charge in uAs / 16 units.
+ */
+unsigned long EnergyReadConsumedCharge(TEnergyConsumer Consumer);
+
+/** Read how long the battery has been used, the charges being accounted over this time.
+ * @return The time in seconds.
+ */
+unsigned long EnergyReadElapsedTime(void);
+
+/** Estimate how long the battery can still power the thermometer, at the average current drawn since the battery was replaced. The remaining charge is the smallest of the accounted one and of the one the battery voltage tells, assuming that the charge drops linearly from ENERGY_BATTERY_FULL_VOLTAGE to ADC_BATTERY_LOW_VOLTAGE.
+ * @return The remaining runtime in days (0 if the battery voltage is low),
+ * @return ENERGY_RUNTIME_UNKNOWN if the battery has not been used for one hour yet, if it delivered more than ENERGY_BATTERY_CAPACITY or if the runtime exceeds 65534 days.
+ * @note The divisions are done with shifts and subtractions, each loop lasting as many iterations as the quotient has bits (the two quotients have about 10 bits each).
+ */
+unsigned short EnergyComputeRemainingRuntime(void);
+
+/** Tell whether the system is in low power mode, the wake-up timer periods are accounted to the standby state.
+ * @param Is_Low_Power_Enabled Set to 1 when the system enters low power mode or to 0 when it wakes up.
+ */
+void EnergySetLowPowerMode(unsigned char Is_Low_Power_Enabled);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,270 @@
+/** @file History.c
+ * @see History.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "EEPROM.h"
+#include "History.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+/** The ring first byte address in the data EEPROM. */
+#define HISTORY_AREA_ADDRESS EEPROM_RECORDS_AREA_SIZE
+
+/** How many nibbles the ring can hold. */
+#define HISTORY_NIBBLES_COUNT (2 * (EEPROM_SIZE - EEPROM_RECORDS_AREA_SIZE))
+
+/** The difference value that is never stored (-8), it tells that a keyframe follows. The keyframe value is stored in the next two nibbles, high nibble first. */
+#define HISTORY_KEYFRAME_MARKER 0x08
+
+/** How many nibbles a keyframe takes, marker included. */
+#define HISTORY_KEYFRAME_SIZE 3
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The oldest stored nibble position in the ring, it is always a keyframe marker. */
+static unsigned short History_Oldest_Position = 0;
+
+/** How many ring nibbles are used. */
+static unsigned short History_Used_Nibbles_Count = 0;
+
+/** How many samples are stored. */
+static unsigned short History_Samples_Count = 0;
+
+/** The newest sample value, in HISTORY_RESOLUTION units. */
+static signed char History_Newest_Value = 0;
+
+/** How many differences have been stored since the newest keyframe. */
+static unsigned char History_Differences_Count = 0;
+
+/** How many minutes are left before the next sample. */
+static unsigned char History_Minutes_Left_Count = HISTORY_SAMPLING_PERIOD;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Compute a ring position, wrapping around the ring end.
+ * @param Position The starting position.
+ * @param Offset How many nibbles to move forward (the value must be lesser or equal to HISTORY_NIBBLES_COUNT).
+ * @return The new position.
+ */
+static unsigned short HistoryGetNextPosition(unsigned short Position, unsigned short Offset)
+{
+	Position += Offset;
+	if (Position >= HISTORY_NIBBLES_COUNT) Position -= HISTORY_NIBBLES_COUNT;
+	return Position;
+}
+
+/** Read a nibble from the ring.
+ * @param Position The nibble position, the even positions are the bytes low nibble.
+ * @return The nibble value in range [0..15].
+ */
+static unsigned char HistoryReadNibble(unsigned short Position)
+{
+	unsigned char Byte;
+	
+	Byte = EEPROMReadByte(HISTORY_AREA_ADDRESS + (Position >> 1));
+	if (Position & 1) return Byte >> 4;
+	return Byte & 0x0F;
+}
+
+/** Write a nibble to the ring, keeping the other nibble of the byte.
+ * @param Position The nibble position, the even positions are the bytes low nibble.
+ * @param Nibble The nibble value in range [0..15].
+ */
+static void HistoryWriteNibble(unsigned short Position, unsigned char Nibble)
+{
+	unsigned char Address, Byte;
+	
+	Address = HISTORY_AREA_ADDRESS + (Position >> 1);
+	Byte = EEPROMReadByte(Address);
+	if (Position & 1) Byte = (Byte & 0x0F) | (Nibble << 4);
+	else Byte = (Byte & 0xF0) | Nibble;
+	EEPROMWriteByte(Address, Byte);
+}
+
+/** Drop the oldest keyframe and the differences following it. */
+static void HistoryDropOldestBlock(void)
+{
+	unsigned short Position;
+	
+	Position = HistoryGetNextPosition(History_Oldest_Position, HISTORY_KEYFRAME_SIZE);
+	History_Used_Nibbles_Count -= HISTORY_KEYFRAME_SIZE;
+	History_Samples_Count--;
+	
+	// The next block starts at the next keyframe marker
+	while ((History_Used_Nibbles_Count > 0) && (HistoryReadNibble(Position) != HISTORY_KEYFRAME_MARKER))
+	{
+		Position = HistoryGetNextPosition(Position, 1);
+		History_Used_Nibbles_Count--;
+		History_Samples_Count--;
+	}
+	History_Oldest_Position = Position;
+}
+
+/** Divide a value by five (HISTORY_RESOLUTION) using a multiplication by the reciprocal (205 / 1024), which needs hardware multiplications instead of a software division.
+ * @param Value The value to divide, it must be lesser than 1024.
+ * @return The quotient.
+ */
+static unsigned char HistoryDivideByFive(unsigned short Value)
+{
+	return ((unsigned long) Value * 205) >> 10;
+}
+
+/** Append a sample to the ring, then drop the oldest samples until a keyframe fits in the free room. The next sample is so written to nibbles the saved ring pointers do not use, as long as the pointers are saved after a drop.
+ * @param Value The sample value in HISTORY_RESOLUTION units.
+ * @return 0 if no sample was dropped,
+ * @return 1 if the oldest samples were dropped.
+ */
+static unsigned char HistoryStoreSample(signed char Value)
+{
+	signed short Difference;
+	unsigned char Nibbles[HISTORY_KEYFRAME_SIZE], Nibbles_Count, i, Is_Block_Dropped = 0;
+	unsigned short Position;
+	
+	// Store a keyframe for the first sample, when the difference does not fit in a nibble or when the keyframe period is elapsed
+	Difference = Value - History_Newest_Value;
+	if ((History_Samples_Count == 0) || (History_Differences_Count >= HISTORY_KEYFRAME_PERIOD - 1) || (Difference < -7) || (Difference > 7))
+	{
+		Nibbles[0] = HISTORY_KEYFRAME_MARKER;
+		Nibbles[1] = (unsigned char) Value >> 4;
+		Nibbles[2] = (unsigned char) Value & 0x0F;
+		Nibbles_Count = HISTORY_KEYFRAME_SIZE;
+		History_Differences_Count = 0;
+	}
+	else
+	{
+		Nibbles[0] = (unsigned char) Difference & 0x0F;
+		Nibbles_Count = 1;
+		History_Differences_Count++;
+	}
+	
+	// Write after the newest nibble
+	Position = HistoryGetNextPosition(History_Oldest_Position, History_Used_Nibbles_Count);
+	for (i = 0; i < Nibbles_Count; i++)
+	{
+		HistoryWriteNibble(Position, Nibbles[i]);
+		Position = HistoryGetNextPosition(Position, 1);
+	}
+	History_Used_Nibbles_Count += Nibbles_Count;
+	History_Samples_Count++;
+	History_Newest_Value = Value;
+	
+	while (HISTORY_NIBBLES_COUNT - History_Used_Nibbles_Count < HISTORY_KEYFRAME_SIZE)
+	{
+		HistoryDropOldestBlock();
+		Is_Block_Dropped = 1;
+	}
+	return Is_Block_Dropped;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+unsigned char HistoryCountMinute(signed short Temperature)
+{
+	signed short Value;
+	unsigned short Magnitude;
+	
+	History_Minutes_Left_Count--;
+	if (History_Minutes_Left_Count > 0) return 0;
+	History_Minutes_Left_Count = HISTORY_SAMPLING_PERIOD;
+	
+	// Round the temperature to the nearest resolution step, the keyframes holding a signed byte (the magnitude is bounded for the division, the bound still saturating the byte)
+	if (Temperature < 0) Magnitude = (unsigned short) -Temperature;
+	else Magnitude = Temperature;
+	if (Magnitude > 1000) Magnitude = 1000;
+	Value = HistoryDivideByFive(Magnitude + HISTORY_RESOLUTION / 2);
+	if (Temperature < 0) Value = -Value;
+	if (Value < -128) Value = -128;
+	else if (Value > 127) Value = 127;
+	
+	return 1 + HistoryStoreSample((signed char) Value);
+}
+
+void HistoryGetState(THistoryState *Pointer_State)
+{
+	Pointer_State->Oldest_Position = History_Oldest_Position;
+	Pointer_State->Used_Nibbles_Count = History_Used_Nibbles_Count;
+}
+
+void HistorySetState(THistoryState *Pointer_State)
+{
+	unsigned short Position, Nibbles_Left_Count, Samples_Count = 0;
+	signed char Value = 0;
+	unsigned char Nibble, Differences_Count = 0;
+	
+	if ((Pointer_State->Oldest_Position >= HISTORY_NIBBLES_COUNT) || (Pointer_State->Used_Nibbles_Count > HISTORY_NIBBLES_COUNT - HISTORY_KEYFRAME_SIZE)) return;
+	
+	// Decode all stored samples, the oldest one being a keyframe
+	Position = Pointer_State->Oldest_Position;
+	Nibbles_Left_Count = Pointer_State->Used_Nibbles_Count;
+	while (Nibbles_Left_Count > 0)
+	{
+		Nibble = HistoryReadNibble(Position);
+		if (Nibble == HISTORY_KEYFRAME_MARKER)
+		{
+			if (Nibbles_Left_Count < HISTORY_KEYFRAME_SIZE) return;
+			Value = (HistoryReadNibble(HistoryGetNextPosition(Position, 1)) << 4) | HistoryReadNibble(HistoryGetNextPosition(Position, 2));
+			Position = HistoryGetNextPosition(Position, HISTORY_KEYFRAME_SIZE);
+			Nibbles_Left_Count -= HISTORY_KEYFRAME_SIZE;
+			Differences_Count = 0;
+		}
+		else
+		{
+			if (Samples_Count == 0) return;
+			if (Nibble & 0x08) Nibble |= 0xF0; // Extend the difference sign
+			Value += (signed char) Nibble;
+			Position = HistoryGetNextPosition(Position, 1);
+			Nibbles_Left_Count--;
+			Differences_Count++;
+		}
+		Samples_Count++;
+	}
+	
+	History_Oldest_Position = Pointer_State->Oldest_Position;
+	History_Used_Nibbles_Count = Pointer_State->Used_Nibbles_Count;
+	History_Samples_Count = Samples_Count;
+	History_Newest_Value = Value;
+	History_Differences_Count = Differences_Count;
+}
+
+unsigned short HistoryGetSamplesCount(void)
+{
+	return History_Samples_Count;
+}
+
+unsigned short HistoryGetStoredSize(void)
+{
+	return (History_Used_Nibbles_Count + 1) >> 1;
+}
+
+signed short HistoryReadSample(unsigned short Age)
+{
+	unsigned short Position = History_Oldest_Position, Samples_Left_Count;
+	signed char Value = 0;
+	unsigned char Nibble;
+	
+	// Decode the samples from the oldest keyframe up to the requested one
+	Samples_Left_Count = History_Samples_Count - Age;
+	while (Samples_Left_Count > 0)
+	{
+		Nibble = HistoryReadNibble(Position);
+		if (Nibble == HISTORY_KEYFRAME_MARKER)
+		{
+			Value = (HistoryReadNibble(HistoryGetNextPosition(Position, 1)) << 4) | HistoryReadNibble(HistoryGetNextPosition(Position, 2));
+			Position = HistoryGetNextPosition(Position, HISTORY_KEYFRAME_SIZE);
+		}
+		else
+		{
+			if (Nibble & 0x08) Nibble |= 0xF0; // Extend the difference sign
+			Value += (signed char) Nibble;
+			Position = HistoryGetNextPosition(Position, 1);
+		}
+		Samples_Left_Count--;
+	}
+	
+	return (signed short) Value * HISTORY_RESOLUTION;
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+/** @file History.h
+ * Record the first sensor temperature at a regular interval in a ring kept in the data EEPROM bytes following the records area. Each sample is stored as a 4-bit difference with the previous one. An absolute value (a keyframe) is stored instead when the difference does not fit, and at regular intervals so the oldest samples can be dropped by whole keyframe blocks when the ring is full. The ring pointers are kept in the data EEPROM records with the peaks, so the history survives resets.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#ifndef H_HISTORY_H
+#define H_HISTORY_H
+
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+#ifndef HISTORY_SAMPLING_PERIOD
+	/** How many minutes separate two history samples (the value must be in range [1..255]). */
+	#define HISTORY_SAMPLING_PERIOD 10
+#endif
+
+#ifndef HISTORY_KEYFRAME_PERIOD
+	/** A keyframe is stored at least every this amount of samples (the value must be in range [1..255]). The ring must be able to hold two keyframe blocks and a free keyframe, that is (HISTORY_KEYFRAME_PERIOD + 4) bytes. */
+	#define HISTORY_KEYFRAME_PERIOD 32
+#endif
+
+/** The history samples resolution, in tenths of Celsius degrees. */
+#define HISTORY_RESOLUTION 5
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** The ring pointers kept in the data EEPROM across resets, the other history variables are rebuilt from the ring content. */
+typedef struct
+{
+	unsigned short Oldest_Position; //!< The oldest stored nibble position in the ring.
+	unsigned short Used_Nibbles_Count; //!< How many ring nibbles are used.
+} THistoryState;
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Tell the history that a minute elapsed, a sample is stored every HISTORY_SAMPLING_PERIOD minutes.
+ * @param Temperature The current temperature in tenths of Celsius degrees.
+ * @return 0 if no sample was stored,
+ * @return 1 if a sample was stored, the ring pointers must be saved to keep it,
+ * @return 2 if the oldest samples were dropped too, the ring pointers must be saved before the next call because the next sample overwrites the dropped ones.
+ * @note Storing a sample writes the data EEPROM, so this function must not be called from an interrupt handler.
+ */
+unsigned char HistoryCountMinute(signed short Temperature);
+
+/** Get the ring pointers to keep in the data EEPROM.
+ * @param Pointer_State On output, will contain the ring pointers.
+ */
+void HistoryGetState(THistoryState *Pointer_State);
+
+/** Restore the ring pointers read from the data EEPROM, and decode the stored samples to rebuild the other history variables. The history restarts if the pointers do not designate valid samples.
+ * @param Pointer_State The ring pointers.
+ */
+void HistorySetState(THistoryState *Pointer_State);
+
+/** Get how many samples are stored.
+ * @return The samples count.
+ */
+unsigned short HistoryGetSamplesCount(void);
+
+/** Get how many data EEPROM bytes the stored samples take.
+ * @return The size in bytes, rounded up.
+ */
+unsigned short HistoryGetStoredSize(void);
+
+/** Decode a stored sample. The samples are decoded from the oldest keyframe, so this is slow and should only be called on a user action.
+ * @param Age The sample age, 0 designates the newest sample and (HistoryGetSamplesCount() - 1) the oldest one.
+ * @return The sample temperature in tenths of Celsius degrees (rounded to HISTORY_RESOLUTION).
+ */
+signed short HistoryReadSample(unsigned short Age);
+
+#endif
\ No newline at end of file
@@ -4,9 +4,18 @@
  * @version 1.0 : 09/06/2014
  */
 #include <system.h>
+#include "ADC.h"
+#include "Button.h"
+#include "Diagnostics.h"
+#include "EEPROM.h"
+#include "Energy.h"
+#include "History.h"
 #include "Processor.h"
 #include "Screen.h"
+#include "Telemetry.h"
 #include "Temperature.h"
+#include "Timer.h"
+#include "Window.h"
 
 //--------------------------------------------------------------------------------------------------
 // Private constants
@@ -14,7 +23,7 @@
 // PIC18F13K22 fuses
 #pragma DATA _CONFIG1H, _IESO_OFF_1H & _FCMEN_OFF_1H & _PCLKEN_OFF_1H & _PLLEN_OFF_1H & _FOSC_IRC_1H // Disable Oscillator Switchover mode, disable Fail-Safe Clock Monitor, PLL and primary clock are under software control, select Internal RC Oscillator
 #pragma DATA _CONFIG2L, _BORV_27_2L & _BOREN_NOSLP_2L & _PWRTEN_OFF_2L // Set Brown-out Reset voltage to 2.5V, enable Brown-out Reset in hardware only and disable it in Sleep mode, disable Power-up Timer
-#pragma DATA _CONFIG2H, _WDTEN_OFF_2H // Disable Watchdog Timer
+#pragma DATA _CONFIG2H, _WDTEN_OFF_2H & _WDTPS_16384_2H // Watchdog Timer is under software control, set the watchdog period to 16384 * 4ms (~65 seconds)
 #pragma DATA _CONFIG3H, _MCLRE_OFF_3H & _HFOFST_OFF_3H // Enable RA3 pin, wait for the oscillator to become stable before booting the CPU core
 #pragma DATA _CONFIG4L, _DEBUG_OFF_4L & _XINST_OFF_4L & _BBSIZ_OFF_4L & _LVP_OFF_4L & _STVREN_OFF_4L // Disable debug, CPU in legacy mode, 512-word boot block size, disable Low-Voltage Programming, disable stack related interrupts
 #pragma DATA _CONFIG5L, _CP1_OFF_5L & _CP0_OFF_5L // Disable all blocks code protection
@@ -32,8 +41,32 @@
 #define PIN_LED_CURRENT_TEMPERATURE porta.RA4
 #define PIN_LED_MINIMUM_TEMPERATURE portb.RB7
 
-// The button
-#define PIN_BUTTON porta.RA0
+// The events signaled by the interrupt handler to the main loop, the lower bits are the BUTTON_EVENT_xxx ones
+/** A minute elapsed, the jobs counted in minutes can be done. */
+#define EVENT_MINUTE_ELAPSED 0x40
+/** The selected page number or letter has been shown long enough, the page can be shown. */
+#define EVENT_SELECTION_ELAPSED 0x20
+/** All conversions of a measurement are done, a new temperature sample can be read. */
+#define EVENT_TEMPERATURE_SAMPLE_AVAILABLE 0x80
+
+#ifndef STATE_SAVING_PERIOD
+	/** The shortest interval between two writes of the peaks and the settings to the data EEPROM, in minutes (the value must be in range [1..255]). The state is only written when it changed, and it is written right away when the system enters low power mode. */
+	#define STATE_SAVING_PERIOD 15
+#endif
+
+#ifndef DISPLAY_HYSTERESIS
+	/** The displayed current temperature is only changed when the samples move farther than this value from it (in tenths of Celsius degrees), so a temperature close to a displayed digit boundary does not make the screen flicker between two values. Set to 0 to display each sample. */
+	#define DISPLAY_HYSTERESIS 2
+#endif
+
+/** The displayed current temperature value before the first sample, it is farther than any sample from the TMP36 range so the first sample is always displayed. */
+#define DISPLAY_TEMPERATURE_UNKNOWN -1000
+
+/** The minute software timer period, in timer ticks (122 * 8.192ms = ~1s). */
+#define MINUTE_TIMER_PERIOD 122
+
+/** How long a page selection is shown, in timer ticks (61 * 8.192ms = ~0.5s). */
+#define SELECTION_TIMER_PERIOD 61
 
 //--------------------------------------------------------------------------------------------------
 // Private types
@@ -44,148 +77,601 @@ typedef enum
 	STATE_MAXIMUM_TEMPERATURE,
 	STATE_CURRENT_TEMPERATURE,
 	STATE_MINIMUM_TEMPERATURE,
+	STATE_WINDOW_MAXIMUM_TEMPERATURE,
+	STATE_WINDOW_MINIMUM_TEMPERATURE,
+	STATE_HISTORY,
+	STATE_BATTERY,
 	STATE_SLEEP
+#if DIAGNOSTICS_IS_ENABLED
+	, STATE_DIAGNOSTICS //!< The hidden diagnostics page, it is never reached by showing the next state. It is the last state so the other states telemetry codes are the same in all builds.
+#endif
 } TState;
 
+/** Everything kept in the data EEPROM across resets. */
+typedef struct
+{
+	signed short Maximum_Temperatures[ADC_TEMPERATURE_SENSORS_COUNT]; //!< The highest temperature of each sensor (in tenths of Celsius degrees).
+	signed short Minimum_Temperatures[ADC_TEMPERATURE_SENSORS_COUNT]; //!< The lowest temperature of each sensor (in tenths of Celsius degrees).
+	unsigned char Brightness_Level; //!< The screen brightness level selected by the user.
+	TEnergyState Energy_State; //!< The battery charge accounting.
+	THistoryState History_State; //!< The temperature history ring pointers.
+} TSavedState;
+
 //--------------------------------------------------------------------------------------------------
 // Private variables
 //--------------------------------------------------------------------------------------------------
 /** The state machine current state. */
 static TState Current_State = STATE_CURRENT_TEMPERATURE;
 
-/** The three types of sampled temperatures. */
-static signed char Maximum_Temperature = -128, Current_Temperature, Minimum_Temperature = 127;
+/** The sensor whose temperatures are displayed. */
+static unsigned char Current_Sensor = 0;
+
+/** The last sampled temperature of each sensor (in tenths of Celsius degrees). */
+static signed short Current_Temperatures[ADC_TEMPERATURE_SENSORS_COUNT];
+
+/** The current temperature displayed for each sensor, it follows the samples with a DISPLAY_HYSTERESIS band (in tenths of Celsius degrees). */
+static signed short Displayed_Current_Temperatures[ADC_TEMPERATURE_SENSORS_COUNT];
+
+/** The peaks and the settings, restored from the data EEPROM at boot. */
+static TSavedState Saved_State;
+
+/** Tell whether the saved state changed since it was last written to the data EEPROM. */
+static unsigned char Is_Saved_State_Modified = 0;
+
+/** How many minutes are left before the state can be written again. */
+static unsigned char State_Saving_Minutes_Left_Count = STATE_SAVING_PERIOD;
+
+/** How many seconds of the current minute are elapsed. */
+static unsigned char Minute_Seconds_Count = 0;
+
+/** The age of the history sample shown in the history state (0 is the newest sample). */
+static unsigned short History_Displayed_Sample_Age;
+
+/** The history sample shown in the history state, it is decoded only when the user selects another sample (in tenths of Celsius degrees). */
+static signed short History_Displayed_Temperature;
+
+/** The remaining battery runtime shown in the battery state, it is estimated when the state is selected and then each minute (in days). */
+static unsigned short Battery_Displayed_Runtime;
+
+/** The events set by the interrupt handler and not yet processed by the main loop (one bit per event). */
+static volatile unsigned char Pending_Events = 0;
+
+/** Tell whether the selected page number or letter is shown instead of the page. */
+static unsigned char Is_Selection_Displayed = 0;
+
+#if DIAGNOSTICS_IS_ENABLED
+/** The value shown in the diagnostics state (see TDiagnosticsValue). */
+static unsigned char Diagnostics_Displayed_Value_Index;
+#endif
 
 //-------------------------------------------------------------------------------------------------
 // Private functions
 //-------------------------------------------------------------------------------------------------
-/** Convert a signed 8-bit value to the two character codes representing it.
- * @param Value The value to convert.
+/** Divide a value by ten using a multiplication by the reciprocal (103 / 1024), which needs a single hardware 8x8 multiplication instead of a software division.
+ * @param Value The value to divide, it must be lesser than 100.
+ * @return The quotient.
+ */
+static unsigned char DivideByTen(unsigned char Value)
+{
+	return ((unsigned short) Value * 103) >> 10;
+}
+
+/** Convert a temperature to the two character codes representing it, showing a decimal when the temperature is small enough.
+ * @param Temperature The temperature in tenths of Celsius degrees.
  * @param Pointer_Left_Character On output, will contain the left character code.
  * @param Pointer_Right_Character On output, will contain the right character code.
- * @note Displays "--" if the provided value is lesser than -9 or greater than 99.
+ * @note Temperatures from -0.9 to 9.9 are displayed with one decimal ("-.5" for -0.5), the other ones are truncated to Celsius degrees.
+ * @note Displays "--" if the temperature is lesser than -9 or greater than 99 Celsius degrees.
  */
-static void ConvertIntegerToCharacterCodes(signed char Value, unsigned char *Pointer_Left_Character, unsigned char *Pointer_Right_Character)
+static void ConvertTemperatureToCharacterCodes(signed short Temperature, unsigned char *Pointer_Left_Character, unsigned char *Pointer_Right_Character)
 {
-	unsigned char Divided_By_Ten;
+	unsigned char Value, Divided_By_Ten, Hundreds = 0;
 	
 	// Check if value is in bounds
-	if ((Value < -9) || (Value > 99))
+	if ((Temperature <= -100) || (Temperature >= 1000))
 	{
 		*Pointer_Left_Character = SCREEN_CHARACTER_CODE_MINUS;
 		*Pointer_Right_Character = SCREEN_CHARACTER_CODE_MINUS;
 		return;
 	}
 	
-	// Convert leftmost character
-	if (Value < 0)
+	// Negative temperatures greater than -1 are displayed with one decimal, the other ones are displayed in Celsius degrees
+	if (Temperature < 0)
+	{
+		Value = (unsigned char) -Temperature;
+		if (Value < 10)
+		{
+			*Pointer_Left_Character = SCREEN_CHARACTER_CODE_MINUS | SCREEN_CHARACTER_FLAG_DOT;
+			*Pointer_Right_Character = Value;
+		}
+		else
+		{
+			*Pointer_Left_Character = SCREEN_CHARACTER_CODE_MINUS;
+			*Pointer_Right_Character = DivideByTen(Value);
+		}
+		return;
+	}
+	
+	// Positive temperatures lesser than 10 are displayed with one decimal
+	if (Temperature < 100)
+	{
+		Divided_By_Ten = DivideByTen((unsigned char) Temperature);
+		*Pointer_Left_Character = Divided_By_Ten | SCREEN_CHARACTER_FLAG_DOT;
+		*Pointer_Right_Character = (unsigned char) Temperature - ((Divided_By_Ten << 3) + (Divided_By_Ten << 1)); // Keep the tenths by substracting (units * 10)
+		return;
+	}
+	
+	// The other temperatures are displayed in Celsius degrees, the hundreds of tenths being the tens of degrees (there are at most 9 subtractions)
+	while (Temperature >= 100)
+	{
+		Temperature -= 100;
+		Hundreds++;
+	}
+	*Pointer_Left_Character = Hundreds;
+	*Pointer_Right_Character = DivideByTen((unsigned char) Temperature);
+}
+
+/** Convert a value to the two character codes representing its two most significant digits, the decimal points telling the power of ten the digits are multiplied by (none : 1, right : 10, left : 100, both : 1000).
+ * @param Value The value.
+ * @param Pointer_Left_Character On output, will contain the left character code.
+ * @param Pointer_Right_Character On output, will contain the right character code.
+ * @note Displays "--" if the value is greater than 99999.
+ */
+static void ConvertValueToCharacterCodes(unsigned long Value, unsigned char *Pointer_Left_Character, unsigned char *Pointer_Right_Character)
+{
+	unsigned long Divisor = 1, Limit = 100;
+	unsigned char Exponent = 0, Digits = 0, Tens, i;
+	
+	if (Value > 99999)
 	{
 		*Pointer_Left_Character = SCREEN_CHARACTER_CODE_MINUS;
-		Value = -Value; // Set value as positive
-	}		
-	else if (Value >= 10)
+		*Pointer_Right_Character = SCREEN_CHARACTER_CODE_MINUS;
+		return;
+	}
+	
+	// Find the power of ten leaving two digits, multiplying by ten with shifts
+	while (Value >= Limit)
+	{
+		Divisor = (Divisor << 3) + (Divisor << 1);
+		Limit = (Limit << 3) + (Limit << 1);
+		Exponent++;
+	}
+	
+	// Drop the least significant digits with shifts and subtractions instead of a 32-bit software division per digit, the quotient having 7 bits
+	Divisor <<= 6;
+	for (i = 0; i < 7; i++)
 	{
-		// Do a simple euclidian division to get the decades
-		Divided_By_Ten = Value / 10;
-		*Pointer_Left_Character = Divided_By_Ten;
-		Value -= (Divided_By_Ten << 3) + (Divided_By_Ten << 1); // Remove the decades from the original value by substracting (decades * 10)
+		Digits <<= 1;
+		if (Value >= Divisor)
+		{
+			Value -= Divisor;
+			Digits |= 1;
+		}
+		Divisor >>= 1;
 	}
-	else *Pointer_Left_Character = SCREEN_CHARACTER_CODE_EMPTY;
 	
-	*Pointer_Right_Character = Value;	
+	Tens = DivideByTen(Digits);
+	*Pointer_Left_Character = Tens;
+	*Pointer_Right_Character = Digits - ((Tens << 3) + (Tens << 1));
+	if (Exponent & 1) *Pointer_Right_Character |= SCREEN_CHARACTER_FLAG_DOT;
+	if (Exponent & 2) *Pointer_Left_Character |= SCREEN_CHARACTER_FLAG_DOT;
 }
 
-/** Read the temperature and update peaks. */
+/** Read all sensors temperature, update peaks and the displayed current temperatures. */
 static void ReadTemperature(void)
 {
-	Current_Temperature = TemperatureReadValue();
-	if (Current_Temperature < Minimum_Temperature) Minimum_Temperature = Current_Temperature;
-	else if (Current_Temperature > Maximum_Temperature) Maximum_Temperature = Current_Temperature;
+	unsigned char i;
+	signed short Temperature, Difference;
+	
+	for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++)
+	{
+		Temperature = TemperatureReadValue(i);
+		Current_Temperatures[i] = Temperature;
+		
+		// Hold the displayed temperature while the samples stay close to it
+		Difference = Temperature - Displayed_Current_Temperatures[i];
+		if ((Difference > DISPLAY_HYSTERESIS) || (Difference < -DISPLAY_HYSTERESIS)) Displayed_Current_Temperatures[i] = Temperature;
+		
+		// Update the peaks
+		if (Temperature < Saved_State.Minimum_Temperatures[i])
+		{
+			Saved_State.Minimum_Temperatures[i] = Temperature;
+			Is_Saved_State_Modified = 1;
+		}
+		else if (Temperature > Saved_State.Maximum_Temperatures[i])
+		{
+			Saved_State.Maximum_Temperatures[i] = Temperature;
+			Is_Saved_State_Modified = 1;
+		}
+	}
+	
+	// The last 24 hours peaks are tracked for the first sensor only
+	WindowAddSample(Current_Temperatures[0]);
+}
+
+/** Write the peaks and the settings to the data EEPROM if they changed since the last write, and restart the shortest interval before the next write. */
+static void SaveState(void)
+{
+	if (!Is_Saved_State_Modified) return;
+	
+	Saved_State.Brightness_Level = ScreenGetBrightness();
+	EnergyGetState(&Saved_State.Energy_State);
+	HistoryGetState(&Saved_State.History_State);
+	EEPROMWriteRecord((unsigned char *) &Saved_State, sizeof(Saved_State));
+	Is_Saved_State_Modified = 0;
+	State_Saving_Minutes_Left_Count = STATE_SAVING_PERIOD;
+}
+
+/** Queue all conversions, so the temperature and the battery voltage share the same Fixed Voltage Reference start-up. */
+static void QueueMeasurements(void)
+{
+	TemperatureStartSampling();
+	ADCQueueConversions(ADC_CHANNEL_BATTERY_VOLTAGE, 1, 0);
+	EnergyCountMeasurement();
+}
+
+/** Queue the conversions when the Fixed Voltage Reference is stable (called by the measurements software timer on each tick). */
+static void HandleMeasurementsTick(void)
+{
+	if (!ADCIsReady()) return; // Try again on the next tick
+	TimerStop(TIMER_ID_MEASUREMENTS);
+	QueueMeasurements();
+}
+
+/** Power the analog modules up, the conversions are queued on the next tick so the interrupt handler does not wait for the Fixed Voltage Reference start-up. */
+static void StartMeasurements(void)
+{
+	ADCSetPowerMode(0);
+	TimerStart(TIMER_ID_MEASUREMENTS, 1, HandleMeasurementsTick);
+}
+
+/** Debounce the button and forward its events to the main loop (called by the button software timer on each tick). */
+static void SampleButton(void)
+{
+	Pending_Events |= ButtonProcessTick();
+}
+
+/** Start a measurement when the temperature module needs it (called by the temperature sampling software timer at the end of each sampling period). */
+static void HandleSamplingPeriod(void)
+{
+	if (TemperatureIsSamplingNeeded()) StartMeasurements(); // Do not wait for the conversions end here, the ADC interrupt will signal them
+}
+
+/** Account the running second and signal each elapsed minute to the main loop (called by the minute software timer every second). */
+static void HandleMinuteTimer(void)
+{
+	// Only count what the second was spent on, the charges are computed by the main loop
+	EnergyCountSecond(ScreenGetLitSegmentsLoad(), PIN_LED_MAXIMUM_TEMPERATURE + PIN_LED_CURRENT_TEMPERATURE + PIN_LED_MINIMUM_TEMPERATURE);
+	
+	Minute_Seconds_Count++;
+	if (Minute_Seconds_Count < 60) return;
+	
+	Minute_Seconds_Count = 0;
+	Pending_Events |= EVENT_MINUTE_ELAPSED;
 }
 
-/** Display the temperature corresponding to the requested state.
+/** Tell the main loop that the selection has been shown long enough (called once by the selection software timer). */
+static void HandleSelectionTimer(void)
+{
+	TimerStop(TIMER_ID_SELECTION);
+	Pending_Events |= EVENT_SELECTION_ELAPSED;
+}
+
+/** Turn the energy counts into charges (called by the main loop each minute, and each time the wake-up timer elapses in low power mode). */
+static void CountEnergy(void)
+{
+	if (EnergyCountMinute()) Is_Saved_State_Modified = 1; // The accounting is saved in steps of about 0.29mAh, which bounds the data EEPROM wear
+}
+
+/** Do the jobs counted in minutes (called by the main loop each minute, the minutes being counted from the wake-up timer periods in low power mode). */
+static void HandleMinuteElapsed(void)
+{
+	unsigned char History_Status;
+	
+	if (State_Saving_Minutes_Left_Count > 0) State_Saving_Minutes_Left_Count--;
+	WindowCountMinute();
+	
+	// The history samples are kept by saving the ring pointers with the peaks, they are saved right away when the oldest samples were dropped so the saved pointers never designate overwritten samples
+	History_Status = HistoryCountMinute(Current_Temperatures[0]);
+	if (History_Status != 0) Is_Saved_State_Modified = 1;
+	if (History_Status == 2) SaveState();
+	
+	if (Current_State == STATE_BATTERY) Battery_Displayed_Runtime = EnergyComputeRemainingRuntime();
+#if DIAGNOSTICS_IS_ENABLED
+	DiagnosticsCountMinute();
+#endif
+	
+#if TELEMETRY_IS_ENABLED
+	// Send the periodic frames, the user actions queued since the previous burst are sent with them
+	if (TelemetryCountMinute())
+	{
+		TelemetrySendTemperatures(Current_Temperatures);
+		TelemetrySendPeaks(Saved_State.Maximum_Temperatures, Saved_State.Minimum_Temperatures);
+		TelemetrySendBatteryVoltage(ADCReadBatteryVoltageValue());
+		TelemetryStartBurst();
+	}
+#endif
+}
+
+/** Select the history sample to show in the history state.
+ * @param Age The sample age (0 is the newest sample).
+ */
+static void SelectHistorySample(unsigned short Age)
+{
+	History_Displayed_Sample_Age = Age;
+	History_Displayed_Temperature = HistoryReadSample(Age);
+}
+
+/** Sample the temperature and update peaks while the system is in low power mode.
+ * @note Interrupts must be globally disabled, the ADC interrupt wakes the idle core up without calling the interrupt handler.
+ */
+static void ReadStandbyTemperature(void)
+{
+	// The software timers are stopped in low power mode, the Fixed Voltage Reference start-up is short enough to be waited for here
+	ADCSetPowerMode(0);
+	while (!ADCIsReady());
+	QueueMeasurements();
+	
+	// Keep the core idle during the conversions
+	do
+	{
+		while (!pir1.ADIF) ProcessorWaitForInterrupt();
+		pir1.ADIF = 0;
+	} while (!ADCProcessConversion());
+	ReadTemperature();
+	
+	ADCSetPowerMode(1);
+}
+
+/** Display the temperature corresponding to the requested state, the selected diagnostics value or the battery runtime.
  * @param State_To_Display Which state to display.
  */
 static void DisplayStateTemperature(TState State_To_Display)
 {
 	unsigned char Left_Character, Right_Character;
-	signed char Temperature_To_Display;
+	signed short Temperature_To_Display;
 	
 	// Select the requested temperature to display
 	switch (State_To_Display)
 	{
 		case STATE_MAXIMUM_TEMPERATURE:
-			Temperature_To_Display = Maximum_Temperature;
+			Temperature_To_Display = Saved_State.Maximum_Temperatures[Current_Sensor];
 			break;
 			
 		case STATE_MINIMUM_TEMPERATURE:
-			Temperature_To_Display = Minimum_Temperature;
+			Temperature_To_Display = Saved_State.Minimum_Temperatures[Current_Sensor];
+			break;
+			
+		case STATE_WINDOW_MAXIMUM_TEMPERATURE:
+			Temperature_To_Display = WindowGetMaximum();
 			break;
 			
+		case STATE_WINDOW_MINIMUM_TEMPERATURE:
+			Temperature_To_Display = WindowGetMinimum();
+			break;
+			
+		case STATE_HISTORY:
+			Temperature_To_Display = History_Displayed_Temperature;
+			break;
+			
+	#if DIAGNOSTICS_IS_ENABLED
+		case STATE_DIAGNOSTICS:
+			ConvertValueToCharacterCodes(DiagnosticsReadValue(Diagnostics_Displayed_Value_Index), &Left_Character, &Right_Character);
+			ScreenSetDisplayedCharacters(Left_Character, Right_Character);
+			return;
+			
+	#endif
+		// The remaining days, "--" telling that they can't be estimated yet
+		case STATE_BATTERY:
+			if (Battery_Displayed_Runtime == ENERGY_RUNTIME_UNKNOWN) ScreenSetDisplayedCharacters(SCREEN_CHARACTER_CODE_MINUS, SCREEN_CHARACTER_CODE_MINUS);
+			else
+			{
+				ConvertValueToCharacterCodes(Battery_Displayed_Runtime, &Left_Character, &Right_Character);
+				ScreenSetDisplayedCharacters(Left_Character, Right_Character);
+			}
+			return;
+			
 		default:
-			Temperature_To_Display = Current_Temperature;
+			Temperature_To_Display = Displayed_Current_Temperatures[Current_Sensor];
 			break;
 	}
 	
 	// Display the requested temperature
-	ConvertIntegerToCharacterCodes(Temperature_To_Display, &Left_Character, &Right_Character);
+	ConvertTemperatureToCharacterCodes(Temperature_To_Display, &Left_Character, &Right_Character);
+	if (ADCIsBatteryLow()) Right_Character |= SCREEN_CHARACTER_FLAG_DOT; // The rightmost decimal point is never used by temperatures, so it signals that the battery needs to be replaced
 	ScreenSetDisplayedCharacters(Left_Character, Right_Character);
 }
 
-/** Suppress spurious button contacts. */
-static void ButtonDebounceTimer(void)
+/** Show which page is selected during half a second, all leds being lit. The main loop keeps serving the events meanwhile, the page is shown when the selection software timer expires.
+ * @param Left_Character_Code The leftmost character code.
+ * @param Right_Character_Code The rightmost character code.
+ */
+static void DisplaySelection(unsigned char Left_Character_Code, unsigned char Right_Character_Code)
 {
-	while (PIN_BUTTON); // Wait until the button is released
-	delay_ms(50); // First debounce timer
+	PIN_LED_MAXIMUM_TEMPERATURE = 1;
+	PIN_LED_CURRENT_TEMPERATURE = 1;
+	PIN_LED_MINIMUM_TEMPERATURE = 1;
+	ScreenSetDisplayedCharacters(Left_Character_Code, Right_Character_Code);
 	
-	while (PIN_BUTTON) delay_ms(1); // As many other debounce timer as needed
+	Is_Selection_Displayed = 1;
+	TimerStart(TIMER_ID_SELECTION, SELECTION_TIMER_PERIOD, HandleSelectionTimer);
+}
+
+/** Show which sensor (or which diagnostics value) is selected during half a second, all leds being lit.
+ * @param Number The number to show, it must be lesser than 100.
+ */
+static void DisplayNumber(unsigned char Number)
+{
+	unsigned char Tens;
+	
+	// Do not show a leading zero
+	Tens = DivideByTen(Number);
+	if (Tens == 0) DisplaySelection(SCREEN_CHARACTER_CODE_EMPTY, Number);
+	else DisplaySelection(Tens, Number - ((Tens << 3) + (Tens << 1)));
+}
+
+/** Show the current page, lighting the leds telling which page it is. */
+static void DisplayState(void)
+{
+	switch (Current_State)
+	{
+		case STATE_MAXIMUM_TEMPERATURE:
+			PIN_LED_MAXIMUM_TEMPERATURE = 1;
+			PIN_LED_CURRENT_TEMPERATURE = 0;
+			PIN_LED_MINIMUM_TEMPERATURE = 0;
+			break;
+			
+		case STATE_CURRENT_TEMPERATURE:
+			PIN_LED_MAXIMUM_TEMPERATURE = 0;
+			PIN_LED_CURRENT_TEMPERATURE = 1;
+			PIN_LED_MINIMUM_TEMPERATURE = 0;
+			break;
+			
+		case STATE_MINIMUM_TEMPERATURE:
+			PIN_LED_MAXIMUM_TEMPERATURE = 0;
+			PIN_LED_CURRENT_TEMPERATURE = 0;
+			PIN_LED_MINIMUM_TEMPERATURE = 1;
+			break;
+			
+		// The last 24 hours peaks are shown with the current temperature led lit next to the corresponding all-time peak led
+		case STATE_WINDOW_MAXIMUM_TEMPERATURE:
+			PIN_LED_MAXIMUM_TEMPERATURE = 1;
+			PIN_LED_CURRENT_TEMPERATURE = 1;
+			PIN_LED_MINIMUM_TEMPERATURE = 0;
+			break;
+			
+		case STATE_WINDOW_MINIMUM_TEMPERATURE:
+			PIN_LED_MAXIMUM_TEMPERATURE = 0;
+			PIN_LED_CURRENT_TEMPERATURE = 1;
+			PIN_LED_MINIMUM_TEMPERATURE = 1;
+			break;
+			
+		// Both peak leds tell that the history is shown
+		case STATE_HISTORY:
+			PIN_LED_MAXIMUM_TEMPERATURE = 1;
+			PIN_LED_CURRENT_TEMPERATURE = 0;
+			PIN_LED_MINIMUM_TEMPERATURE = 1;
+			break;
+			
+		case STATE_BATTERY:
+			PIN_LED_MAXIMUM_TEMPERATURE = 0;
+			PIN_LED_CURRENT_TEMPERATURE = 0;
+			PIN_LED_MINIMUM_TEMPERATURE = 0;
+			break;
+			
+		case STATE_SLEEP:
+			// Clear the leds and the screen to tell the user that the button can be released
+			PIN_LED_MAXIMUM_TEMPERATURE = 0;
+			PIN_LED_CURRENT_TEMPERATURE = 0;
+			PIN_LED_MINIMUM_TEMPERATURE = 0;
+			ScreenSetDisplayedCharacters(SCREEN_CHARACTER_CODE_EMPTY, SCREEN_CHARACTER_CODE_EMPTY);
+			return;
+			
+	#if DIAGNOSTICS_IS_ENABLED
+		// The leds are cleared to tell the diagnostics values from the temperatures, the value number being shown with all leds lit when it is selected
+		case STATE_DIAGNOSTICS:
+			PIN_LED_MAXIMUM_TEMPERATURE = 0;
+			PIN_LED_CURRENT_TEMPERATURE = 0;
+			PIN_LED_MINIMUM_TEMPERATURE = 0;
+			break;
+	#endif
+	}
+	
+	// Show the requested temperature (samples are displayed by the main loop too, so no locking is needed)
+	DisplayStateTemperature(Current_State);
+}
+
+/** Keep the core idle until the interrupt handler signals an event, the peripherals (like the screen refresh timer) still running.
+ * @return The signaled events, they are removed from the pending ones.
+ */
+static unsigned char WaitForEvents(void)
+{
+	unsigned char Events;
+	
+	// The core only executes the interrupt handlers until an event is signaled, so the frequency the tick needs is enough
+	ProcessorRequestClockFrequency(PROCESSOR_CLOCK_CLIENT_MAIN, PROCESSOR_CLOCK_FREQUENCY_31KHZ);
+	
+	// Disable the low priority interrupts (the only ones signaling events) so no event can be signaled between the pending events check and the core stop, an enabled interrupt wakes the idle core up even if interrupts are disabled
+	// The high priority screen refresh is never masked
+	intcon.GIEL = 0;
+	while (!Pending_Events)
+	{
+		ProcessorWaitForInterrupt();
+		
+		// Let the interrupt handler serve the interrupt which woke the core up
+		intcon.GIEL = 1;
+		intcon.GIEL = 0;
+	}
+	Events = Pending_Events;
+	Pending_Events = 0;
+	intcon.GIEL = 1;
+	
+	return Events;
 }
 
 //--------------------------------------------------------------------------------------------------
 // Interrupts handler
 //--------------------------------------------------------------------------------------------------
-/** Handle all interrupts (they are classified by usage rate). */
+/** Handle the high priority interrupts : only the screen refresh and blanking, so the displays are multiplexed at a steady rate whatever the other interrupts are doing. */
 void interrupt(void)
 {
 	// Screen refresh (Timer 0)
 	if ((intcon.TMR0IE) && (intcon.TMR0IF))
 	{
+		DIAGNOSTICS_START_HIGH_PRIORITY_INTERRUPT();
 		ScreenRefresh();
+		TimerTriggerTick(); // Let the low priority interrupt process the other periodic jobs
 		intcon.TMR0IF = 0;
+		DIAGNOSTICS_STOP_HIGH_PRIORITY_INTERRUPT(DIAGNOSTICS_SOURCE_SCREEN_REFRESH);
 	}
 	
-	// Temperature sampling (Timer 3)
-    if ((pie2.TMR3IE) && (pir2.TMR3IF))
-    {
-		ReadTemperature();
-		DisplayStateTemperature(Current_State); // Update displayed temperature (this function is called even if the temperature to display has not changed, but it is simpler this way)
+	// Screen blanking when the brightness is lowered (Timer 3)
+	if ((pie2.TMR3IE) && (pir2.TMR3IF))
+	{
+		DIAGNOSTICS_START_HIGH_PRIORITY_INTERRUPT();
+		ScreenBlank();
 		pir2.TMR3IF = 0;
-    }
+		DIAGNOSTICS_STOP_HIGH_PRIORITY_INTERRUPT(DIAGNOSTICS_SOURCE_SCREEN_BLANKING);
+	}
+}
+
+/** Handle the low priority interrupts (they are classified by usage rate). */
+void interrupt_low(void)
+{
+	// Button sampling and temperature sampling software timers (Timer 2 flag set by the Timer 0 interrupt)
+	if ((pie1.TMR2IE) && (pir1.TMR2IF))
+	{
+		DIAGNOSTICS_START_LOW_PRIORITY_INTERRUPT();
+		pir1.TMR2IF = 0; // Clear the flag first so a tick occurring while the software timers are processed is not lost
+		TimerProcessTick();
+		DIAGNOSTICS_STOP_LOW_PRIORITY_INTERRUPT(DIAGNOSTICS_SOURCE_SOFTWARE_TIMERS);
+	}
 	
-    // Wake-up timer (Timer 1)
-    if ((pie1.TMR1IE) && (pir1.TMR1IF))
-    {
-		// Wake up processor and temperature modules
-		ProcessorSetLowPowerMode(0); // Reenable processor full speed prior any other thing
-		TemperatureSetLowPowerMode(0);
-		
-        ReadTemperature();
-        
-        // Reenable interrupt before returning to low power mode
-        pir1.TMR1IF = 0;
-        
-        // Return to low power mode
-        TemperatureSetLowPowerMode(1);
-        ProcessorSetLowPowerMode(1);
-    }
-    
-    // Button (triggered only when the system is in low power mode)
-    if ((intcon.INT0IE) && (intcon.INT0IF))
+    // Temperature and battery voltage conversion end (ADC)
+    if ((pie1.ADIE) && (pir1.ADIF))
     {
-		// Reenable processor full speed
-		ProcessorSetLowPowerMode(0); 
-		intcon.INT0IF = 0;
-	}	
+		DIAGNOSTICS_START_LOW_PRIORITY_INTERRUPT();
+		pir1.ADIF = 0; // Clear the flag first as the next conversion of the sample may be started right now
+		if (ADCProcessConversion())
+		{
+			ADCSetPowerMode(1);
+			Pending_Events |= EVENT_TEMPERATURE_SAMPLE_AVAILABLE; // Let the main loop process the sample
+		}
+		DIAGNOSTICS_STOP_LOW_PRIORITY_INTERRUPT(DIAGNOSTICS_SOURCE_ADC);
+	}
+	
+	// Data EEPROM write end, the writing function waits for the flag so it is left set (the interrupt is only enabled during a write)
+	if ((pie2.EEIE) && (pir2.EEIF)) pie2.EEIE = 0;
+	
+#if TELEMETRY_IS_ENABLED
+	// Telemetry frames transmission (EUSART), the flag is cleared by loading the transmit register
+	if ((pie1.TXIE) && (pir1.TXIF))
+	{
+		DIAGNOSTICS_START_LOW_PRIORITY_INTERRUPT();
+		TelemetryTransmitByte();
+		DIAGNOSTICS_STOP_LOW_PRIORITY_INTERRUPT(DIAGNOSTICS_SOURCE_TELEMETRY);
+	}
+#endif
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -193,6 +679,8 @@ void interrupt(void)
 //-------------------------------------------------------------------------------------------------
 void main(void)
 {
+	unsigned char i, Events;
+	
 	// Initialize leds (configure leds' pins as digital outputs)
 	ansel.AN3 = 0; // RA4
 	trisa.RA4 = 0;
@@ -204,86 +692,244 @@ void main(void)
 	PIN_LED_CURRENT_TEMPERATURE = 1;
 	PIN_LED_MINIMUM_TEMPERATURE = 0;
 	
-	// Initialize the button (configure the button pin as digital input)
-	ansel.AN0 = 0;
-	trisa.RA0 = 1;
-
 	// Configure modules
+	TimerInitialize();
+	ButtonInitialize();
 	ScreenInitialize();
+	ADCInitialize();
 	TemperatureInitialize();
+#if TELEMETRY_IS_ENABLED
+	TelemetryInitialize();
+#endif
+#if DIAGNOSTICS_IS_ENABLED
+	DiagnosticsInitialize();
+#endif
+	
+	// Restore the peaks and the settings saved before the last reset, or initialize the peaks so the first sample sets them
+	if (EEPROMReadRecord((unsigned char *) &Saved_State, sizeof(Saved_State)) == 0)
+	{
+		if (Saved_State.Brightness_Level < SCREEN_BRIGHTNESS_LEVELS_COUNT) ScreenSetBrightness(Saved_State.Brightness_Level);
+		EnergySetState(&Saved_State.Energy_State);
+		HistorySetState(&Saved_State.History_State);
+	}
+	else
+	{
+		for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++)
+		{
+			Saved_State.Maximum_Temperatures[i] = -32768;
+			Saved_State.Minimum_Temperatures[i] = 32767;
+		}
+	}
+	for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++) Displayed_Current_Temperatures[i] = DISPLAY_TEMPERATURE_UNKNOWN;
+	
+	// Register the periodic jobs
+	TimerStart(TIMER_ID_BUTTON, 1, SampleButton);
+	TimerStart(TIMER_ID_TEMPERATURE_SAMPLING, TEMPERATURE_SAMPLING_PERIOD, HandleSamplingPeriod);
+	TimerStart(TIMER_ID_MINUTE, MINUTE_TIMER_PERIOD, HandleMinuteTimer);
+	
+	// Take the first sample on the first tick instead of waiting for the first sampling period end
+	StartMeasurements();
 
-	// Enable interrupts
-	intcon.PEIE = 1;
-	intcon.GIE = 1;
+	// Enable interrupts, only the screen refresh has a high priority
+	rcon.IPEN = 1;
+	ipr1.ADIP = 0;
+	intcon.GIEL = 1;
+	intcon.GIEH = 1;
      
 	while (1)
 	{	
-		// Wait for the button to be pressed
-		while (!PIN_BUTTON);
+		Events = WaitForEvents();
 		
-		Current_State++;
-		if (Current_State > STATE_SLEEP) Current_State = STATE_MAXIMUM_TEMPERATURE;
+		// Any button event is a user action that restores the screen brightness
+		if (Events & ~(EVENT_TEMPERATURE_SAMPLE_AVAILABLE | EVENT_MINUTE_ELAPSED | EVENT_SELECTION_ELAPSED)) ScreenResetDimmingTimeout();
 		
-		switch (Current_State)
+		if (Events & EVENT_MINUTE_ELAPSED)
 		{
-			case STATE_MAXIMUM_TEMPERATURE:
-				PIN_LED_MAXIMUM_TEMPERATURE = 1;
-				PIN_LED_CURRENT_TEMPERATURE = 0;
-				PIN_LED_MINIMUM_TEMPERATURE = 0;
-				break;
-				
-			case STATE_CURRENT_TEMPERATURE:
-				PIN_LED_MAXIMUM_TEMPERATURE = 0;
-				PIN_LED_CURRENT_TEMPERATURE = 1;
-				PIN_LED_MINIMUM_TEMPERATURE = 0;
-				break;
-				
-			case STATE_MINIMUM_TEMPERATURE:
-				PIN_LED_MAXIMUM_TEMPERATURE = 0;
-				PIN_LED_CURRENT_TEMPERATURE = 0;
-				PIN_LED_MINIMUM_TEMPERATURE = 1;
-				break;
-				
-			case STATE_SLEEP:
-				// Clear the leds
-				PIN_LED_MAXIMUM_TEMPERATURE = 0;
-				PIN_LED_CURRENT_TEMPERATURE = 0;
-				PIN_LED_MINIMUM_TEMPERATURE = 0;
-				
-				// Put the maximum modules in low power mode 
-				ScreenSetLowPowerMode(1); // Clear the screen
-				TemperatureSetLowPowerMode(1);
-				
-				// Debounce the button now to safely enable the button interrupt just after without spurious button press
-				ButtonDebounceTimer();
+			CountEnergy();
+			HandleMinuteElapsed();
+		}
+		
+		// Show the selected page once its selection has been shown long enough
+		if (Events & EVENT_SELECTION_ELAPSED)
+		{
+			Is_Selection_Displayed = 0;
+			DisplayState();
+		}
+		
+		// A gesture ends the shown selection, the page it selects may show a new one
+		if (Is_Selection_Displayed && (Events & (BUTTON_EVENT_CLICKED | BUTTON_EVENT_DOUBLE_CLICKED | BUTTON_EVENT_LONG_PRESSED)))
+		{
+			TimerStop(TIMER_ID_SELECTION);
+			Is_Selection_Displayed = 0;
+		}
+		
+		// Update the displayed temperature each time a new sample is available (the screen module ignores the unchanged characters)
+		if (Events & EVENT_TEMPERATURE_SAMPLE_AVAILABLE)
+		{
+			ReadTemperature();
+			if ((Current_State != STATE_SLEEP) && !Is_Selection_Displayed) DisplayStateTemperature(Current_State); // Keep the screen blank until the system goes to sleep, and keep the selection shown
+			
+			// Batch the peaks changes to bound the EEPROM wear and write energy
+			if (State_Saving_Minutes_Left_Count == 0) SaveState();
+		}
+		
+		// Go to sleep when the button is released after a long press
+		if ((Current_State == STATE_SLEEP) && (Events & BUTTON_EVENT_RELEASED))
+		{
+			// Put the maximum modules in low power mode 
+		#if TELEMETRY_IS_ENABLED
+			TelemetrySetLowPowerMode(1); // Transmit the queued frames while the tick can still power the serial port down
+		#endif
+		#if DIAGNOSTICS_IS_ENABLED
+			DiagnosticsSetLowPowerMode(1); // Before the RC_IDLE wake-up timer takes Timer 1
+		#endif
+			EnergySetLowPowerMode(1); // Account the wake-up timer periods to the standby state
+			ScreenSetLowPowerMode(1); // Clear the screen
+			TimerSetLowPowerMode(1); // Stop all periodic jobs
+			TimerStop(TIMER_ID_MEASUREMENTS); // Do not queue the conversions of an aborted measurement on wake-up
+			ADCSetPowerMode(1); // Abort any running measurement
+			ProcessorRequestClockFrequency(PROCESSOR_CLOCK_CLIENT_MAIN, PROCESSOR_CLOCK_FREQUENCY_31KHZ); // No module needs the HFINTOSC now
+			SaveState(); // Do not lose the peaks if the battery is removed during standby
+			
+			// The button is debounced yet, so its interrupt can be safely enabled to allow to wake up the system
+			ButtonSetLowPowerMode(1);
+			
+			// Do not call the interrupt handler while the system is in low power mode, so the main loop can find out what awoke it
+			intcon.GIEH = 0;
+			
+			// Put the whole system in low power mode, only the button can definitely wake it
+			ProcessorSetLowPowerMode(1);
+			
+			// Keep tracking the temperature peaks each time the wake-up timer awakes the system
+			while (ProcessorIsWakeUpTimerElapsed())
+			{
+			#if DIAGNOSTICS_IS_ENABLED
+				DiagnosticsCountWakeUp(DIAGNOSTICS_WAKE_UP_SOURCE_TIMER);
+			#endif
 				
-				// Enable the button interrupt to allow to wake up the system
-				intcon.INT0IF = 0; // Clear interrupt flag as it was previously set when pushing the button
-				intcon.INT0IE = 1;
+				ProcessorSetLowPowerMode(0); // Reenable the processor clock prior any other thing
+				if (TemperatureIsSamplingNeeded()) ReadStandbyTemperature();
+				CountEnergy();
 				
-				// Put the whole system in idle mode, only an interrupt can wake it
+				// The software timers are stopped, the wake-up timer periods are counted in the seconds of the current minute instead (a period lasts a bit more than a minute, so some periods end two minutes)
+				Minute_Seconds_Count += PROCESSOR_WAKE_UP_PERIOD;
+				while (Minute_Seconds_Count >= 60)
+				{
+					Minute_Seconds_Count -= 60;
+					HandleMinuteElapsed();
+				}
+				if (State_Saving_Minutes_Left_Count == 0) SaveState();
 				ProcessorSetLowPowerMode(1);
-				
-				// The following code is executed when the processor wakes up
-				// The button interrupt occured
-				intcon.INT0IE = 0; // Disable the button interrupt
-				
-				// Reenable all modules
-				TemperatureSetLowPowerMode(0);
-				ScreenSetLowPowerMode(0);
-				
-				// Force the next state temperature displaying to avoid a glitch which can occur during when the screen is reenabled and the 
-				DisplayStateTemperature(STATE_MAXIMUM_TEMPERATURE);
-				
-				// Here the button is still pushed, so the state machine will be reentered and the next state will automatically be selected
-				continue;
+			}
+			
+			// The following code is executed when the button wakes the processor up
+			ProcessorSetLowPowerMode(0);
+			ButtonSetLowPowerMode(0); // The waking press must not make a gesture
+			EnergySetLowPowerMode(0);
+		#if TELEMETRY_IS_ENABLED
+			TelemetrySetLowPowerMode(0);
+		#endif
+		#if DIAGNOSTICS_IS_ENABLED
+			DiagnosticsCountWakeUp(DIAGNOSTICS_WAKE_UP_SOURCE_BUTTON);
+			DiagnosticsSetLowPowerMode(0); // After the RC_IDLE wake-up timer released Timer 1
+		#endif
+			intcon.GIEH = 1;
+			
+			// Reenable all modules
+			TimerSetLowPowerMode(0);
+			ScreenSetLowPowerMode(0);
+			
+			// Show the first sensor maximum temperature
+			Current_Sensor = 0;
+			Current_State = STATE_MAXIMUM_TEMPERATURE;
+		}
+		// Reset the displayed sensor all-time peaks with a double click, a double click on the current temperature selects the next lower brightness level (the dimmest one being followed by the brightest one), a double click on the history shows the previous sample (the oldest one being followed by the newest one), a double click on the battery runtime clears the charge accounting when a new battery is fitted
+		else if (Events & BUTTON_EVENT_DOUBLE_CLICKED)
+		{
+			if (Current_State == STATE_HISTORY)
+			{
+				if (History_Displayed_Sample_Age + 1 < HistoryGetSamplesCount()) SelectHistorySample(History_Displayed_Sample_Age + 1);
+				else SelectHistorySample(0);
+			}
+			else if (Current_State == STATE_CURRENT_TEMPERATURE)
+			{
+				i = ScreenGetBrightness();
+				if (i == 0) i = SCREEN_BRIGHTNESS_LEVELS_COUNT;
+				ScreenSetBrightness(i - 1);
+				Is_Saved_State_Modified = 1;
+			}
+			else if ((Current_State == STATE_MAXIMUM_TEMPERATURE) || (Current_State == STATE_MINIMUM_TEMPERATURE))
+			{
+				Saved_State.Maximum_Temperatures[Current_Sensor] = Current_Temperatures[Current_Sensor];
+				Saved_State.Minimum_Temperatures[Current_Sensor] = Current_Temperatures[Current_Sensor];
+				Is_Saved_State_Modified = 1;
+			}
+			else if (Current_State == STATE_BATTERY)
+			{
+				EnergyReset();
+				Battery_Displayed_Runtime = EnergyComputeRemainingRuntime();
+				Is_Saved_State_Modified = 1;
+			}
+		#if DIAGNOSTICS_IS_ENABLED
+			// The hidden diagnostics page is shown with a double click on the last 24 hours maximum, a double click on the page clears the measurements
+			else if (Current_State == STATE_WINDOW_MAXIMUM_TEMPERATURE)
+			{
+				Current_State = STATE_DIAGNOSTICS;
+				Diagnostics_Displayed_Value_Index = 0;
+				DisplayNumber(1);
+			}
+			else if (Current_State == STATE_DIAGNOSTICS) DiagnosticsReset();
+		#endif
+		}
+	#if DIAGNOSTICS_IS_ENABLED
+		// Show the next diagnostics value with a click, the last one being followed by the current temperature
+		else if ((Current_State == STATE_DIAGNOSTICS) && (Events & BUTTON_EVENT_CLICKED))
+		{
+			Diagnostics_Displayed_Value_Index++;
+			if (Diagnostics_Displayed_Value_Index < DIAGNOSTICS_VALUES_COUNT) DisplayNumber(Diagnostics_Displayed_Value_Index + 1);
+			else Current_State = STATE_CURRENT_TEMPERATURE;
+		}
+	#endif
+		// Show the next temperature with a click
+		else if (Events & BUTTON_EVENT_CLICKED)
+		{
+			Current_State++;
+			
+			// The last 24 hours peaks, the history and the battery runtime are shown with the first sensor only
+			if ((Current_State > STATE_MINIMUM_TEMPERATURE) && (Current_Sensor != 0)) Current_State = STATE_SLEEP;
+			
+			// The history newest sample is shown first
+			if (Current_State == STATE_HISTORY)
+			{
+				if (HistoryGetSamplesCount() > 0) SelectHistorySample(0);
+				else Current_State = STATE_BATTERY;
+			}
+			
+			// Tell the battery runtime from a temperature by showing a 'b' letter first
+			if (Current_State == STATE_BATTERY)
+			{
+				Battery_Displayed_Runtime = EnergyComputeRemainingRuntime();
+				DisplaySelection(SCREEN_CHARACTER_CODE_SMALL_B, SCREEN_CHARACTER_CODE_EMPTY);
+			}
+			
+			// The sleep state can only be reached with a long press, so show the next sensor temperatures instead
+			if (Current_State == STATE_SLEEP)
+			{
+				Current_State = STATE_MAXIMUM_TEMPERATURE;
+				if (Current_Sensor + 1 < ADC_TEMPERATURE_SENSORS_COUNT) Current_Sensor++;
+				else Current_Sensor = 0;
+				if (ADC_TEMPERATURE_SENSORS_COUNT > 1) DisplayNumber(Current_Sensor + 1);
+			}
 		}
+		// Go to the sleep state with a long press, the system enters low power mode only when the button is released to avoid waking it up immediately
+		else if (Events & BUTTON_EVENT_LONG_PRESSED) Current_State = STATE_SLEEP;
+		else continue;
 		
-		// Show the requested temperature
-		TEMPERATURE_DISABLE_INTERRUPT(); // Use a "mutex" to avoid the sampling interrupt and this call changing both the display values in a random way
-		DisplayStateTemperature(Current_State);
-		TEMPERATURE_ENABLE_INTERRUPT();
+	#if TELEMETRY_IS_ENABLED
+		TelemetrySendState((Current_Sensor << 4) | Current_State);
+	#endif
 		
-		ButtonDebounceTimer();
+		// Keep the selection shown until its timer expires, the page is shown then
+		if (!Is_Selection_Displayed) DisplayState();
 	}
 }
\ No newline at end of file
@@ -5,14 +5,98 @@
 #include <system.h>
 #include "Processor.h"
 
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The OSCCON value selecting each frequency (the primary clock is the internal oscillator, idle mode is disabled). */
+static const unsigned char Processor_Oscillator_Controls[PROCESSOR_CLOCK_FREQUENCIES_COUNT] = {0x00, 0x10, 0x30, 0x70};
+
+/** The Timer 0 prescaler bits making it overflow at 122Hz for each frequency (the 31KHz frequency uses the lowest prescaler, the tick is not used at this frequency). */
+static const unsigned char Processor_Timer_0_Prescalers[PROCESSOR_CLOCK_FREQUENCIES_COUNT] = {0x00, 0x00, 0x02, 0x06}; // 1:2 at 250KHz, 1:8 at 1MHz, 1:128 at 16MHz
+
+/** The minimum frequency requested by each module. */
+static TProcessorClockFrequency Processor_Clock_Requests[PROCESSOR_CLOCK_CLIENTS_COUNT]; // All modules start with the 31KHz value
+
+/** The frequency the core is running at (the power-on frequency is 1MHz). */
+static volatile TProcessorClockFrequency Processor_Clock_Frequency = PROCESSOR_CLOCK_FREQUENCY_1MHZ;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Switch the oscillator to a new frequency and keep the Timer 0 tick rate.
+ * @param Frequency The frequency to switch to.
+ */
+static void ProcessorSetClockFrequency(TProcessorClockFrequency Frequency)
+{
+	unsigned char Is_Oscillator_Starting;
+	
+	// The HFINTOSC is stopped while the LFINTOSC clocks the core, the core keeps running from the LFINTOSC until the HFINTOSC is stable
+	Is_Oscillator_Starting = (Processor_Clock_Frequency == PROCESSOR_CLOCK_FREQUENCY_31KHZ) && (Frequency != PROCESSOR_CLOCK_FREQUENCY_31KHZ);
+	
+	// Switching between HFINTOSC frequencies only changes the postscaler, so the new frequency is used right now
+	osccon = Processor_Oscillator_Controls[Frequency];
+	t0con = (t0con & 0xF8) | Processor_Timer_0_Prescalers[Frequency];
+	Processor_Clock_Frequency = Frequency;
+	
+	if (Is_Oscillator_Starting)
+	{
+		while (!osccon.HFIOFS);
+	}
+}
+
+/** Find the lowest frequency satisfying all modules requests.
+ * @return The frequency to use.
+ */
+static TProcessorClockFrequency ProcessorGetRequestedClockFrequency(void)
+{
+	TProcessorClockFrequency Frequency = PROCESSOR_CLOCK_FREQUENCY_31KHZ;
+	unsigned char i;
+	
+	for (i = 0; i < PROCESSOR_CLOCK_CLIENTS_COUNT; i++)
+	{
+		if (Processor_Clock_Requests[i] > Frequency) Frequency = Processor_Clock_Requests[i];
+	}
+	return Frequency;
+}
+
 //--------------------------------------------------------------------------------------------------
 // Public functions
 //--------------------------------------------------------------------------------------------------
+void ProcessorRequestClockFrequency(TProcessorClockClient Client, TProcessorClockFrequency Minimum_Frequency)
+{
+	TProcessorClockFrequency Frequency;
+	unsigned char Is_Low_Priority_Interrupt_Enabled;
+	
+	// The low priority interrupt handler can release a request, the requests must not change between the frequency computation and the switch
+	Is_Low_Priority_Interrupt_Enabled = intcon.GIEL;
+	intcon.GIEL = 0;
+	
+	Processor_Clock_Requests[Client] = Minimum_Frequency;
+	
+	Frequency = ProcessorGetRequestedClockFrequency();
+	if (Frequency != Processor_Clock_Frequency) ProcessorSetClockFrequency(Frequency);
+	
+	intcon.GIEL = Is_Low_Priority_Interrupt_Enabled;
+}
+
+TProcessorClockFrequency ProcessorGetClockFrequency(void)
+{
+	return Processor_Clock_Frequency;
+}
+
 void ProcessorSetLowPowerMode(unsigned char Is_Low_Power_Enabled)
 {
-	// Go to idle mode
+	// Go to low power mode
 	if (Is_Low_Power_Enabled)
-	{	
+	{
+	#if PROCESSOR_IS_SLEEP_MODE_ENABLED
+		// Start the watchdog timer from zero, it is clocked by the LFINTOSC which keeps running in sleep mode
+		asm clrwdt;
+		wdtcon.SWDTEN = 1;
+		
+		// Disable idle mode, so all clocks are stopped (the core restarts at the current frequency)
+		osccon.IDLEN = 0;
+	#else
     	// Enable timer 1
         tmr1h = 0;
     	tmr1l = 0;
@@ -21,19 +105,43 @@ void ProcessorSetLowPowerMode(unsigned char Is_Low_Power_Enabled)
     	t1con = 0x31; // 8x prescaler
     	
     	// Change oscillator frequency to 31KHz and enable idle mode
-    	osccon = 0x80;
+    	ProcessorSetClockFrequency(PROCESSOR_CLOCK_FREQUENCY_31KHZ);
+    	osccon.IDLEN = 1;
+	#endif
 
-    	// Go to idle mode
+    	// Go to low power mode
     	asm sleep;
 	}
 	// Wake up system
 	else
 	{
+	#if PROCESSOR_IS_SLEEP_MODE_ENABLED
+		// Stop the watchdog timer as it would reset the processor when running at full speed
+		wdtcon.SWDTEN = 0;
+	#else
 	    // Disable timer 1
 	    t1con = 0;
 	    pie1.TMR1IE = 0; // Disable timer 1 interrupt
+	#endif
 	
-	    // Change oscillator frequency to 1MHz
-    	osccon = 0x30;
+	    // Go back to the frequency requested by the modules
+    	ProcessorSetClockFrequency(ProcessorGetRequestedClockFrequency());
 	}
+}
+
+unsigned char ProcessorIsWakeUpTimerElapsed(void)
+{
+#if PROCESSOR_IS_SLEEP_MODE_ENABLED
+	// The watchdog timer clears the TO bit when it wakes the processor up, the SLEEP instruction sets it
+	if (!rcon.TO) return 1;
+	return 0;
+#else
+	return pir1.TMR1IF;
+#endif
+}
+
+void ProcessorWaitForInterrupt(void)
+{
+	osccon.IDLEN = 1; // Stop the core only
+	asm sleep;
 }
\ No newline at end of file
@@ -1,17 +1,78 @@
 /** @file Processor.h
- * Handle the processor core low power mode.
+ * Handle the processor core low power mode and the clock frequency.
  * @author Adrien RICCIARDI
  * @version 1.0 : 20/06/2014
  */
 #ifndef H_PROCESSOR_H
 #define H_PROCESSOR_H
 
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+/** Select the standby policy at build time. Set to 1 to stop all clocks in sleep mode and periodically wake up with the watchdog timer (the watchdog postscaler configuration bits set the ~65 seconds period). Set to 0 to keep the core in RC_IDLE mode at 31KHz and wake up with Timer 1 each ~64 seconds. */
+#ifndef PROCESSOR_IS_SLEEP_MODE_ENABLED
+	#define PROCESSOR_IS_SLEEP_MODE_ENABLED 1
+#endif
+
+/** How many seconds last a wake-up timer period, rounded up as each wake-up lengthens it a bit. */
+#if PROCESSOR_IS_SLEEP_MODE_ENABLED
+	#define PROCESSOR_WAKE_UP_PERIOD 66 // 16384 watchdog periods of 4ms
+#else
+	#define PROCESSOR_WAKE_UP_PERIOD 68 // Timer 1 clocked by the 31KHz instruction clock divided by 4 and by the 8x prescaler
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** The clock frequencies the governor can select. The HFINTOSC frequencies are multiples of each other by a power of 2, so the Timer 0 tick keeps the same 122Hz rate by changing the prescaler. */
+typedef enum
+{
+	PROCESSOR_CLOCK_FREQUENCY_31KHZ, //!< LFINTOSC, too slow to keep the Timer 0 tick rate.
+	PROCESSOR_CLOCK_FREQUENCY_250KHZ, //!< The lowest HFINTOSC frequency handling the screen refresh and the software timers.
+	PROCESSOR_CLOCK_FREQUENCY_1MHZ, //!< The frequency the BoostC delays are computed for (see #pragma CLOCK_FREQ).
+	PROCESSOR_CLOCK_FREQUENCY_16MHZ, //!< Process a burst of work quickly to go back idle sooner.
+	PROCESSOR_CLOCK_FREQUENCIES_COUNT
+} TProcessorClockFrequency;
+
+/** All modules able to request a minimum clock frequency. */
+typedef enum
+{
+	PROCESSOR_CLOCK_CLIENT_TIMER, //!< The Timer 0 tick and the interrupts it triggers.
+	PROCESSOR_CLOCK_CLIENT_MAIN, //!< The main loop processing and busy waits.
+	PROCESSOR_CLOCK_CLIENT_TELEMETRY, //!< The serial line baud rate generator, which must not see a frequency switch while a byte is being shifted out.
+	PROCESSOR_CLOCK_CLIENTS_COUNT
+} TProcessorClockClient;
+
 //--------------------------------------------------------------------------------------------------
 // Functions
 //--------------------------------------------------------------------------------------------------
-/** Put the whole system in RC_IDLE mode to consume ~1mA. A timer will automatically awake the system each 64 seconds.
+/** Set the minimum clock frequency a module needs, and switch to the lowest frequency satisfying all modules requests. The Timer 0 prescaler is updated at the same time to keep the tick rate.
+ * @param Client The module doing the request.
+ * @param Minimum_Frequency The lowest frequency the module can work with, use PROCESSOR_CLOCK_FREQUENCY_31KHZ to release a previous request.
+ * @note When the HFINTOSC was stopped, it waits for the oscillator to be stable, so the code following the call runs at the new frequency. The low priority interrupt handler can only call this function to release a request, the HFINTOSC is never started then.
+ */
+void ProcessorRequestClockFrequency(TProcessorClockClient Client, TProcessorClockFrequency Minimum_Frequency);
+
+/** Get the clock frequency selected by the governor.
+ * @return The current frequency.
+ */
+TProcessorClockFrequency ProcessorGetClockFrequency(void);
+
+/** Put the whole system in low power mode until an enabled interrupt or the wake-up timer awakes it. According to PROCESSOR_IS_SLEEP_MODE_ENABLED, the core enters sleep mode (a few uA) or RC_IDLE mode at 31KHz (~1mA). The governor frequency is restored when the system is woken up.
  * @param Is_Low_Power_Required Set to 1 to enable low power mode or to 0 to wake up the whole system.
+ * @note Interrupts must be globally disabled when entering low power mode, so the caller can find out what awoke the system with ProcessorIsWakeUpTimerElapsed().
  */
 void ProcessorSetLowPowerMode(unsigned char Is_Low_Power_Enabled);
 
+/** Tell whether the periodic wake-up timer ended the last low power mode.
+ * @return 1 if the wake-up timer awoke the system,
+ * @return 0 if an interrupt awoke the system.
+ */
+unsigned char ProcessorIsWakeUpTimerElapsed(void);
+
+/** Put the core in idle mode at the current clock frequency until an enabled interrupt occurs. Peripherals keep running.
+ * @note The core is awoken even if interrupts are globally disabled, in this case the interrupt handler is not called.
+ */
+void ProcessorWaitForInterrupt(void);
+
 #endif
\ No newline at end of file
@@ -3,7 +3,9 @@
  * @author Adrien RICCIARDI
  */
 #include <system.h>
+#include "Processor.h"
 #include "Screen.h"
+#include "Timer.h"
 
 //--------------------------------------------------------------------------------------------------
 // Private macros and constants
@@ -14,15 +16,64 @@
 #define SCREEN_PORT_DATA portc
 
 /** The pin selecting the left display (active low). */
-#define SCREEN_PIN_SELECT_LEFT_DISPLAY 5
+#define SCREEN_PIN_SELECT_LEFT_DISPLAY RB5
 /** The pin selecting the right display (active low). */
-#define SCREEN_PIN_SELECT_RIGHT_DISPLAY 4
+#define SCREEN_PIN_SELECT_RIGHT_DISPLAY RB4
+
+// The data port pin lighting each segment, the segments being named from 'a' (the top one) clockwise to 'f', 'g' being the middle one
+#if SCREEN_WIRING == SCREEN_WIRING_DIGITAL_THERMOMETER_2
+	#define SCREEN_PIN_SEGMENT_A 0
+	#define SCREEN_PIN_SEGMENT_B 2
+	#define SCREEN_PIN_SEGMENT_C 4
+	#define SCREEN_PIN_SEGMENT_D 5
+	#define SCREEN_PIN_SEGMENT_E 3
+	#define SCREEN_PIN_SEGMENT_F 1
+	#define SCREEN_PIN_SEGMENT_G 6
+	#define SCREEN_PIN_SEGMENT_DOT 7
+#elif SCREEN_WIRING == SCREEN_WIRING_SEQUENTIAL
+	#define SCREEN_PIN_SEGMENT_A 0
+	#define SCREEN_PIN_SEGMENT_B 1
+	#define SCREEN_PIN_SEGMENT_C 2
+	#define SCREEN_PIN_SEGMENT_D 3
+	#define SCREEN_PIN_SEGMENT_E 4
+	#define SCREEN_PIN_SEGMENT_F 5
+	#define SCREEN_PIN_SEGMENT_G 6
+	#define SCREEN_PIN_SEGMENT_DOT 7
+#else
+	#error "Unknown SCREEN_WIRING value."
+#endif
+
+/** The segment lighting the decimal point (it is active low like the other segments). */
+#define SCREEN_SEGMENT_DOT (1 << SCREEN_PIN_SEGMENT_DOT)
+
+/** Compute the data port value displaying a font, the segments being active low and the decimal point being off. The value is a char, the 8-bit type of the BoostC program memory data.
+ * @param A Set to 1 to light the top segment.
+ * @param B Set to 1 to light the top right segment.
+ * @param C Set to 1 to light the bottom right segment.
+ * @param D Set to 1 to light the bottom segment.
+ * @param E Set to 1 to light the bottom left segment.
+ * @param F Set to 1 to light the top left segment.
+ * @param G Set to 1 to light the middle segment.
+ */
+#define SCREEN_FONT(A, B, C, D, E, F, G) ((char) ~(((A) << SCREEN_PIN_SEGMENT_A) | ((B) << SCREEN_PIN_SEGMENT_B) | ((C) << SCREEN_PIN_SEGMENT_C) | ((D) << SCREEN_PIN_SEGMENT_D) | ((E) << SCREEN_PIN_SEGMENT_E) | ((F) << SCREEN_PIN_SEGMENT_F) | ((G) << SCREEN_PIN_SEGMENT_G)))
 
 /** The logical value to enable a 7-segment display. */
 #define SCREEN_ENABLE 0
 /** The logical value to disable a 7-segment display. */
 #define SCREEN_DISABLE 1
 
+/** How many instruction cycles elapse between the display enabling and the blanking interrupt handler disabling it, the blanking timer is loaded ahead of them so the lit time is not lengthened. */
+#define SCREEN_BLANKING_LATENCY_CYCLES 32
+
+/** Compute the Timer 3 value making it overflow when a display has been lit for 1/8 (level 0), 1/4 (level 1) or 1/2 (level 2) of the refresh period. Timer 3 uses a 1:8 prescaler.
+ * @param Period_Counts How many Timer 3 counts last a refresh period at the clock frequency.
+ * @param Level The brightness level.
+ */
+#define SCREEN_BLANKING_TIMER_VALUE(Period_Counts, Level) (65536 - ((Period_Counts) >> (3 - (Level))) + SCREEN_BLANKING_LATENCY_CYCLES / 8)
+
+/** The dimming software timer period in ticks (one second). */
+#define SCREEN_DIMMING_TIMER_PERIOD 122
+
 //--------------------------------------------------------------------------------------------------
 // Private types
 //--------------------------------------------------------------------------------------------------
@@ -36,25 +87,104 @@ typedef enum
 //--------------------------------------------------------------------------------------------------
 // Private variables
 //--------------------------------------------------------------------------------------------------
-/** The available fonts for the screen. */
-static unsigned char Screen_Fonts[] =
+/** The available fonts for the screen, built for the selected wiring (the decimal point is off). The table is stored in program memory and read with table reads, so it takes no RAM. */
+static rom char Screen_Fonts[] =
 {
-	0x40, // '0'
-	0xEB, // '1'
-	0x12, // '2'
-	0x0A, // '3'
-	0x29, // '4'
-	0x0C, // '5'
-	0x04, // '6'
-	0x68, // '7'
-	0x00, // '8'
-	0x08, // '9'
-	0xBF, // '-'
-	0xFF // Empty character
+	SCREEN_FONT(1, 1, 1, 1, 1, 1, 0), // '0'
+	SCREEN_FONT(0, 1, 1, 0, 0, 0, 0), // '1'
+	SCREEN_FONT(1, 1, 0, 1, 1, 0, 1), // '2'
+	SCREEN_FONT(1, 1, 1, 1, 0, 0, 1), // '3'
+	SCREEN_FONT(0, 1, 1, 0, 0, 1, 1), // '4'
+	SCREEN_FONT(1, 0, 1, 1, 0, 1, 1), // '5'
+	SCREEN_FONT(1, 0, 1, 1, 1, 1, 1), // '6'
+	SCREEN_FONT(1, 1, 1, 0, 0, 1, 0), // '7'
+	SCREEN_FONT(1, 1, 1, 1, 1, 1, 1), // '8'
+	SCREEN_FONT(1, 1, 1, 1, 0, 1, 1), // '9'
+	SCREEN_FONT(0, 0, 0, 0, 0, 0, 1), // '-'
+	SCREEN_FONT(0, 0, 0, 0, 0, 0, 0), // Empty character
+	SCREEN_FONT(1, 0, 0, 1, 1, 1, 1), // 'E'
+	SCREEN_FONT(0, 0, 0, 1, 1, 1, 0), // 'L'
+	SCREEN_FONT(0, 1, 1, 0, 1, 1, 1), // 'H'
+	SCREEN_FONT(0, 0, 1, 1, 1, 1, 1), // 'b'
+	SCREEN_FONT(1, 0, 0, 1, 1, 1, 0), // 'C'
+	SCREEN_FONT(0, 0, 1, 1, 1, 0, 1), // 'o'
+	SCREEN_FONT(1, 1, 0, 0, 1, 1, 1) // 'P'
 };
 
-/** The currently displayed data (they have been converted to displayable fonts yet). */
-static unsigned char Characters[2] = {0xFF, 0xFF}; // Display nothing when initialized
+/** Two frames holding the data of both displays (they have been converted to displayable fonts yet). The refresh only reads the front frame while the back frame is prepared. */
+static unsigned char Screen_Frames[2][2] = {{0xFF, 0xFF}, {0xFF, 0xFF}}; // Display nothing when initialized
+
+/** The Timer 3 value loaded by the refresh for each clock frequency and each brightness level but the brightest one. */
+static const unsigned short Screen_Blanking_Timer_Values[PROCESSOR_CLOCK_FREQUENCIES_COUNT][SCREEN_BRIGHTNESS_LEVELS_COUNT - 1] =
+{
+	{0, 0, 0}, // The screen is not refreshed at 31KHz
+	{SCREEN_BLANKING_TIMER_VALUE(64, 0), SCREEN_BLANKING_TIMER_VALUE(64, 1), SCREEN_BLANKING_TIMER_VALUE(64, 2)}, // 250KHz
+	{SCREEN_BLANKING_TIMER_VALUE(256, 0), SCREEN_BLANKING_TIMER_VALUE(256, 1), SCREEN_BLANKING_TIMER_VALUE(256, 2)}, // 1MHz
+	{SCREEN_BLANKING_TIMER_VALUE(4096, 0), SCREEN_BLANKING_TIMER_VALUE(4096, 1), SCREEN_BLANKING_TIMER_VALUE(4096, 2)} // 16MHz
+};
+
+/** The brightness level selected by the user. */
+static volatile unsigned char Screen_Brightness_Level = SCREEN_BRIGHTNESS_DEFAULT_LEVEL;
+
+/** Tell whether the lowest brightness level is used because the user did nothing for a while. */
+static volatile unsigned char Screen_Is_Dimmed = 0;
+
+/** How many seconds are left before the screen is dimmed. */
+static volatile unsigned char Screen_Dimming_Seconds_Left_Count;
+
+/** Tell whether the refresh is stopped. */
+static volatile unsigned char Screen_Is_Low_Power_Enabled = 1;
+
+/** The frame read by the refresh. It is a single byte, so it is atomically written when flipping the frames. */
+static volatile unsigned char Screen_Front_Frame_Index = 0;
+
+/** How many segments of the front frame are lit (decimal points included). */
+static volatile unsigned char Screen_Lit_Segments_Count = 0;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Convert a character code to the segments to light.
+ * @param Character_Code The character code, with the SCREEN_CHARACTER_FLAG_DOT flag set if the decimal point must be lit.
+ * @return The value to output on the data port.
+ */
+static unsigned char ScreenGetCharacterSegments(unsigned char Character_Code)
+{
+	unsigned char Segments;
+	
+	Segments = Screen_Fonts[Character_Code & ~SCREEN_CHARACTER_FLAG_DOT]; // BoostC reads the rom data with a table read
+	if (Character_Code & SCREEN_CHARACTER_FLAG_DOT) Segments &= ~SCREEN_SEGMENT_DOT;
+	return Segments;
+}
+
+/** Count the lit segments of a display.
+ * @param Segments The value output on the data port (the segments are active low).
+ * @return How many segments are lit.
+ */
+static unsigned char ScreenCountLitSegments(unsigned char Segments)
+{
+	unsigned char Count = 0;
+	
+	// Clear the lowest lit segment on each loop
+	Segments = ~Segments;
+	while (Segments)
+	{
+		Segments &= Segments - 1;
+		Count++;
+	}
+	return Count;
+}
+
+#if SCREEN_DIMMING_TIMEOUT > 0
+	/** Dim the screen when the user did nothing for SCREEN_DIMMING_TIMEOUT seconds (called by the dimming software timer every second). */
+	static void ScreenProcessDimmingTimer(void)
+	{
+		if (Screen_Dimming_Seconds_Left_Count == 0) return;
+		
+		Screen_Dimming_Seconds_Left_Count--;
+		if (Screen_Dimming_Seconds_Left_Count == 0) Screen_Is_Dimmed = 1;
+	}
+#endif
 
 //--------------------------------------------------------------------------------------------------
 // Public functions
@@ -74,11 +204,9 @@ void ScreenInitialize(void)
 	trisb.SCREEN_PIN_SELECT_RIGHT_DISPLAY = 0;
 	trisc = 0;
 	
-	// Initialize the timer 0 device to generate an interrupt every 120Hz
-	// The main clock is running at 1MHz, so timer clock will be 1000000/4 = 250KHz
-	// 8-bit mode is selected, so timer will overflow and generate an interrupt when it reaches 255, thus with a rate of 250000/256 = 976,5625
-	// By dividing the previous value by ten, we get a 122,1Hz interrupt frequency
-	t0con = 0x42; // Do not enable timer, use 8-bit mode, clock from internal oscillator, use a prescaler of 8
+	// Configure the Timer 3 to blank the displays before the end of the refresh period when the brightness is lowered
+	t3con = 0x30; // Do not enable timer, write the counter bytes separately, use a prescaler of 8, clock from internal oscillator
+	ipr2.TMR3IP = 1; // Blanking late would make the brightness flicker
 	
 	// Run the module
 	ScreenSetLowPowerMode(0);
@@ -88,7 +216,12 @@ void ScreenRefresh(void)
 {
 	static TDisplay Last_Updated_Display = Display_Right; // Start by left display
 	TDisplay Display_To_Refresh;
-	
+	unsigned char Brightness_Level;
+	unsigned short Timer_Value;
+
+	// The tick keeps running while the screen is blanked
+	if (Screen_Is_Low_Power_Enabled) return;
+
 	// Disable currently enabled display
 	if (Last_Updated_Display == Display_Left)
 	{
@@ -102,25 +235,80 @@ void ScreenRefresh(void)
 	}
 	
 	// Output the data to display
-	SCREEN_PORT_DATA = Characters[Display_To_Refresh];
+	SCREEN_PORT_DATA = Screen_Frames[Screen_Front_Frame_Index][Display_To_Refresh];
 	
 	// Enable the display
 	if (Display_To_Refresh == Display_Left) SCREEN_PORT_SELECT_DISPLAY.SCREEN_PIN_SELECT_LEFT_DISPLAY = SCREEN_ENABLE;
 	else SCREEN_PORT_SELECT_DISPLAY.SCREEN_PIN_SELECT_RIGHT_DISPLAY = SCREEN_ENABLE;
 	
+	// Start counting the lit time if the display must be blanked before the next refresh
+	if (Screen_Is_Dimmed) Brightness_Level = 0;
+	else Brightness_Level = Screen_Brightness_Level;
+	if (Brightness_Level < SCREEN_BRIGHTNESS_LEVELS_COUNT - 1)
+	{
+		Timer_Value = Screen_Blanking_Timer_Values[ProcessorGetClockFrequency()][Brightness_Level];
+		tmr3h = Timer_Value >> 8;
+		tmr3l = (unsigned char) Timer_Value;
+		pir2.TMR3IF = 0;
+		t3con.TMR3ON = 1;
+	}
+	
 	Last_Updated_Display = Display_To_Refresh;
 }
 
+void ScreenBlank(void)
+{
+	t3con.TMR3ON = 0;
+	SCREEN_PORT_SELECT_DISPLAY.SCREEN_PIN_SELECT_LEFT_DISPLAY = SCREEN_DISABLE;
+	SCREEN_PORT_SELECT_DISPLAY.SCREEN_PIN_SELECT_RIGHT_DISPLAY = SCREEN_DISABLE;
+}
+
 void ScreenSetDisplayedCharacters(unsigned char Left_Character_Code, unsigned char Right_Character_Code)
 {
-	// Disable timer 0 interrupt while changing the data to display to avoid glitches
-	intcon.TMR0IE = 0;
+	unsigned char Back_Frame_Index, Left_Segments, Right_Segments;
+	
+	// Keep the displayed frame when the characters do not change
+	Left_Segments = ScreenGetCharacterSegments(Left_Character_Code);
+	Right_Segments = ScreenGetCharacterSegments(Right_Character_Code);
+	if ((Left_Segments == Screen_Frames[Screen_Front_Frame_Index][0]) && (Right_Segments == Screen_Frames[Screen_Front_Frame_Index][1])) return;
 	
-	Characters[0] = Screen_Fonts[Left_Character_Code];
-	Characters[1] = Screen_Fonts[Right_Character_Code];
+	// Prepare the frame the refresh is not reading, so no interrupt needs to be masked
+	Back_Frame_Index = Screen_Front_Frame_Index ^ 1;
+	Screen_Frames[Back_Frame_Index][0] = Left_Segments;
+	Screen_Frames[Back_Frame_Index][1] = Right_Segments;
 	
-	// Reenable timer 0 interrupt
-	intcon.TMR0IE = 1;
+	// Show the new frame from the next refresh
+	Screen_Front_Frame_Index = Back_Frame_Index;
+	Screen_Lit_Segments_Count = ScreenCountLitSegments(Left_Segments) + ScreenCountLitSegments(Right_Segments);
+}
+
+void ScreenSetBrightness(unsigned char Level)
+{
+	Screen_Brightness_Level = Level;
+}
+
+unsigned char ScreenGetBrightness(void)
+{
+	return Screen_Brightness_Level;
+}
+
+void ScreenResetDimmingTimeout(void)
+{
+	// Restart the timeout before undimming, so the dimming timer can't dim the screen again right now
+	Screen_Dimming_Seconds_Left_Count = SCREEN_DIMMING_TIMEOUT;
+	Screen_Is_Dimmed = 0;
+}
+
+unsigned char ScreenGetLitSegmentsLoad(void)
+{
+	unsigned char Brightness_Level;
+	
+	if (Screen_Is_Low_Power_Enabled) return 0;
+	
+	// Each brightness level doubles the lit time
+	if (Screen_Is_Dimmed) Brightness_Level = 0;
+	else Brightness_Level = Screen_Brightness_Level;
+	return Screen_Lit_Segments_Count << Brightness_Level;
 }
 
 void ScreenSetLowPowerMode(unsigned char Is_Low_Power_Enabled)
@@ -129,8 +317,12 @@ void ScreenSetLowPowerMode(unsigned char Is_Low_Power_Enabled)
 	if (Is_Low_Power_Enabled)
 	{
 		// Stop refreshing screen
-		t0con.TMR0ON = 0;
-		intcon.TMR0IE = 0; // Disable timer 0 interrupt
+		Screen_Is_Low_Power_Enabled = 1;
+		pie2.TMR3IE = 0;
+		t3con.TMR3ON = 0;
+		#if SCREEN_DIMMING_TIMEOUT > 0
+			TimerStop(TIMER_ID_SCREEN_DIMMING);
+		#endif
 		
 		// Disable screen
 		SCREEN_PORT_DATA = 0xFF; // Blank screen
@@ -138,16 +330,19 @@ void ScreenSetLowPowerMode(unsigned char Is_Low_Power_Enabled)
 		SCREEN_PORT_SELECT_DISPLAY.SCREEN_PIN_SELECT_RIGHT_DISPLAY = SCREEN_DISABLE;
 		
 		// Clear screen data to avoid displaying bad text when awoken
-		Characters[0] = Screen_Fonts[SCREEN_CHARACTER_CODE_EMPTY];
-		Characters[1] = Screen_Fonts[SCREEN_CHARACTER_CODE_EMPTY]; 
+		ScreenSetDisplayedCharacters(SCREEN_CHARACTER_CODE_EMPTY, SCREEN_CHARACTER_CODE_EMPTY);
 	}
 	// Wake up module
 	else
 	{
-		tmr0l = 0;
-		intcon.TMR0IF = 0; // Reset interrupt flag
-		intcon.TMR0IE = 0; // Enable timer 0 interrupt
-		t0con.TMR0ON = 1; // Reenable timer 0
+		ScreenResetDimmingTimeout();
+		#if SCREEN_DIMMING_TIMEOUT > 0
+			TimerStart(TIMER_ID_SCREEN_DIMMING, SCREEN_DIMMING_TIMER_PERIOD, ScreenProcessDimmingTimer);
+		#endif
+		
+		pir2.TMR3IF = 0;
+		pie2.TMR3IE = 1;
+		Screen_Is_Low_Power_Enabled = 0; // Refresh one display on each tick
 	}
 }
 	
\ No newline at end of file
@@ -15,24 +15,90 @@
 /** Display an empty character. */
 #define SCREEN_CHARACTER_CODE_EMPTY 11
 
+/** Display an 'E' letter. */
+#define SCREEN_CHARACTER_CODE_E 12
+/** Display an 'L' letter. */
+#define SCREEN_CHARACTER_CODE_L 13
+/** Display an 'H' letter. */
+#define SCREEN_CHARACTER_CODE_H 14
+/** Display a 'b' letter. */
+#define SCREEN_CHARACTER_CODE_SMALL_B 15
+/** Display a 'C' letter. */
+#define SCREEN_CHARACTER_CODE_C 16
+/** Display an 'o' letter. */
+#define SCREEN_CHARACTER_CODE_SMALL_O 17
+/** Display a 'P' letter. */
+#define SCREEN_CHARACTER_CODE_P 18
+
+/** Add this flag to a character code to light the decimal point at the right of the character. */
+#define SCREEN_CHARACTER_FLAG_DOT 0x80
+
+/** How many brightness levels are available. The level 0 lights the displays for 1/8 of the time, each next level doubling the lit time until the last one which keeps the displays lit. */
+#define SCREEN_BRIGHTNESS_LEVELS_COUNT 4
+
+/** The segments of the Digital Thermometer 2 board, from the top one clockwise then the middle one, are wired to RC0, RC2, RC4, RC5, RC3, RC1 and RC6, the decimal point being wired to RC7. */
+#define SCREEN_WIRING_DIGITAL_THERMOMETER_2 0
+/** The segments, from the top one clockwise then the middle one, are wired to RC0 to RC6 in order, the decimal point being wired to RC7. */
+#define SCREEN_WIRING_SEQUENTIAL 1
+
+#ifndef SCREEN_WIRING
+	/** How the 7-segment displays segments are wired to the data port (all segments being active low), the characters fonts are built from it. */
+	#define SCREEN_WIRING SCREEN_WIRING_DIGITAL_THERMOMETER_2
+#endif
+
+#ifndef SCREEN_BRIGHTNESS_DEFAULT_LEVEL
+	/** The brightness level used when the thermometer is powered up. */
+	#define SCREEN_BRIGHTNESS_DEFAULT_LEVEL (SCREEN_BRIGHTNESS_LEVELS_COUNT - 1)
+#endif
+
+#ifndef SCREEN_DIMMING_TIMEOUT
+	/** How many seconds the screen keeps the selected brightness after the last user action, before switching to the lowest brightness level (set to 0 to never dim the screen). */
+	#define SCREEN_DIMMING_TIMEOUT 30
+#endif
+
 //--------------------------------------------------------------------------------------------------
 // Functions
 //--------------------------------------------------------------------------------------------------
-/** Initialize the screen and shut it off. */
+/** Initialize the screen and enable its refresh. The timer module must be initialized before. */
 void ScreenInitialize(void);
 
-/** Refresh the displayed data.
- * @note This function must be called at a 120Hz rate.
+/** Refresh the displayed data. Nothing is done when the module is in low power mode.
+ * @note This function must be called at a 122Hz rate by the high priority Timer 0 interrupt.
  */
 void ScreenRefresh(void);
 
+/** Turn the displays off until the next refresh to lower the brightness.
+ * @note This function must be called by the high priority Timer 3 interrupt.
+ */
+void ScreenBlank(void);
+
 /** Display data.
  * @param Left_Character_Code The leftmost character code.
  * @param Right_Character_Code The rightmost character code.
- * @note Use the SCREEN_DIGIT_CODE_xxx values or the numbers from 0 to 9 to represent the digits.
+ * @note Use the SCREEN_CHARACTER_CODE_xxx values (the minus sign, the empty character and some letters) or the numbers from 0 to 9 to represent the digits, optionally combined with SCREEN_CHARACTER_FLAG_DOT.
+ * @note The refresh interrupt is never masked, the new characters are written to a back frame that replaces the displayed one with a single byte write. Nothing is written when the characters are already displayed. This function must not be called from an interrupt handler.
  */
 void ScreenSetDisplayedCharacters(unsigned char Left_Character_Code, unsigned char Right_Character_Code);
 
+/** Select the brightness of the displays.
+ * @param Level The brightness level, from 0 (the dimmest) to SCREEN_BRIGHTNESS_LEVELS_COUNT - 1 (the brightest).
+ */
+void ScreenSetBrightness(unsigned char Level);
+
+/** Get the selected brightness level.
+ * @return The level set by ScreenSetBrightness(), even if the screen is dimmed.
+ */
+unsigned char ScreenGetBrightness(void);
+
+/** Restore the selected brightness if the screen has been dimmed and restart the dimming timeout. Call it on each user action. */
+void ScreenResetDimmingTimeout(void);
+
+/** Tell how much the displays are lit, to account their current.
+ * @return The lit segments count of both displays (decimal points included) multiplied by their lit time in eighths of the brightest level lit time, or 0 when the module is in low power mode.
+ * @note This function must be called by the low priority interrupt handler.
+ */
+unsigned char ScreenGetLitSegmentsLoad(void);
+
 /** Enable or disable screen module to save power.
  * @param Is_Low_Power_Enabled Set to 1 to enable low power mode or to 0 to wake up the module.
  */
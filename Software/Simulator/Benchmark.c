@@ -0,0 +1,435 @@
+/** @file Benchmark.c
+ * Run the firmware in the simulator through several usage scenarios and report the battery charge consumption, the interrupts cost, the stack depth, the wake-ups rate, the data EEPROM wear, the temperature history compression, the firmware energy accounting and the telemetry stream of each one. The telemetry bytes sent on the simulated serial line are decoded back to check the frames integrity, and the firmware diagnostics (when they are built in) are shown next to the simulator measurements.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "Decoder.h"
+#include "Diagnostics.h"
+#include "Energy.h"
+#include "History.h"
+#include "Simulator.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+/** How many seconds last one day. */
+#define BENCHMARK_SECONDS_PER_DAY 86400.0
+
+/** How many times a data EEPROM cell can be written (the PIC18F13K22 guaranteed minimum). */
+#define BENCHMARK_EEPROM_CELL_ENDURANCE 100000.0
+
+/** How many seconds separate two values of the living room trace. */
+#define BENCHMARK_LIVING_ROOM_TRACE_PERIOD 1800.0
+/** How many seconds separate two values of the window opening trace. */
+#define BENCHMARK_WINDOW_OPENING_TRACE_PERIOD 60.0
+
+//--------------------------------------------------------------------------------------------------
+// Private types
+//--------------------------------------------------------------------------------------------------
+/** A growing bytes buffer. */
+typedef struct
+{
+	unsigned char *Pointer_Bytes; //!< The bytes, NULL until the first byte is appended.
+	unsigned long Count; //!< How many bytes are stored.
+	unsigned long Size; //!< How many bytes the buffer can hold.
+} TBenchmarkBytes;
+
+/** A growing decoded frames list. */
+typedef struct
+{
+	TDecoderFrame *Pointer_Frames; //!< The frames, NULL until the first frame is appended.
+	unsigned long Count; //!< How many frames are stored.
+	unsigned long Size; //!< How many frames the list can hold.
+} TBenchmarkFrames;
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** A heated living room temperature during one day, starting at midnight (one value every 30 minutes). The heating runs from 6h to 9h and from 17h to 23h. */
+static const double Benchmark_Living_Room_Trace[] =
+{
+	19.2, 19.1, 19.0, 18.9, 18.8, 18.7, 18.6, 18.6, 18.5, 18.4, 18.4, 18.3, // 0h-5h30
+	18.9, 19.8, 20.5, 20.9, 21.1, 21.2, // 6h-8h30
+	21.0, 20.8, 20.6, 20.5, 20.4, 20.4, 20.5, 20.6, 20.8, 20.9, 21.0, 21.0, 20.9, 20.8, 20.6, 20.4, // 9h-16h30
+	20.9, 21.4, 21.7, 21.8, 21.9, 21.9, 22.0, 22.0, 21.9, 21.9, 21.8, 21.8, // 17h-22h30
+	21.0, 20.3, 19.2 // 23h-24h
+};
+
+/** A room whose window is opened for 20 minutes after 10 minutes (one value per minute during one hour). */
+static const double Benchmark_Window_Opening_Trace[] =
+{
+	21.3, 21.3, 21.3, 21.3, 21.3, 21.3, 21.3, 21.3, 21.3, 21.3, // Window closed
+	20.6, 19.8, 19.1, 18.5, 18.0, 17.6, 17.2, 16.9, 16.7, 16.5, 16.3, 16.2, 16.1, 16.0, 15.9, 15.9, 15.8, 15.8, 15.8, 15.7, // Window opened
+	16.4, 17.2, 17.9, 18.5, 19.0, 19.4, 19.8, 20.1, 20.3, 20.5, 20.7, 20.8, 20.9, 21.0, 21.1, 21.1, 21.2, 21.2, 21.2, 21.3, // Heating back
+	21.3, 21.3, 21.3, 21.3, 21.3, 21.3, 21.3, 21.3, 21.3, 21.3, 21.3
+};
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** A room with a stable temperature.
+ * @param Time The time in seconds.
+ * @return The temperature in Celsius degrees.
+ */
+static double BenchmarkTemperatureStable(double)
+{
+	return 21.3;
+}
+
+/** A room whose temperature sits on a displayed degree boundary, so the noise makes the samples alternate between two displayed values.
+ * @param Time The time in seconds.
+ * @return The temperature in Celsius degrees.
+ */
+static double BenchmarkTemperatureDegreeBoundary(double)
+{
+	return 22.0;
+}
+
+/** A room whose temperature follows the day and night cycle.
+ * @param Time The time in seconds.
+ * @return The temperature in Celsius degrees.
+ */
+static double BenchmarkTemperatureDailyCycle(double Time)
+{
+	return 18 + 5 * sin(2 * M_PI * Time / BENCHMARK_SECONDS_PER_DAY);
+}
+
+/** Linearly interpolate a temperature trace.
+ * @param Pointer_Trace The trace values.
+ * @param Values_Count How many values the trace contains.
+ * @param Period How many seconds separate two values.
+ * @param Time The time in seconds.
+ * @return The temperature in Celsius degrees (the last trace value is kept after the trace end).
+ */
+static double BenchmarkInterpolateTrace(const double *Pointer_Trace, unsigned int Values_Count, double Period, double Time)
+{
+	unsigned int Index = (unsigned int) (Time / Period);
+	double Fraction;
+
+	if (Index >= Values_Count - 1) return Pointer_Trace[Values_Count - 1];
+	Fraction = Time / Period - Index;
+	return Pointer_Trace[Index] + (Pointer_Trace[Index + 1] - Pointer_Trace[Index]) * Fraction;
+}
+
+/** A heated living room, the same day being repeated.
+ * @param Time The time in seconds.
+ * @return The temperature in Celsius degrees.
+ */
+static double BenchmarkTemperatureLivingRoom(double Time)
+{
+	return BenchmarkInterpolateTrace(Benchmark_Living_Room_Trace, sizeof(Benchmark_Living_Room_Trace) / sizeof(Benchmark_Living_Room_Trace[0]), BENCHMARK_LIVING_ROOM_TRACE_PERIOD, fmod(Time, BENCHMARK_SECONDS_PER_DAY));
+}
+
+/** A room whose window is opened for a while.
+ * @param Time The time in seconds.
+ * @return The temperature in Celsius degrees.
+ */
+static double BenchmarkTemperatureWindowOpening(double Time)
+{
+	return BenchmarkInterpolateTrace(Benchmark_Window_Opening_Trace, sizeof(Benchmark_Window_Opening_Trace) / sizeof(Benchmark_Window_Opening_Trace[0]), BENCHMARK_WINDOW_OPENING_TRACE_PERIOD, Time);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** All benchmarked scenarios. */
+static const TSimulatorScenario Benchmark_Scenarios[] =
+{
+	{"Always displaying current temperature", 600, {0, 0, 0, 0}, BenchmarkTemperatureStable, 1, 3.0},
+	{"Sleep for 24 hours", 86400, {1000, 1, 0, 1500}, BenchmarkTemperatureDailyCycle, 1, 3.0}, // A long press puts the thermometer to sleep
+	{"Button pushed every 10 seconds", 600, {10000, SIMULATOR_BUTTON_PRESSES_UNLIMITED, 10000, 150}, BenchmarkTemperatureStable, 1, 3.0},
+	{"Displaying a window opening", 3600, {0, 0, 0, 0}, BenchmarkTemperatureWindowOpening, 1, 3.0},
+	{"Sleep for 24 hours in a heated living room", 86400, {1000, 1, 0, 1500}, BenchmarkTemperatureLivingRoom, 1, 3.0},
+	{"Displaying with a low battery", 600, {0, 0, 0, 0}, BenchmarkTemperatureStable, 1, 2.6},
+	{"Displaying a noisy temperature on a degree boundary", 600, {0, 0, 0, 0}, BenchmarkTemperatureDegreeBoundary, 8, 3.0},
+	{"Sleep for 3 days in a heated living room", 259200, {1000, 1, 0, 1500}, BenchmarkTemperatureLivingRoom, 1, 3.0} // Long enough to fill the history ring
+};
+
+/** The bytes read by the receiver connected to the telemetry serial line. */
+static TBenchmarkBytes Benchmark_Telemetry_Received_Bytes;
+
+/** The bytes the firmware wrote to the transmit register, the log the received stream is checked against. */
+static TBenchmarkBytes Benchmark_Telemetry_Transmitted_Bytes;
+
+/** The list the frame decoder callback appends the frames to. */
+static TBenchmarkFrames *Pointer_Benchmark_Decoded_Frames;
+
+/** The consumers name. */
+static const char *Benchmark_Consumer_Names[SIMULATOR_CONSUMERS_COUNT] = {"Core", "Display", "Leds", "FVR", "ADC", "Comparator", "Sensor", "EEPROM"};
+
+/** The firmware energy accounting power states name. */
+static const char *Benchmark_Energy_Consumer_Names[ENERGY_CONSUMERS_COUNT] = {"running", "display", "standby", "measurements"};
+
+/** The power modes name. */
+static const char *Benchmark_Power_Mode_Names[SIMULATOR_POWER_MODES_COUNT] = {"run", "idle", "sleep"};
+
+#if DIAGNOSTICS_IS_ENABLED
+/** The firmware diagnostics interrupt sources name. */
+static const char *Benchmark_Diagnostics_Source_Names[DIAGNOSTICS_SOURCES_COUNT] =
+{
+	"Timer 0",
+	"Timer 3",
+	"Timer 2",
+	"ADC",
+#if TELEMETRY_IS_ENABLED
+	"EUSART TX"
+#endif
+};
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Append a byte to a buffer, growing it when it is full.
+ * @param Pointer_Buffer The buffer.
+ * @param Byte The byte to append.
+ */
+static void BenchmarkAppendByte(TBenchmarkBytes *Pointer_Buffer, unsigned char Byte)
+{
+	if (Pointer_Buffer->Count == Pointer_Buffer->Size)
+	{
+		Pointer_Buffer->Size += 65536;
+		Pointer_Buffer->Pointer_Bytes = (unsigned char *) realloc(Pointer_Buffer->Pointer_Bytes, Pointer_Buffer->Size);
+		if (Pointer_Buffer->Pointer_Bytes == NULL)
+		{
+			fprintf(stderr, "Error : could not allocate the telemetry buffer.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	Pointer_Buffer->Pointer_Bytes[Pointer_Buffer->Count] = Byte;
+	Pointer_Buffer->Count++;
+}
+
+/** Store a byte read on the telemetry serial line, the stream is decoded after the run because the decoder uses the firmware CRC code, which would consume simulated cycles.
+ * @param Byte The received byte.
+ */
+static void BenchmarkReceiveTelemetryByte(unsigned char Byte)
+{
+	BenchmarkAppendByte(&Benchmark_Telemetry_Received_Bytes, Byte);
+}
+
+/** Store a byte the firmware wrote to the transmit register.
+ * @param Byte The transmitted byte.
+ */
+static void BenchmarkTransmitTelemetryByte(unsigned char Byte)
+{
+	BenchmarkAppendByte(&Benchmark_Telemetry_Transmitted_Bytes, Byte);
+}
+
+/** Append a decoded frame to the list selected by Pointer_Benchmark_Decoded_Frames.
+ * @param Pointer_Frame The frame.
+ */
+static void BenchmarkStoreDecodedFrame(const TDecoderFrame *Pointer_Frame)
+{
+	TBenchmarkFrames *Pointer_List = Pointer_Benchmark_Decoded_Frames;
+
+	if (Pointer_List->Count == Pointer_List->Size)
+	{
+		Pointer_List->Size += 4096;
+		Pointer_List->Pointer_Frames = (TDecoderFrame *) realloc(Pointer_List->Pointer_Frames, Pointer_List->Size * sizeof(TDecoderFrame));
+		if (Pointer_List->Pointer_Frames == NULL)
+		{
+			fprintf(stderr, "Error : could not allocate the telemetry frames list.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	memcpy(&Pointer_List->Pointer_Frames[Pointer_List->Count], Pointer_Frame, sizeof(TDecoderFrame)); // The decoder clears the frame padding, so the frames can be compared with memcmp()
+	Pointer_List->Count++;
+}
+
+/** Decode a telemetry stream.
+ * @param Pointer_Bytes The stream.
+ * @param Pointer_Decoder On output, contain the decoder statistics.
+ * @param Pointer_Frames On output, contain the decoded frames.
+ */
+static void BenchmarkDecodeTelemetry(const TBenchmarkBytes *Pointer_Bytes, TDecoder *Pointer_Decoder, TBenchmarkFrames *Pointer_Frames)
+{
+	unsigned long i;
+
+	memset(Pointer_Frames, 0, sizeof(TBenchmarkFrames));
+	Pointer_Benchmark_Decoded_Frames = Pointer_Frames;
+	DecoderInitialize(Pointer_Decoder, BenchmarkStoreDecodedFrame);
+	for (i = 0; i < Pointer_Bytes->Count; i++) DecoderProcessByte(Pointer_Decoder, Pointer_Bytes->Pointer_Bytes[i]);
+}
+
+/** Check that the serial line delivered all frames the firmware transmitted : no framing error, and the same frames (sequence number, type and payload) in the same order.
+ * @param Pointer_Statistics The run measurements.
+ * @return 0 if the stream is intact,
+ * @return -1 if a byte or a frame was lost or corrupted.
+ */
+static int BenchmarkCheckTelemetry(const TSimulatorStatistics *Pointer_Statistics)
+{
+	TDecoder Received_Decoder, Transmitted_Decoder;
+	TBenchmarkFrames Received_Frames, Transmitted_Frames;
+	unsigned long i;
+	int Return_Value = 0;
+
+	BenchmarkDecodeTelemetry(&Benchmark_Telemetry_Received_Bytes, &Received_Decoder, &Received_Frames);
+	BenchmarkDecodeTelemetry(&Benchmark_Telemetry_Transmitted_Bytes, &Transmitted_Decoder, &Transmitted_Frames);
+	printf("Telemetry       : %.1f bytes per hour, line powered %.3f%% of the time, %lu frames decoded out of %lu transmitted, %lu lost, %lu corrupted, %lu undecodable differences, %lu framing errors\n", Pointer_Statistics->UART_Bytes_Count / (Pointer_Statistics->Duration / 3600), 100 * Pointer_Statistics->UART_Enabled_Time / Pointer_Statistics->Duration, Received_Decoder.Statistics.Frames_Count, Transmitted_Decoder.Statistics.Frames_Count, Received_Decoder.Statistics.Lost_Frames_Count, Received_Decoder.Statistics.Corrupted_Frames_Count, Received_Decoder.Statistics.Undecodable_Deltas_Count, Pointer_Statistics->UART_Framing_Errors_Count);
+
+	if (Pointer_Statistics->UART_Framing_Errors_Count > 0)
+	{
+		printf("Error : %lu telemetry bytes were corrupted on the serial line.\n", Pointer_Statistics->UART_Framing_Errors_Count);
+		Return_Value = -1;
+	}
+
+	// The transmitted frames log starts with the first frame, so a missing first frame is found too
+	for (i = 0; (i < Received_Frames.Count) && (i < Transmitted_Frames.Count); i++)
+	{
+		if (memcmp(&Received_Frames.Pointer_Frames[i], &Transmitted_Frames.Pointer_Frames[i], sizeof(TDecoderFrame)) != 0)
+		{
+			printf("Error : received telemetry frame %lu (sequence %u, type %d) differs from the transmitted one (sequence %u, type %d).\n", i, Received_Frames.Pointer_Frames[i].Sequence, Received_Frames.Pointer_Frames[i].Type, Transmitted_Frames.Pointer_Frames[i].Sequence, Transmitted_Frames.Pointer_Frames[i].Type);
+			Return_Value = -1;
+			break;
+		}
+	}
+	if (Received_Frames.Count != Transmitted_Frames.Count)
+	{
+		printf("Error : %lu telemetry frames were received instead of %lu.\n", Received_Frames.Count, Transmitted_Frames.Count);
+		Return_Value = -1;
+	}
+
+	free(Received_Frames.Pointer_Frames);
+	free(Transmitted_Frames.Pointer_Frames);
+	return Return_Value;
+}
+
+/** Display a run results.
+ * @param Pointer_Scenario The simulated scenario.
+ * @param Pointer_Statistics The run measurements.
+ * @return 0 if the run results are consistent,
+ * @return -1 if the telemetry stream was damaged.
+ */
+static int BenchmarkDisplayStatistics(const TSimulatorScenario *Pointer_Scenario, const TSimulatorStatistics *Pointer_Statistics)
+{
+	double Total_Charge = 0, Accounted_Charge = 0, Hours = Pointer_Statistics->Duration / 3600, Days = Pointer_Statistics->Duration / BENCHMARK_SECONDS_PER_DAY;
+	unsigned long Maximum_Cell_Writes_Count = 0;
+	int i, Return_Value = 0;
+
+	for (i = 0; i < SIMULATOR_CONSUMERS_COUNT; i++) Total_Charge += Pointer_Statistics->Charge[i];
+
+	printf("=== %s (%.0f s simulated)\n", Pointer_Scenario->Pointer_String_Name, Pointer_Statistics->Duration);
+	printf("Average current : %.1f uA\n", Total_Charge / Pointer_Statistics->Duration);
+	printf("Battery charge  : %.1f uAh/day\n", Total_Charge / 3600 / Days);
+	for (i = 0; i < SIMULATOR_CONSUMERS_COUNT; i++) printf("  %-10s : %.1f uAh/day, %.1f uA\n", Benchmark_Consumer_Names[i], Pointer_Statistics->Charge[i] / 3600 / Days, Pointer_Statistics->Charge[i] / Pointer_Statistics->Duration);
+
+	printf("Power modes     :");
+	for (i = 0; i < SIMULATOR_POWER_MODES_COUNT; i++) printf(" %s %.3f%%", Benchmark_Power_Mode_Names[i], 100 * Pointer_Statistics->Power_Mode_Time[i] / Pointer_Statistics->Duration);
+	printf("\n");
+	printf("Wake-ups        : %.1f per hour\n", Pointer_Statistics->Wakeups_Count / Hours);
+	printf("Conversions     : %.1f per hour\n", Pointer_Statistics->Conversions_Count / Hours);
+	if (Pointer_Statistics->Refreshes_Count > 0) printf("Refresh delay   : %.1f to %.1f us after the tick, jitter %.1f us\n", Pointer_Statistics->Refresh_Minimum_Delay / 1e6, Pointer_Statistics->Refresh_Maximum_Delay / 1e6, (Pointer_Statistics->Refresh_Maximum_Delay - Pointer_Statistics->Refresh_Minimum_Delay) / 1e6);
+	if (Pointer_Statistics->Refreshes_Count > 0) printf("Display changes : %.1f per hour\n", Pointer_Statistics->Display_Changes_Count * 3600.0 / Pointer_Statistics->Duration);
+	if (Pointer_Statistics->Fixed_Voltage_Reference_Enables_Count > 0) printf("FVR power-ups   : %.1f per hour, %.3f ms each\n", Pointer_Statistics->Fixed_Voltage_Reference_Enables_Count / Hours, 1000 * Pointer_Statistics->Fixed_Voltage_Reference_Time / Pointer_Statistics->Fixed_Voltage_Reference_Enables_Count);
+
+	// Project the most written cell wear, only for the scenarios long enough to make the rings wrap around (the first writes of a blank ring hit the same cells)
+	if (Pointer_Statistics->EEPROM_Writes_Count > 0)
+	{
+		for (i = 0; i < SIMULATOR_EEPROM_SIZE; i++)
+		{
+			if (Pointer_Statistics->EEPROM_Cell_Writes_Count[i] > Maximum_Cell_Writes_Count) Maximum_Cell_Writes_Count = Pointer_Statistics->EEPROM_Cell_Writes_Count[i];
+		}
+		if (Days < 1) printf("EEPROM writes   : %lu bytes, most written cell %lu times\n", Pointer_Statistics->EEPROM_Writes_Count, Maximum_Cell_Writes_Count);
+		else printf("EEPROM writes   : %.1f bytes per day, most written cell %.1f times per day (%.0f years to %.0f cycles)\n", Pointer_Statistics->EEPROM_Writes_Count / Days, Maximum_Cell_Writes_Count / Days, BENCHMARK_EEPROM_CELL_ENDURANCE / (Maximum_Cell_Writes_Count / Days) / 365, BENCHMARK_EEPROM_CELL_ENDURANCE);
+	}
+
+	// Compare the history size with the same samples stored as 16-bit tenths of Celsius degrees, the history module data being read from the firmware run in this process
+	if (HistoryGetStoredSize() > 0) printf("History         : %u samples (%.1f hours) in %u bytes, compression ratio %.1f\n", HistoryGetSamplesCount(), HistoryGetSamplesCount() * HISTORY_SAMPLING_PERIOD / 60.0, HistoryGetStoredSize(), 2.0 * HistoryGetSamplesCount() / HistoryGetStoredSize());
+
+	// Compare the firmware energy accounting with the simulated currents, the accounting being read from the firmware run in this process (its charge units are 16uAs)
+	if (EnergyReadElapsedTime() > 0)
+	{
+		for (i = 0; i < ENERGY_CONSUMERS_COUNT; i++) Accounted_Charge += EnergyReadConsumedCharge((TEnergyConsumer) i) * 16.0;
+		printf("Energy account  : %.1f uA over %lu s (", Accounted_Charge / EnergyReadElapsedTime(), EnergyReadElapsedTime());
+		for (i = 0; i < ENERGY_CONSUMERS_COUNT; i++) printf("%s%s %.1f", i > 0 ? ", " : "", Benchmark_Energy_Consumer_Names[i], EnergyReadConsumedCharge((TEnergyConsumer) i) * 16.0 / EnergyReadElapsedTime());
+		printf(" uA)\n");
+	}
+
+	// Decode the whole stream received during the run
+	if ((Pointer_Statistics->UART_Bytes_Count > 0) && (BenchmarkCheckTelemetry(Pointer_Statistics) != 0)) Return_Value = -1;
+
+	printf("Interrupts      : source         per hour  average cycles  maximum cycles\n");
+	for (i = 0; i < SIMULATOR_INTERRUPT_SOURCES_COUNT; i++)
+	{
+		if (Pointer_Statistics->Interrupt_Count[i] == 0) continue;
+		printf("                  %-12s %10.1f %15.1f %15lu\n", Simulator_Interrupt_Source_Names[i], Pointer_Statistics->Interrupt_Count[i] / Hours, (double) Pointer_Statistics->Interrupt_Cycles[i] / Pointer_Statistics->Interrupt_Count[i], Pointer_Statistics->Interrupt_Maximum_Cycles[i]);
+	}
+	printf("Stack depth     : %u return addresses at most, %u available%s\n", Pointer_Statistics->Stack_Maximum_Depth, SIMULATOR_STACK_SIZE, Pointer_Statistics->Stack_Maximum_Depth > SIMULATOR_STACK_SIZE ? " (overflow)" : "");
+
+#if DIAGNOSTICS_IS_ENABLED
+	// The firmware times only its handler branches, without the interrupt entry and exit, the diagnostics module data being read from the firmware run in this process
+	if (DiagnosticsReadValue(DIAGNOSTICS_VALUE_STACK_DEPTH) == DIAGNOSTICS_STACK_OVERFLOWED) printf("Diagnostics     : stack overflowed");
+	else printf("Diagnostics     : stack depth %lu", DiagnosticsReadValue(DIAGNOSTICS_VALUE_STACK_DEPTH));
+	printf(", %lu minutes running, %lu minutes in standby, wake-ups by the timer %lu, the button %lu\n", DiagnosticsReadValue(DIAGNOSTICS_VALUE_RUNNING_MINUTES), DiagnosticsReadValue(DIAGNOSTICS_VALUE_STANDBY_MINUTES), DiagnosticsReadValue(DIAGNOSTICS_VALUE_WAKE_UPS + DIAGNOSTICS_WAKE_UP_SOURCE_TIMER), DiagnosticsReadValue(DIAGNOSTICS_VALUE_WAKE_UPS + DIAGNOSTICS_WAKE_UP_SOURCE_BUTTON));
+	printf("                  source            count  average cycles  maximum cycles\n");
+	for (i = 0; i < DIAGNOSTICS_SOURCES_COUNT; i++) printf("                  %-12s %10lu %15lu %15lu\n", Benchmark_Diagnostics_Source_Names[i], DiagnosticsReadValue(DIAGNOSTICS_VALUE_INTERRUPTS + 3 * i), DiagnosticsReadValue(DIAGNOSTICS_VALUE_INTERRUPTS + 3 * i + 1), DiagnosticsReadValue(DIAGNOSTICS_VALUE_INTERRUPTS + 3 * i + 2));
+#endif
+	printf("\n");
+
+	return Return_Value;
+}
+
+/** Simulate a scenario in a child process, because the firmware static variables can't be reset between runs.
+ * @param Pointer_Scenario The scenario to simulate.
+ * @return 0 on success,
+ * @return -1 if the simulation failed.
+ */
+static int BenchmarkRunScenario(const TSimulatorScenario *Pointer_Scenario)
+{
+	TSimulatorStatistics Statistics;
+	pid_t Process_ID;
+	int Status;
+
+	fflush(stdout);
+	Process_ID = fork();
+	if (Process_ID < 0)
+	{
+		perror("fork");
+		return -1;
+	}
+
+	// Child process
+	if (Process_ID == 0)
+	{
+		SimulatorSetUARTReceiver(BenchmarkReceiveTelemetryByte);
+		SimulatorSetUARTTransmitMonitor(BenchmarkTransmitTelemetryByte);
+		SimulatorRun(Pointer_Scenario, &Statistics);
+		Status = BenchmarkDisplayStatistics(Pointer_Scenario, &Statistics);
+		fflush(stdout);
+		_exit(Status == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// Parent process
+	if ((waitpid(Process_ID, &Status, 0) < 0) || !WIFEXITED(Status) || (WEXITSTATUS(Status) != EXIT_SUCCESS))
+	{
+		printf("Error : scenario \"%s\" failed.\n", Pointer_Scenario->Pointer_String_Name);
+		return -1;
+	}
+	return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Entry point
+//--------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	unsigned int i, Scenarios_Count = sizeof(Benchmark_Scenarios) / sizeof(Benchmark_Scenarios[0]);
+	int Return_Value = EXIT_SUCCESS;
+
+	for (i = 0; i < Scenarios_Count; i++)
+	{
+		// Run only the scenarios whose name contains the optional filter
+		if ((argc > 1) && (strstr(Benchmark_Scenarios[i].Pointer_String_Name, argv[1]) == NULL)) continue;
+
+		if (BenchmarkRunScenario(&Benchmark_Scenarios[i]) != 0) Return_Value = EXIT_FAILURE;
+	}
+
+	return Return_Value;
+}
@@ -0,0 +1,169 @@
+/** @file Decoder.c
+ * @see Decoder.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <stddef.h>
+#include <string.h>
+#include "CRC.h"
+#include "Decoder.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Get a frame size from its type.
+ * @param Type The frame type.
+ * @return The frame size in bytes, or 0 if the type is unknown.
+ */
+static unsigned char DecoderGetFrameSize(unsigned char Type)
+{
+	switch (Type)
+	{
+		case TELEMETRY_FRAME_TYPE_TEMPERATURES:
+			return 2 * ADC_TEMPERATURE_SENSORS_COUNT + 3;
+
+		case TELEMETRY_FRAME_TYPE_TEMPERATURE_DELTAS:
+			return ADC_TEMPERATURE_SENSORS_COUNT + 3;
+
+		case TELEMETRY_FRAME_TYPE_PEAKS:
+			return 4 * ADC_TEMPERATURE_SENSORS_COUNT + 3;
+
+		case TELEMETRY_FRAME_TYPE_BATTERY_VOLTAGE:
+			return 2 + 3;
+
+		case TELEMETRY_FRAME_TYPE_STATE:
+			return 1 + 3;
+
+		default:
+			return 0;
+	}
+}
+
+/** Read a 16-bit value from a frame payload (the low byte comes first).
+ * @param Pointer_Bytes The value bytes.
+ * @return The value.
+ */
+static inline unsigned short DecoderReadWord(const unsigned char *Pointer_Bytes)
+{
+	return Pointer_Bytes[0] | (Pointer_Bytes[1] << 8);
+}
+
+/** Decode a frame whose CRC is valid.
+ * @param Pointer_Decoder The decoder.
+ */
+static void DecoderHandleFrame(TDecoder *Pointer_Decoder)
+{
+	TDecoderFrame Frame;
+	const unsigned char *Pointer_Payload = &Pointer_Decoder->Frame_Buffer[2];
+	int i;
+
+	memset(&Frame, 0, sizeof(Frame));
+	Frame.Type = (TTelemetryFrameType) (Pointer_Decoder->Frame_Buffer[1] >> 5);
+	Frame.Sequence = Pointer_Decoder->Frame_Buffer[1] & TELEMETRY_SEQUENCE_MASK;
+	Pointer_Decoder->Statistics.Frames_Count++;
+
+	// A missing frame may be a differences frame, so the rebuilt temperatures can't be trusted anymore
+	if ((Pointer_Decoder->Next_Sequence >= 0) && (Frame.Sequence != Pointer_Decoder->Next_Sequence))
+	{
+		Pointer_Decoder->Statistics.Lost_Frames_Count += (Frame.Sequence - Pointer_Decoder->Next_Sequence) & TELEMETRY_SEQUENCE_MASK;
+		Pointer_Decoder->Is_Temperatures_Valid = 0;
+	}
+	Pointer_Decoder->Next_Sequence = (Frame.Sequence + 1) & TELEMETRY_SEQUENCE_MASK;
+
+	switch (Frame.Type)
+	{
+		case TELEMETRY_FRAME_TYPE_TEMPERATURES:
+			for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++) Pointer_Decoder->Temperatures[i] = (signed short) DecoderReadWord(&Pointer_Payload[2 * i]);
+			Pointer_Decoder->Is_Temperatures_Valid = 1;
+			break;
+
+		case TELEMETRY_FRAME_TYPE_TEMPERATURE_DELTAS:
+			if (Pointer_Decoder->Is_Temperatures_Valid)
+			{
+				for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++) Pointer_Decoder->Temperatures[i] += (signed char) Pointer_Payload[i];
+			}
+			else Pointer_Decoder->Statistics.Undecodable_Deltas_Count++;
+			break;
+
+		case TELEMETRY_FRAME_TYPE_PEAKS:
+			for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++)
+			{
+				Frame.Maximum_Temperatures[i] = (signed short) DecoderReadWord(&Pointer_Payload[4 * i]);
+				Frame.Minimum_Temperatures[i] = (signed short) DecoderReadWord(&Pointer_Payload[4 * i + 2]);
+			}
+			break;
+
+		case TELEMETRY_FRAME_TYPE_BATTERY_VOLTAGE:
+			Frame.Battery_Voltage_Value = DecoderReadWord(Pointer_Payload);
+			break;
+
+		default:
+			Frame.State = Pointer_Payload[0];
+			break;
+	}
+
+	memcpy(Frame.Temperatures, Pointer_Decoder->Temperatures, sizeof(Frame.Temperatures));
+	Frame.Is_Temperatures_Valid = Pointer_Decoder->Is_Temperatures_Valid;
+	if (Pointer_Decoder->Frame_Callback != NULL) Pointer_Decoder->Frame_Callback(&Frame);
+}
+
+/** Drop the first byte of an invalid frame and look for a frame start in the following bytes.
+ * @param Pointer_Decoder The decoder.
+ */
+static void DecoderResynchronize(TDecoder *Pointer_Decoder)
+{
+	unsigned char Bytes[DECODER_MAXIMUM_FRAME_SIZE], Bytes_Count = Pointer_Decoder->Frame_Bytes_Count;
+	int i;
+
+	memcpy(Bytes, Pointer_Decoder->Frame_Buffer, Bytes_Count);
+	Pointer_Decoder->Frame_Bytes_Count = 0;
+	Pointer_Decoder->Statistics.Skipped_Bytes_Count++;
+	for (i = 1; i < Bytes_Count; i++) DecoderProcessByte(Pointer_Decoder, Bytes[i]);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void DecoderInitialize(TDecoder *Pointer_Decoder, TDecoderFrameCallback Frame_Callback)
+{
+	memset(Pointer_Decoder, 0, sizeof(TDecoder));
+	Pointer_Decoder->Next_Sequence = -1;
+	Pointer_Decoder->Frame_Callback = Frame_Callback;
+}
+
+void DecoderProcessByte(TDecoder *Pointer_Decoder, unsigned char Byte)
+{
+	unsigned char Frame_Size, CRC = 0;
+	int i;
+
+	// Wait for a frame start
+	if ((Pointer_Decoder->Frame_Bytes_Count == 0) && (Byte != TELEMETRY_FRAME_START))
+	{
+		Pointer_Decoder->Statistics.Skipped_Bytes_Count++;
+		return;
+	}
+	Pointer_Decoder->Frame_Buffer[Pointer_Decoder->Frame_Bytes_Count] = Byte;
+	Pointer_Decoder->Frame_Bytes_Count++;
+	if (Pointer_Decoder->Frame_Bytes_Count < 2) return;
+
+	// The header tells the frame size
+	Frame_Size = DecoderGetFrameSize(Pointer_Decoder->Frame_Buffer[1] >> 5);
+	if (Frame_Size == 0)
+	{
+		Pointer_Decoder->Statistics.Corrupted_Frames_Count++;
+		DecoderResynchronize(Pointer_Decoder);
+		return;
+	}
+	if (Pointer_Decoder->Frame_Bytes_Count < Frame_Size) return;
+
+	// The CRC covers all the previous bytes
+	for (i = 0; i < Frame_Size - 1; i++) CRC = CRCUpdate(CRC, Pointer_Decoder->Frame_Buffer[i]);
+	if (CRC != Pointer_Decoder->Frame_Buffer[Frame_Size - 1])
+	{
+		Pointer_Decoder->Statistics.Corrupted_Frames_Count++;
+		DecoderResynchronize(Pointer_Decoder);
+		return;
+	}
+
+	DecoderHandleFrame(Pointer_Decoder);
+	Pointer_Decoder->Frame_Bytes_Count = 0;
+}
@@ -0,0 +1,76 @@
+/** @file Decoder.h
+ * Host-side decoder of the firmware telemetry frames. It finds the frames in a byte stream, checks their CRC, counts the lost frames from the sequence numbers and rebuilds the absolute temperatures from the differences frames.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#ifndef H_DECODER_H
+#define H_DECODER_H
+
+#include "ADC.h"
+#include "Telemetry.h"
+
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+/** The largest frame size in bytes (the peaks frame). */
+#define DECODER_MAXIMUM_FRAME_SIZE (4 * ADC_TEMPERATURE_SENSORS_COUNT + 3)
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** A decoded frame, only the fields matching the frame type are meaningful. */
+typedef struct
+{
+	TTelemetryFrameType Type;
+	unsigned char Sequence;
+	signed short Temperatures[ADC_TEMPERATURE_SENSORS_COUNT]; //!< The absolute temperatures (in tenths of Celsius degrees), rebuilt from the previous frames for a differences frame.
+	unsigned char Is_Temperatures_Valid; //!< Set to 0 when a differences frame can't be applied because a previous temperature frame is missing.
+	signed short Maximum_Temperatures[ADC_TEMPERATURE_SENSORS_COUNT];
+	signed short Minimum_Temperatures[ADC_TEMPERATURE_SENSORS_COUNT];
+	unsigned short Battery_Voltage_Value;
+	unsigned char State;
+} TDecoderFrame;
+
+/** Called for each valid frame.
+ * @param Pointer_Frame The decoded frame.
+ */
+typedef void (*TDecoderFrameCallback)(const TDecoderFrame *Pointer_Frame);
+
+/** What the decoder found in the stream. */
+typedef struct
+{
+	unsigned long Frames_Count; //!< How many frames had a valid CRC.
+	unsigned long Lost_Frames_Count; //!< How many frames were missing according to the sequence numbers.
+	unsigned long Corrupted_Frames_Count; //!< How many frames had a bad CRC or an unknown type.
+	unsigned long Skipped_Bytes_Count; //!< How many bytes were dropped while looking for a frame start.
+	unsigned long Undecodable_Deltas_Count; //!< How many differences frames were received without the temperatures they apply to.
+} TDecoderStatistics;
+
+/** A decoder state. */
+typedef struct
+{
+	unsigned char Frame_Buffer[DECODER_MAXIMUM_FRAME_SIZE];
+	unsigned char Frame_Bytes_Count;
+	signed short Temperatures[ADC_TEMPERATURE_SENSORS_COUNT]; //!< The last rebuilt temperatures.
+	unsigned char Is_Temperatures_Valid;
+	int Next_Sequence; //!< The expected sequence number, -1 until the first frame.
+	TDecoderFrameCallback Frame_Callback;
+	TDecoderStatistics Statistics;
+} TDecoder;
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Start decoding a new stream.
+ * @param Pointer_Decoder The decoder.
+ * @param Frame_Callback The function to call for each valid frame, it can be NULL.
+ */
+void DecoderInitialize(TDecoder *Pointer_Decoder, TDecoderFrameCallback Frame_Callback);
+
+/** Feed the next stream byte.
+ * @param Pointer_Decoder The decoder.
+ * @param Byte The received byte.
+ */
+void DecoderProcessByte(TDecoder *Pointer_Decoder, unsigned char Byte);
+
+#endif
@@ -0,0 +1,153 @@
+/** @file Receiver.c
+ * Read the thermometer telemetry frames from a serial port (or from the standard input when no port is provided) and display them.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "Decoder.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The frame types name. */
+static const char *Receiver_Frame_Type_Names[TELEMETRY_FRAME_TYPES_COUNT] = {"temperatures", "differences", "peaks", "battery", "state"};
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Display a temperature.
+ * @param Temperature The temperature in tenths of Celsius degrees.
+ */
+static void ReceiverDisplayTemperature(signed short Temperature)
+{
+	if (Temperature < 0) printf(" -%d.%d", -Temperature / 10, -Temperature % 10);
+	else printf(" %d.%d", Temperature / 10, Temperature % 10);
+}
+
+/** Display a decoded frame.
+ * @param Pointer_Frame The frame.
+ */
+static void ReceiverDisplayFrame(const TDecoderFrame *Pointer_Frame)
+{
+	int i;
+
+	printf("[%2u] %-12s :", Pointer_Frame->Sequence, Receiver_Frame_Type_Names[Pointer_Frame->Type]);
+	switch (Pointer_Frame->Type)
+	{
+		case TELEMETRY_FRAME_TYPE_TEMPERATURES:
+		case TELEMETRY_FRAME_TYPE_TEMPERATURE_DELTAS:
+			if (!Pointer_Frame->Is_Temperatures_Valid)
+			{
+				printf(" unknown (a previous frame is missing)");
+				break;
+			}
+			for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++) ReceiverDisplayTemperature(Pointer_Frame->Temperatures[i]);
+			break;
+
+		case TELEMETRY_FRAME_TYPE_PEAKS:
+			for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++)
+			{
+				printf(" max");
+				ReceiverDisplayTemperature(Pointer_Frame->Maximum_Temperatures[i]);
+				printf(" min");
+				ReceiverDisplayTemperature(Pointer_Frame->Minimum_Temperatures[i]);
+			}
+			break;
+
+		case TELEMETRY_FRAME_TYPE_BATTERY_VOLTAGE:
+			printf(" ADC value %u", Pointer_Frame->Battery_Voltage_Value);
+			break;
+
+		default:
+			printf(" sensor %u, state %u", Pointer_Frame->State >> 4, Pointer_Frame->State & 0x0F);
+			break;
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+/** Configure a serial port to receive raw bytes at the telemetry bit rate.
+ * @param File_Descriptor The serial port.
+ * @return 0 on success,
+ * @return -1 if the port could not be configured.
+ */
+static int ReceiverConfigureSerialPort(int File_Descriptor)
+{
+	struct termios Parameters;
+	speed_t Speed;
+
+	switch (TELEMETRY_BAUD_RATE)
+	{
+		case 1200:
+			Speed = B1200;
+			break;
+
+		case 2400:
+			Speed = B2400;
+			break;
+
+		default:
+			Speed = B4800;
+			break;
+	}
+
+	if (tcgetattr(File_Descriptor, &Parameters) != 0) return -1;
+	cfmakeraw(&Parameters);
+	Parameters.c_iflag |= IGNPAR; // Drop the bytes with a framing error, the decoder finds the next frame
+	Parameters.c_cflag |= CLOCAL | CREAD;
+	cfsetispeed(&Parameters, Speed);
+	cfsetospeed(&Parameters, Speed);
+	if (tcsetattr(File_Descriptor, TCSANOW, &Parameters) != 0) return -1;
+	return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Entry point
+//--------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	TDecoder Decoder;
+	unsigned char Buffer[64];
+	ssize_t Bytes_Count, i;
+	int File_Descriptor = STDIN_FILENO;
+
+	// Open the serial port
+	if (argc > 1)
+	{
+		File_Descriptor = open(argv[1], O_RDONLY | O_NOCTTY);
+		if (File_Descriptor < 0)
+		{
+			printf("Error : could not open \"%s\" (%s).\n", argv[1], strerror(errno));
+			return EXIT_FAILURE;
+		}
+		if (ReceiverConfigureSerialPort(File_Descriptor) != 0)
+		{
+			printf("Error : could not configure \"%s\" (%s).\n", argv[1], strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+
+	DecoderInitialize(&Decoder, ReceiverDisplayFrame);
+	while (1)
+	{
+		Bytes_Count = read(File_Descriptor, Buffer, sizeof(Buffer));
+		if (Bytes_Count < 0)
+		{
+			if (errno == EINTR) continue;
+			printf("Error : could not read the serial port (%s).\n", strerror(errno));
+			return EXIT_FAILURE;
+		}
+		if (Bytes_Count == 0) break; // End of the input file
+
+		for (i = 0; i < Bytes_Count; i++) DecoderProcessByte(&Decoder, Buffer[i]);
+	}
+
+	printf("%lu frames, %lu lost, %lu corrupted, %lu skipped bytes\n", Decoder.Statistics.Frames_Count, Decoder.Statistics.Lost_Frames_Count, Decoder.Statistics.Corrupted_Frames_Count, Decoder.Statistics.Skipped_Bytes_Count);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,1560 @@
+/** @file Simulator.c
+ * @see Simulator.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Simulator.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+/** The clock frequency the firmware delays have been computed for (it must match the firmware CLOCK_FREQ pragma). */
+#define SIMULATOR_FIRMWARE_CLOCK_FREQUENCY 1000000
+
+/** Instruction cycles needed to enter the interrupt handler (hardware latency and BoostC context saving). */
+#define SIMULATOR_INTERRUPT_ENTRY_CYCLES 20
+/** Instruction cycles needed to leave the interrupt handler (BoostC context restoring and RETFIE). */
+#define SIMULATOR_INTERRUPT_EXIT_CYCLES 10
+/** No interrupt handler is running. */
+#define SIMULATOR_INTERRUPT_LEVEL_NONE 0
+/** The low priority interrupt handler is running. */
+#define SIMULATOR_INTERRUPT_LEVEL_LOW 1
+/** The high priority interrupt handler (or the single handler when priorities are disabled) is running. */
+#define SIMULATOR_INTERRUPT_LEVEL_HIGH 2
+
+/** Instruction cycles needed by a CALL or a RETURN instruction. */
+#define SIMULATOR_FUNCTION_CALL_CYCLES 2
+
+/** How long the fixed voltage reference takes to become stable (in picoseconds). */
+#define SIMULATOR_FIXED_VOLTAGE_REFERENCE_SETTLING_TIME 100000000ULL
+/** How long the HFINTOSC takes to become stable after being started (in picoseconds). */
+#define SIMULATOR_HFINTOSC_STARTUP_TIME 10000000ULL
+/** The ADC internal RC oscillator period (in picoseconds). */
+#define SIMULATOR_ADC_FRC_PERIOD 4000000ULL
+/** How many Tad a conversion lasts (acquisition time excluded). */
+#define SIMULATOR_ADC_CONVERSION_TAD 11
+
+/** How often the comparator output is updated while the comparator is enabled, the sensor temperature varying slowly (in picoseconds). */
+#define SIMULATOR_COMPARATOR_SAMPLING_PERIOD 100000000000ULL
+
+/** How long a data EEPROM byte write lasts (in picoseconds). */
+#define SIMULATOR_EEPROM_WRITE_TIME 4000000000ULL
+
+/** The largest bit rate error the serial receiver tolerates (in percent of SIMULATOR_UART_BAUD_RATE). */
+#define SIMULATOR_UART_BAUD_RATE_TOLERANCE 3
+/** How many bits a byte lasts on the serial line (start bit, 8 data bits and stop bit). */
+#define SIMULATOR_UART_BITS_PER_BYTE 10
+
+/** The watchdog timer period, LFINTOSC based 4ms period multiplied by the postscaler (in picoseconds). It must match the firmware WDTPS configuration bits. */
+#define SIMULATOR_WATCHDOG_PERIOD (16384 * 4000000000ULL)
+
+/** Core current in sleep mode (in uA). */
+#define SIMULATOR_CURRENT_CORE_SLEEP 0.1
+/** Watchdog timer current when enabled (in uA). */
+#define SIMULATOR_CURRENT_WATCHDOG 0.5
+/** Fixed voltage reference current when enabled (in uA). */
+#define SIMULATOR_CURRENT_FIXED_VOLTAGE_REFERENCE 15.0
+/** ADC current during a conversion (in uA). */
+#define SIMULATOR_CURRENT_ADC 180.0
+/** Comparator current in low power mode (in uA). */
+#define SIMULATOR_CURRENT_COMPARATOR_LOW_POWER 8.0
+/** Comparator current in normal power mode (in uA). */
+#define SIMULATOR_CURRENT_COMPARATOR_NORMAL_POWER 40.0
+/** DAC current when enabled, drawn by its resistor ladder (in uA). */
+#define SIMULATOR_CURRENT_DAC 30.0
+/** TMP36 quiescent current, the sensor is always powered (in uA). */
+#define SIMULATOR_CURRENT_SENSOR 50.0
+/** Data EEPROM current while a byte is being written (in uA). */
+#define SIMULATOR_CURRENT_EEPROM_WRITE 500.0
+/** Current drawn by a single lit 7-segment display segment (in uA). */
+#define SIMULATOR_CURRENT_SEGMENT 2000.0
+/** Current drawn by a lit state led (in uA). */
+#define SIMULATOR_CURRENT_LED 2000.0
+
+/** A delay value meaning "never". */
+#define SIMULATOR_TIME_NEVER 0xFFFFFFFFFFFFFFFFULL
+
+//--------------------------------------------------------------------------------------------------
+// Private types
+//--------------------------------------------------------------------------------------------------
+/** Identify the simulated timers. */
+typedef enum
+{
+	SIMULATOR_TIMER_0,
+	SIMULATOR_TIMER_1,
+	SIMULATOR_TIMER_3,
+	SIMULATOR_TIMERS_COUNT
+} TSimulatorTimer;
+
+/** Describe where an interrupt source enable and flag bits are located. */
+typedef struct
+{
+	unsigned char Enable_Register_Index;
+	unsigned char Enable_Bit_Index;
+	unsigned char Flag_Register_Index;
+	unsigned char Flag_Bit_Index;
+	unsigned char Priority_Register_Index;
+	unsigned char Priority_Bit_Index;
+	unsigned char Is_Peripheral;
+} TSimulatorInterruptSourceDescription;
+
+/** The position of each register bit name. */
+enum
+{
+	#define SIMULATOR_DECLARE_BIT_POSITION(Name, Position) SIMULATOR_BIT_POSITION_##Name = Position,
+	SIMULATOR_BITS(SIMULATOR_DECLARE_BIT_POSITION)
+	#undef SIMULATOR_DECLARE_BIT_POSITION
+};
+
+/** Thrown when the scenario duration is elapsed to unwind the firmware call stack. */
+typedef struct
+{
+	int Unused;
+} TSimulatorEndOfScenario;
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** HFINTOSC (or LFINTOSC) frequency for each OSCCON.IRCF value. */
+static const unsigned long Simulator_Oscillator_Frequencies[8] = {31000, 250000, 500000, 1000000, 2000000, 4000000, 8000000, 16000000};
+
+/** Core current in run mode for each OSCCON.IRCF value (in uA). */
+static const double Simulator_Core_Run_Currents[8] = {20, 150, 250, 450, 700, 1100, 1900, 3300};
+
+/** Core current in idle mode for each OSCCON.IRCF value (in uA). */
+static const double Simulator_Core_Idle_Currents[8] = {12, 70, 110, 190, 290, 450, 750, 1300};
+
+/** ADC acquisition time in Tad for each ADCON2.ACQT value. */
+static const unsigned char Simulator_ADC_Acquisition_Tad[8] = {0, 2, 4, 6, 8, 12, 16, 20};
+
+/** ADC clock divider for each ADCON2.ADCS value (0 means the dedicated RC oscillator). */
+static const unsigned char Simulator_ADC_Clock_Dividers[8] = {2, 8, 32, 0, 4, 16, 64, 0};
+
+/** Where to find each interrupt source bits. */
+static const TSimulatorInterruptSourceDescription Simulator_Interrupt_Sources[SIMULATOR_INTERRUPT_SOURCES_COUNT] =
+{
+	#define SIMULATOR_DESCRIBE_INTERRUPT_SOURCE(Identifier, Name, Enable_Register, Enable_Bit, Flag_Register, Flag_Bit, Priority_Register, Priority_Bit, Is_Peripheral) {SIMULATOR_REGISTER_##Enable_Register, SIMULATOR_BIT_POSITION_##Enable_Bit, SIMULATOR_REGISTER_##Flag_Register, SIMULATOR_BIT_POSITION_##Flag_Bit, SIMULATOR_REGISTER_##Priority_Register, SIMULATOR_BIT_POSITION_##Priority_Bit, Is_Peripheral},
+	SIMULATOR_INTERRUPT_SOURCES(SIMULATOR_DESCRIBE_INTERRUPT_SOURCE)
+	#undef SIMULATOR_DESCRIBE_INTERRUPT_SOURCE
+};
+
+/** The registers content (port registers hold the output latches). */
+static unsigned char Simulator_Registers[SIMULATOR_REGISTERS_COUNT];
+
+/** The level applied by the outside world on the PORTA pins. */
+static unsigned char Simulator_Port_A_Inputs;
+
+/** The simulated time (in picoseconds). */
+static unsigned long long Simulator_Time;
+
+/** When the scenario ends (in picoseconds). */
+static unsigned long long Simulator_End_Time;
+
+/** The core current power mode. */
+static TSimulatorPowerMode Simulator_Power_Mode;
+
+/** Time elapsed since the last increment of each timer (in picoseconds). */
+static unsigned long long Simulator_Timer_Prescaler_Times[SIMULATOR_TIMERS_COUNT];
+
+/** When the running ADC conversion will end (SIMULATOR_TIME_NEVER if no conversion is running). */
+static unsigned long long Simulator_ADC_Conversion_End_Time;
+
+/** When the fixed voltage reference will become stable (SIMULATOR_TIME_NEVER if it is not settling). */
+static unsigned long long Simulator_Fixed_Voltage_Reference_Stable_Time;
+
+/** When the comparator output will be updated next time (SIMULATOR_TIME_NEVER if the comparator is disabled). */
+static unsigned long long Simulator_Comparator_Sampling_Time;
+
+/** The data EEPROM content. */
+static unsigned char Simulator_EEPROM[SIMULATOR_EEPROM_SIZE];
+
+/** When the running data EEPROM write will end (SIMULATOR_TIME_NEVER if no write is running). */
+static unsigned long long Simulator_EEPROM_Write_End_Time;
+
+/** The address of the running data EEPROM write, latched when the write starts. */
+static unsigned char Simulator_EEPROM_Write_Address;
+
+/** The value of the running data EEPROM write, latched when the write starts. */
+static unsigned char Simulator_EEPROM_Write_Value;
+
+/** How many steps of the data EEPROM unlock sequence have been done (0 : none, 1 : 0x55 written to EECON2, 2 : 0xAA written next, WR can be set). */
+static unsigned char Simulator_EEPROM_Unlock_Step;
+
+/** When the byte being shifted out by the EUSART will be completely transmitted (SIMULATOR_TIME_NEVER if the transmit shift register is empty). */
+static unsigned long long Simulator_UART_Shift_End_Time;
+
+/** The byte being shifted out by the EUSART. */
+static unsigned char Simulator_UART_Shift_Register;
+
+/** Tell whether the receiver can't read the byte being shifted out. */
+static unsigned char Simulator_UART_Is_Shift_Corrupted;
+
+/** The OSCCON.IRCF value of the oscillator clocking the baud rate generator when the byte being shifted out started. */
+static unsigned char Simulator_UART_Shift_Frequency_Index;
+
+/** Tell whether TXREG holds a byte waiting for the transmit shift register to be empty. */
+static unsigned char Simulator_UART_Is_Transmit_Register_Full;
+
+/** The receiver connected to the TX pin (NULL if there is no receiver). */
+static TSimulatorUARTReceiver Pointer_Simulator_UART_Receiver = NULL;
+
+/** The function watching the bytes written to TXREG (NULL if there is no monitor). */
+static TSimulatorUARTReceiver Pointer_Simulator_UART_Transmit_Monitor = NULL;
+
+/** When the HFINTOSC will become stable (SIMULATOR_TIME_NEVER if it is not starting). */
+static unsigned long long Simulator_Oscillator_Stable_Time;
+
+/** The OSCCON.IRCF value of the oscillator clocking the core. The core keeps running from the LFINTOSC while the HFINTOSC is starting, so it can differ from the register value. */
+static unsigned char Simulator_Clock_Frequency_Index;
+
+/** When the watchdog timer will time out (SIMULATOR_TIME_NEVER if it is disabled). */
+static unsigned long long Simulator_Watchdog_Timeout_Time;
+
+/** When Timer 0 overflowed without any display being enabled since then (SIMULATOR_TIME_NEVER if no overflow is waiting for a screen refresh). */
+static unsigned long long Simulator_Refresh_Tick_Time;
+
+/** Tell whether the watchdog timer timed out while the core was sleeping. */
+static unsigned char Simulator_Is_Watchdog_Wake_Up;
+
+/** When the button state will change next time (SIMULATOR_TIME_NEVER if the button won't be used anymore). */
+static unsigned long long Simulator_Button_Event_Time;
+
+/** How many button presses have been started yet. */
+static unsigned long Simulator_Button_Presses_Count;
+
+/** The running interrupt handler (SIMULATOR_INTERRUPT_LEVEL_NONE when no handler is running). */
+static unsigned char Simulator_Interrupt_Level;
+
+/** The interrupt source the currently executed handler code is attributed to. */
+static TSimulatorInterruptSource Simulator_Interrupt_Current_Source;
+
+/** The interrupt sources that were pending when the current handler invocation started, or that became pending and were checked by the handler, and that have not been serviced yet (one bit per source). */
+static unsigned int Simulator_Interrupt_Triggering_Sources;
+
+/** How many return addresses the firmware pushed on the hardware stack, each instrumented firmware function (the interrupt handlers included) pushing one. */
+static unsigned int Simulator_Stack_Depth;
+
+/** The TMR1H value latched when TMR1L is read in 16-bit read mode. */
+static unsigned char Simulator_Timer_1_High_Byte_Buffer;
+
+/** Cycles spent on each source during the current handler invocation. */
+static unsigned long Simulator_Interrupt_Invocation_Cycles[SIMULATOR_INTERRUPT_SOURCES_COUNT];
+
+/** The simulated time not yet applied to the peripherals (in picoseconds). */
+static unsigned long long Simulator_Unsynchronized_Duration;
+
+/** When the next event (timer overflow, end of conversion...) occurs (in picoseconds). */
+static unsigned long long Simulator_Next_Event_Time;
+
+/** Function calls and returns cycles not yet applied to the simulated time. */
+static unsigned long Simulator_Pending_Cycles;
+
+/** The ADC noise generator state. */
+static unsigned long Simulator_Noise_Seed;
+
+/** The segments each 7-segment display showed when it was last enabled (left display first). */
+static unsigned char Simulator_Displayed_Segments[2];
+
+/** The simulated scenario. */
+static const TSimulatorScenario *Pointer_Simulator_Scenario;
+
+/** The run measurements. */
+static TSimulatorStatistics Simulator_Statistics;
+
+//--------------------------------------------------------------------------------------------------
+// Public variables
+//--------------------------------------------------------------------------------------------------
+#define SIMULATOR_DEFINE_REGISTER(Name) TSimulatorRegister Name(SIMULATOR_REGISTER_##Name);
+SIMULATOR_REGISTERS(SIMULATOR_DEFINE_REGISTER)
+#undef SIMULATOR_DEFINE_REGISTER
+
+const char *Simulator_Interrupt_Source_Names[SIMULATOR_INTERRUPT_SOURCES_COUNT] =
+{
+	#define SIMULATOR_DECLARE_INTERRUPT_SOURCE_NAME(Identifier, Name, Enable_Register, Enable_Bit, Flag_Register, Flag_Bit, Priority_Register, Priority_Bit, Is_Peripheral) Name,
+	SIMULATOR_INTERRUPT_SOURCES(SIMULATOR_DECLARE_INTERRUPT_SOURCE_NAME)
+	#undef SIMULATOR_DECLARE_INTERRUPT_SOURCE_NAME
+};
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Get a register bit value without any side effect.
+ * @param Register_Index The register.
+ * @param Bit_Index The bit.
+ * @return The bit value.
+ */
+static inline unsigned char SimulatorGetBit(unsigned char Register_Index, unsigned char Bit_Index)
+{
+	return (Simulator_Registers[Register_Index] >> Bit_Index) & 1;
+}
+
+/** Set or clear a register bit without any side effect.
+ * @param Register_Index The register.
+ * @param Bit_Index The bit.
+ * @param Value The bit value.
+ */
+static inline void SimulatorSetBit(unsigned char Register_Index, unsigned char Bit_Index, unsigned char Value)
+{
+	if (Value) Simulator_Registers[Register_Index] |= 1 << Bit_Index;
+	else Simulator_Registers[Register_Index] &= ~(1 << Bit_Index);
+}
+
+/** Get the current oscillator frequency.
+ * @return The frequency in Hz.
+ */
+static inline unsigned long SimulatorGetOscillatorFrequency(void)
+{
+	return Simulator_Oscillator_Frequencies[Simulator_Clock_Frequency_Index];
+}
+
+/** Get the instruction cycle duration.
+ * @return The duration in picoseconds.
+ */
+static inline unsigned long long SimulatorGetInstructionCyclePeriod(void)
+{
+	return 4 * SIMULATOR_PICOSECONDS_PER_SECOND / SimulatorGetOscillatorFrequency();
+}
+
+/** Get the period of a timer increments.
+ * @param Timer The timer.
+ * @return The increment period in picoseconds, or 0 if the timer is stopped.
+ */
+static unsigned long long SimulatorGetTimerTickPeriod(TSimulatorTimer Timer)
+{
+	unsigned char Control;
+
+	// The instruction clock is stopped in sleep mode
+	if (Simulator_Power_Mode == SIMULATOR_POWER_MODE_SLEEP) return 0;
+
+	switch (Timer)
+	{
+		case SIMULATOR_TIMER_0:
+			Control = Simulator_Registers[SIMULATOR_REGISTER_t0con];
+			if (!(Control & 0x80) || (Control & 0x20)) return 0; // Timer stopped or clocked from the T0CKI pin
+			if (Control & 0x08) return SimulatorGetInstructionCyclePeriod(); // No prescaler
+			return SimulatorGetInstructionCyclePeriod() << ((Control & 0x07) + 1);
+
+		case SIMULATOR_TIMER_1:
+			Control = Simulator_Registers[SIMULATOR_REGISTER_t1con];
+			break;
+
+		default:
+			Control = Simulator_Registers[SIMULATOR_REGISTER_t3con];
+			break;
+	}
+
+	// Timers 1 and 3 share the same control register layout
+	if (!(Control & 0x01) || (Control & 0x02)) return 0; // Timer stopped or clocked from an external source
+	return SimulatorGetInstructionCyclePeriod() << ((Control >> 4) & 0x03);
+}
+
+/** Get the registers holding a timer counter value.
+ * @param Timer The timer.
+ * @param Pointer_Low_Register_Index On output, contain the low byte register.
+ * @param Pointer_Flag_Register_Index On output, contain the overflow flag register.
+ * @param Pointer_Flag_Bit_Index On output, contain the overflow flag bit.
+ * @return The counter maximum value.
+ */
+static unsigned short SimulatorGetTimerRegisters(TSimulatorTimer Timer, unsigned char *Pointer_Low_Register_Index, unsigned char *Pointer_Flag_Register_Index, unsigned char *Pointer_Flag_Bit_Index)
+{
+	switch (Timer)
+	{
+		case SIMULATOR_TIMER_0:
+			*Pointer_Low_Register_Index = SIMULATOR_REGISTER_tmr0l;
+			*Pointer_Flag_Register_Index = SIMULATOR_REGISTER_intcon;
+			*Pointer_Flag_Bit_Index = 2;
+			if (Simulator_Registers[SIMULATOR_REGISTER_t0con] & 0x40) return 0xFF; // 8-bit mode
+			return 0xFFFF;
+
+		case SIMULATOR_TIMER_1:
+			*Pointer_Low_Register_Index = SIMULATOR_REGISTER_tmr1l;
+			*Pointer_Flag_Register_Index = SIMULATOR_REGISTER_pir1;
+			*Pointer_Flag_Bit_Index = 0;
+			return 0xFFFF;
+
+		default:
+			*Pointer_Low_Register_Index = SIMULATOR_REGISTER_tmr3l;
+			*Pointer_Flag_Register_Index = SIMULATOR_REGISTER_pir2;
+			*Pointer_Flag_Bit_Index = 1;
+			return 0xFFFF;
+	}
+}
+
+/** Get a timer counter value.
+ * @param Low_Register_Index The counter low byte register (the high byte register follows it).
+ * @param Maximum_Value The counter maximum value.
+ * @return The counter value.
+ */
+static inline unsigned short SimulatorGetTimerCounter(unsigned char Low_Register_Index, unsigned short Maximum_Value)
+{
+	if (Maximum_Value == 0xFF) return Simulator_Registers[Low_Register_Index];
+	return (Simulator_Registers[Low_Register_Index + 1] << 8) | Simulator_Registers[Low_Register_Index];
+}
+
+/** Compute the time left before the next event (timer overflow, end of conversion, button change...) occurs.
+ * @return The delay in picoseconds.
+ */
+static unsigned long long SimulatorGetNextEventDelay(void)
+{
+	unsigned long long Delay, Event_Delay, Period;
+	unsigned char Low_Register_Index, Flag_Register_Index, Flag_Bit_Index;
+	unsigned short Maximum_Value;
+	int Timer;
+
+	Delay = Simulator_End_Time - Simulator_Time;
+
+	// Timers overflow
+	for (Timer = 0; Timer < SIMULATOR_TIMERS_COUNT; Timer++)
+	{
+		Period = SimulatorGetTimerTickPeriod((TSimulatorTimer) Timer);
+		if (Period == 0) continue;
+
+		Maximum_Value = SimulatorGetTimerRegisters((TSimulatorTimer) Timer, &Low_Register_Index, &Flag_Register_Index, &Flag_Bit_Index);
+		Event_Delay = (Maximum_Value + 1 - SimulatorGetTimerCounter(Low_Register_Index, Maximum_Value)) * Period - Simulator_Timer_Prescaler_Times[Timer];
+		if (Event_Delay < Delay) Delay = Event_Delay;
+	}
+
+	// Other peripherals
+	if (Simulator_ADC_Conversion_End_Time - Simulator_Time < Delay) Delay = Simulator_ADC_Conversion_End_Time - Simulator_Time;
+	if (Simulator_Fixed_Voltage_Reference_Stable_Time - Simulator_Time < Delay) Delay = Simulator_Fixed_Voltage_Reference_Stable_Time - Simulator_Time;
+	if (Simulator_Comparator_Sampling_Time - Simulator_Time < Delay) Delay = Simulator_Comparator_Sampling_Time - Simulator_Time;
+	if (Simulator_EEPROM_Write_End_Time - Simulator_Time < Delay) Delay = Simulator_EEPROM_Write_End_Time - Simulator_Time;
+	if (Simulator_Oscillator_Stable_Time - Simulator_Time < Delay) Delay = Simulator_Oscillator_Stable_Time - Simulator_Time;
+	if (Simulator_UART_Shift_End_Time - Simulator_Time < Delay) Delay = Simulator_UART_Shift_End_Time - Simulator_Time;
+	if (Simulator_Button_Event_Time - Simulator_Time < Delay) Delay = Simulator_Button_Event_Time - Simulator_Time;
+	if (Simulator_Watchdog_Timeout_Time - Simulator_Time < Delay) Delay = Simulator_Watchdog_Timeout_Time - Simulator_Time;
+
+	return Delay;
+}
+
+/** Compute the current drawn by each consumer according to the registers state and accumulate the corresponding charge.
+ * @param Duration For how long the current is drawn (in picoseconds).
+ */
+static void SimulatorIntegrateCurrent(unsigned long long Duration)
+{
+	double Seconds = (double) Duration / SIMULATOR_PICOSECONDS_PER_SECOND;
+	unsigned char Frequency_Index, Lit_Segments, Displays_Count = 0, Leds_Count = 0;
+
+	Simulator_Statistics.Power_Mode_Time[Simulator_Power_Mode] += Seconds;
+
+	// Core
+	Frequency_Index = Simulator_Clock_Frequency_Index;
+	if (Simulator_Power_Mode == SIMULATOR_POWER_MODE_RUN) Simulator_Statistics.Charge[SIMULATOR_CONSUMER_CORE] += Simulator_Core_Run_Currents[Frequency_Index] * Seconds;
+	else if (Simulator_Power_Mode == SIMULATOR_POWER_MODE_IDLE) Simulator_Statistics.Charge[SIMULATOR_CONSUMER_CORE] += Simulator_Core_Idle_Currents[Frequency_Index] * Seconds;
+	else Simulator_Statistics.Charge[SIMULATOR_CONSUMER_CORE] += SIMULATOR_CURRENT_CORE_SLEEP * Seconds;
+	if (Simulator_Watchdog_Timeout_Time != SIMULATOR_TIME_NEVER) Simulator_Statistics.Charge[SIMULATOR_CONSUMER_CORE] += SIMULATOR_CURRENT_WATCHDOG * Seconds;
+
+	// Analog modules
+	if (SimulatorGetBit(SIMULATOR_REGISTER_vrefcon0, 7))
+	{
+		Simulator_Statistics.Charge[SIMULATOR_CONSUMER_FIXED_VOLTAGE_REFERENCE] += SIMULATOR_CURRENT_FIXED_VOLTAGE_REFERENCE * Seconds;
+		Simulator_Statistics.Fixed_Voltage_Reference_Time += Seconds;
+	}
+	if (Simulator_ADC_Conversion_End_Time != SIMULATOR_TIME_NEVER) Simulator_Statistics.Charge[SIMULATOR_CONSUMER_ADC] += SIMULATOR_CURRENT_ADC * Seconds;
+	if (SimulatorGetBit(SIMULATOR_REGISTER_cm1con0, 7))
+	{
+		if (SimulatorGetBit(SIMULATOR_REGISTER_cm1con0, 3)) Simulator_Statistics.Charge[SIMULATOR_CONSUMER_COMPARATOR] += SIMULATOR_CURRENT_COMPARATOR_NORMAL_POWER * Seconds;
+		else Simulator_Statistics.Charge[SIMULATOR_CONSUMER_COMPARATOR] += SIMULATOR_CURRENT_COMPARATOR_LOW_POWER * Seconds;
+	}
+	if (SimulatorGetBit(SIMULATOR_REGISTER_vrefcon1, 7)) Simulator_Statistics.Charge[SIMULATOR_CONSUMER_COMPARATOR] += SIMULATOR_CURRENT_DAC * Seconds;
+	Simulator_Statistics.Charge[SIMULATOR_CONSUMER_SENSOR] += SIMULATOR_CURRENT_SENSOR * Seconds;
+	if (Simulator_EEPROM_Write_End_Time != SIMULATOR_TIME_NEVER) Simulator_Statistics.Charge[SIMULATOR_CONSUMER_EEPROM] += SIMULATOR_CURRENT_EEPROM_WRITE * Seconds;
+
+	// 7-segment displays (segments and display selection are active low)
+	Lit_Segments = __builtin_popcount(~(Simulator_Registers[SIMULATOR_REGISTER_portc] | Simulator_Registers[SIMULATOR_REGISTER_trisc]) & 0xFF);
+	if (!SimulatorGetBit(SIMULATOR_REGISTER_portb, 5) && !SimulatorGetBit(SIMULATOR_REGISTER_trisb, 5)) Displays_Count++;
+	if (!SimulatorGetBit(SIMULATOR_REGISTER_portb, 4) && !SimulatorGetBit(SIMULATOR_REGISTER_trisb, 4)) Displays_Count++;
+	Simulator_Statistics.Charge[SIMULATOR_CONSUMER_DISPLAY] += Displays_Count * Lit_Segments * SIMULATOR_CURRENT_SEGMENT * Seconds;
+
+	// State leds (active high)
+	if (SimulatorGetBit(SIMULATOR_REGISTER_porta, 4) && !SimulatorGetBit(SIMULATOR_REGISTER_trisa, 4)) Leds_Count++;
+	if (SimulatorGetBit(SIMULATOR_REGISTER_porta, 5) && !SimulatorGetBit(SIMULATOR_REGISTER_trisa, 5)) Leds_Count++;
+	if (SimulatorGetBit(SIMULATOR_REGISTER_rcsta, 7)) Leds_Count++; // The EUSART drives RB7 when the serial port is enabled, the line idles high
+	else if (SimulatorGetBit(SIMULATOR_REGISTER_portb, 7) && !SimulatorGetBit(SIMULATOR_REGISTER_trisb, 7)) Leds_Count++;
+	Simulator_Statistics.Charge[SIMULATOR_CONSUMER_LEDS] += Leds_Count * SIMULATOR_CURRENT_LED * Seconds;
+
+	// Serial port
+	if (SimulatorGetBit(SIMULATOR_REGISTER_rcsta, 7) && SimulatorGetBit(SIMULATOR_REGISTER_txsta, 5)) Simulator_Statistics.UART_Enabled_Time += Seconds;
+}
+
+/** Make the timers count for the provided duration, setting their interrupt flag on overflow.
+ * @param Duration The elapsed time (in picoseconds). It must not go past the next timer overflow.
+ */
+static void SimulatorTickTimers(unsigned long long Duration)
+{
+	unsigned long long Period, Ticks;
+	unsigned char Low_Register_Index, Flag_Register_Index, Flag_Bit_Index;
+	unsigned short Maximum_Value;
+	unsigned long Counter;
+	int Timer;
+
+	for (Timer = 0; Timer < SIMULATOR_TIMERS_COUNT; Timer++)
+	{
+		Period = SimulatorGetTimerTickPeriod((TSimulatorTimer) Timer);
+		if (Period == 0) continue;
+
+		Simulator_Timer_Prescaler_Times[Timer] += Duration;
+		Ticks = Simulator_Timer_Prescaler_Times[Timer] / Period;
+		if (Ticks == 0) continue;
+		Simulator_Timer_Prescaler_Times[Timer] -= Ticks * Period;
+
+		// Update the counter
+		Maximum_Value = SimulatorGetTimerRegisters((TSimulatorTimer) Timer, &Low_Register_Index, &Flag_Register_Index, &Flag_Bit_Index);
+		Counter = SimulatorGetTimerCounter(Low_Register_Index, Maximum_Value) + Ticks;
+		if (Counter > Maximum_Value)
+		{
+			SimulatorSetBit(Flag_Register_Index, Flag_Bit_Index, 1);
+			Counter &= Maximum_Value;
+
+			// Remember when the screen refresh tick occurred (the counter and the prescaler tell how long ago the overflow happened)
+			if ((Timer == SIMULATOR_TIMER_0) && (Simulator_Refresh_Tick_Time == SIMULATOR_TIME_NEVER)) Simulator_Refresh_Tick_Time = Simulator_Time - Counter * Period - Simulator_Timer_Prescaler_Times[Timer];
+		}
+		Simulator_Registers[Low_Register_Index] = (unsigned char) Counter;
+		if (Maximum_Value == 0xFFFF) Simulator_Registers[Low_Register_Index + 1] = (unsigned char) (Counter >> 8);
+	}
+}
+
+/** Get the fixed voltage reference output.
+ * @return The voltage in volts, or 0 if the reference is not stable.
+ */
+static double SimulatorGetFixedVoltageReferenceVoltage(void)
+{
+	if (!SimulatorGetBit(SIMULATOR_REGISTER_vrefcon0, 6)) return 0;
+	return 1.024 * (1 << (((Simulator_Registers[SIMULATOR_REGISTER_vrefcon0] >> 4) & 0x03) - 1));
+}
+
+/** Get the voltage applied on an analog input.
+ * @param Channel The analog channel in range [0..11].
+ * @return The voltage in volts.
+ */
+static double SimulatorGetAnalogInputVoltage(unsigned char Channel)
+{
+	// A TMP36 sensor is connected to each analog input
+	if (((Simulator_Registers[SIMULATOR_REGISTER_anselh] << 8) | Simulator_Registers[SIMULATOR_REGISTER_ansel]) & (1 << Channel)) return 0.5 + Pointer_Simulator_Scenario->Temperature((double) Simulator_Time / SIMULATOR_PICOSECONDS_PER_SECOND) / 100; // TMP36 : 10mV/°C with a 500mV offset
+	return 0; // Digital pins are read as zero
+}
+
+/** Compute comparator 1 output and set its interrupt flag when the output changes. The output is sampled periodically while the comparator is enabled. */
+static void SimulatorUpdateComparator(void)
+{
+	static const unsigned char Inverting_Input_Channels[4] = {1, 5, 6, 7}; // C12IN0- to C12IN3- analog channels
+	unsigned char Control = Simulator_Registers[SIMULATOR_REGISTER_cm1con0], Output;
+	double Non_Inverting_Voltage, Inverting_Voltage, Source_Voltage;
+
+	if (!(Control & 0x80))
+	{
+		Simulator_Comparator_Sampling_Time = SIMULATOR_TIME_NEVER;
+		return;
+	}
+
+	// Select the non-inverting input, C1VREF comes from the DAC or from the fixed voltage reference (the C1IN+ pin is the button one)
+	if (!(Control & 0x04)) Non_Inverting_Voltage = 0;
+	else if (!SimulatorGetBit(SIMULATOR_REGISTER_cm2con1, 5)) Non_Inverting_Voltage = SimulatorGetFixedVoltageReferenceVoltage();
+	else if (!SimulatorGetBit(SIMULATOR_REGISTER_vrefcon1, 7)) Non_Inverting_Voltage = 0;
+	else
+	{
+		// The DAC divides its positive source in 32 steps, the negative source is Vss
+		if (((Simulator_Registers[SIMULATOR_REGISTER_vrefcon1] >> 2) & 0x03) == 2) Source_Voltage = SimulatorGetFixedVoltageReferenceVoltage();
+		else Source_Voltage = Pointer_Simulator_Scenario->Supply_Voltage;
+		Non_Inverting_Voltage = Source_Voltage * (Simulator_Registers[SIMULATOR_REGISTER_vrefcon2] & 0x1F) / 32;
+	}
+	Inverting_Voltage = SimulatorGetAnalogInputVoltage(Inverting_Input_Channels[Control & 0x03]);
+
+	// Apply the polarity and signal an output change
+	Output = (Non_Inverting_Voltage > Inverting_Voltage) ^ ((Control >> 4) & 1);
+	if (Output != ((Control >> 6) & 1))
+	{
+		SimulatorSetBit(SIMULATOR_REGISTER_cm1con0, 6, Output);
+		SimulatorSetBit(SIMULATOR_REGISTER_cm2con1, 7, Output); // MC1OUT mirrors C1OUT
+		SimulatorSetBit(SIMULATOR_REGISTER_pir2, 6, 1); // Set C1IF
+	}
+
+	Simulator_Comparator_Sampling_Time = Simulator_Time + SIMULATOR_COMPARATOR_SAMPLING_PERIOD;
+}
+
+/** Terminate the running ADC conversion and store its result. */
+static void SimulatorCompleteConversion(void)
+{
+	double Reference_Voltage, Input_Voltage, Noise;
+	unsigned char Channel;
+	int Value;
+
+	// Select the positive voltage reference (a null reference means that the fixed voltage reference is not ready, so the conversion result is meaningless)
+	if ((Simulator_Registers[SIMULATOR_REGISTER_adcon1] & 0x0C) == 0x08) Reference_Voltage = SimulatorGetFixedVoltageReferenceVoltage();
+	else Reference_Voltage = Pointer_Simulator_Scenario->Supply_Voltage;
+
+	// Sample the selected channel
+	Channel = (Simulator_Registers[SIMULATOR_REGISTER_adcon0] >> 2) & 0x0F;
+	if (Channel <= 11) Input_Voltage = SimulatorGetAnalogInputVoltage(Channel);
+	else if (Channel == 15) Input_Voltage = SimulatorGetFixedVoltageReferenceVoltage();
+	else Input_Voltage = 0;
+
+	// Convert
+	Simulator_Noise_Seed = Simulator_Noise_Seed * 1103515245 + 12345;
+	Noise = (((Simulator_Noise_Seed >> 16) & 0x7FFF) / 16383.5 - 1) * Pointer_Simulator_Scenario->ADC_Noise;
+	if (Reference_Voltage <= 0) Value = 1023;
+	else Value = (int) (Input_Voltage / Reference_Voltage * 1024 + Noise);
+	if (Value < 0) Value = 0;
+	else if (Value > 1023) Value = 1023;
+
+	// Store the result according to the justification
+	if (SimulatorGetBit(SIMULATOR_REGISTER_adcon2, 7))
+	{
+		Simulator_Registers[SIMULATOR_REGISTER_adresh] = Value >> 8;
+		Simulator_Registers[SIMULATOR_REGISTER_adresl] = (unsigned char) Value;
+	}
+	else
+	{
+		Simulator_Registers[SIMULATOR_REGISTER_adresh] = Value >> 2;
+		Simulator_Registers[SIMULATOR_REGISTER_adresl] = (Value & 0x03) << 6;
+	}
+
+	SimulatorSetBit(SIMULATOR_REGISTER_adcon0, 1, 0); // Clear GO/DONE
+	SimulatorSetBit(SIMULATOR_REGISTER_pir1, 6, 1); // Set ADIF
+	Simulator_ADC_Conversion_End_Time = SIMULATOR_TIME_NEVER;
+	Simulator_Statistics.Conversions_Count++;
+}
+
+/** Terminate the running data EEPROM write, count the written cell wear and signal the write end. */
+static void SimulatorCompleteEEPROMWrite(void)
+{
+	Simulator_EEPROM[Simulator_EEPROM_Write_Address] = Simulator_EEPROM_Write_Value;
+	Simulator_Statistics.EEPROM_Writes_Count++;
+	Simulator_Statistics.EEPROM_Cell_Writes_Count[Simulator_EEPROM_Write_Address]++;
+
+	SimulatorSetBit(SIMULATOR_REGISTER_eecon1, 1, 0); // Clear WR
+	SimulatorSetBit(SIMULATOR_REGISTER_pir2, 4, 1); // Set EEIF
+	Simulator_EEPROM_Write_End_Time = SIMULATOR_TIME_NEVER;
+}
+
+/** Get the duration of a bit on the serial line.
+ * @return The bit duration in picoseconds, or 0 if the transmitter is not enabled in asynchronous mode.
+ */
+static unsigned long long SimulatorGetUARTBitPeriod(void)
+{
+	unsigned long Divider, Value;
+
+	if (!SimulatorGetBit(SIMULATOR_REGISTER_rcsta, 7) || !SimulatorGetBit(SIMULATOR_REGISTER_txsta, 5) || SimulatorGetBit(SIMULATOR_REGISTER_txsta, 4)) return 0;
+
+	// The baud rate generator divides the oscillator frequency by 4, 16 or 64 depending on BRG16 and BRGH
+	Divider = 64;
+	if (SimulatorGetBit(SIMULATOR_REGISTER_baudcon, 3)) Divider /= 4;
+	if (SimulatorGetBit(SIMULATOR_REGISTER_txsta, 2)) Divider /= 4;
+	if (SimulatorGetBit(SIMULATOR_REGISTER_baudcon, 3)) Value = (Simulator_Registers[SIMULATOR_REGISTER_spbrgh] << 8) | Simulator_Registers[SIMULATOR_REGISTER_spbrg];
+	else Value = Simulator_Registers[SIMULATOR_REGISTER_spbrg];
+
+	return Divider * (Value + 1) * SIMULATOR_PICOSECONDS_PER_SECOND / SimulatorGetOscillatorFrequency();
+}
+
+/** Move the TXREG content to the transmit shift register and start shifting it out. */
+static void SimulatorStartUARTShift(void)
+{
+	unsigned long long Bit_Period = SimulatorGetUARTBitPeriod();
+	double Error;
+
+	Simulator_UART_Shift_Register = Simulator_Registers[SIMULATOR_REGISTER_txreg];
+	Simulator_UART_Is_Transmit_Register_Full = 0;
+	SimulatorSetBit(SIMULATOR_REGISTER_pir1, 4, 1); // Set TXIF
+	SimulatorSetBit(SIMULATOR_REGISTER_txsta, 1, 0); // Clear TRMT
+
+	// The receiver samples the bits at its own rate
+	Error = (double) Bit_Period * SIMULATOR_UART_BAUD_RATE / SIMULATOR_PICOSECONDS_PER_SECOND - 1;
+	Simulator_UART_Is_Shift_Corrupted = (Error * 100 > SIMULATOR_UART_BAUD_RATE_TOLERANCE) || (Error * 100 < -SIMULATOR_UART_BAUD_RATE_TOLERANCE);
+	Simulator_UART_Shift_Frequency_Index = Simulator_Clock_Frequency_Index;
+	Simulator_UART_Shift_End_Time = Simulator_Time + SIMULATOR_UART_BITS_PER_BYTE * Bit_Period;
+}
+
+/** Terminate the byte being shifted out, hand it to the receiver and start shifting the next one. */
+static void SimulatorCompleteUARTShift(void)
+{
+	// Changing the oscillator frequency changes the bit rate in the middle of the byte
+	if (Simulator_UART_Shift_Frequency_Index != Simulator_Clock_Frequency_Index) Simulator_UART_Is_Shift_Corrupted = 1;
+
+	Simulator_Statistics.UART_Bytes_Count++;
+	if (Simulator_UART_Is_Shift_Corrupted) Simulator_Statistics.UART_Framing_Errors_Count++;
+	else if (Pointer_Simulator_UART_Receiver != NULL) Pointer_Simulator_UART_Receiver(Simulator_UART_Shift_Register);
+
+	Simulator_UART_Shift_End_Time = SIMULATOR_TIME_NEVER;
+	if (Simulator_UART_Is_Transmit_Register_Full) SimulatorStartUARTShift();
+	else SimulatorSetBit(SIMULATOR_REGISTER_txsta, 1, 1); // Set TRMT
+}
+
+/** Follow the EUSART configuration changes : disabling the transmitter resets it, enabling it starts the transmission of a byte already written to TXREG. */
+static void SimulatorUpdateUART(void)
+{
+	if (!SimulatorGetBit(SIMULATOR_REGISTER_rcsta, 7) || !SimulatorGetBit(SIMULATOR_REGISTER_txsta, 5))
+	{
+		Simulator_UART_Shift_End_Time = SIMULATOR_TIME_NEVER;
+		Simulator_UART_Is_Transmit_Register_Full = 0;
+		SimulatorSetBit(SIMULATOR_REGISTER_pir1, 4, 0); // Clear TXIF
+		SimulatorSetBit(SIMULATOR_REGISTER_txsta, 1, 1); // Set TRMT
+		return;
+	}
+
+	if ((Simulator_UART_Shift_End_Time == SIMULATOR_TIME_NEVER) && Simulator_UART_Is_Transmit_Register_Full) SimulatorStartUARTShift();
+	else SimulatorSetBit(SIMULATOR_REGISTER_pir1, 4, !Simulator_UART_Is_Transmit_Register_Full); // TXIF tells whether TXREG is empty
+}
+
+/** Compute when the next button press or release happens. */
+static void SimulatorScheduleButtonEvent(void)
+{
+	const TSimulatorButtonPresses *Pointer_Presses = &Pointer_Simulator_Scenario->Button_Presses;
+
+	// Release the button after the press duration
+	if (Simulator_Port_A_Inputs & 0x01)
+	{
+		Simulator_Button_Event_Time += Pointer_Presses->Duration * (SIMULATOR_PICOSECONDS_PER_SECOND / 1000);
+		return;
+	}
+
+	if (Simulator_Button_Presses_Count >= Pointer_Presses->Count) Simulator_Button_Event_Time = SIMULATOR_TIME_NEVER;
+	else Simulator_Button_Event_Time = (Pointer_Presses->Start + Simulator_Button_Presses_Count * Pointer_Presses->Period) * (SIMULATOR_PICOSECONDS_PER_SECOND / 1000);
+}
+
+/** Handle the events occurring at the current simulated time. */
+static void SimulatorProcessEvents(void)
+{
+	unsigned char Is_Rising_Edge;
+
+	if (Simulator_ADC_Conversion_End_Time <= Simulator_Time) SimulatorCompleteConversion();
+
+	if (Simulator_Fixed_Voltage_Reference_Stable_Time <= Simulator_Time)
+	{
+		SimulatorSetBit(SIMULATOR_REGISTER_vrefcon0, 6, 1); // Set FVR1ST
+		Simulator_Fixed_Voltage_Reference_Stable_Time = SIMULATOR_TIME_NEVER;
+	}
+
+	if (Simulator_Comparator_Sampling_Time <= Simulator_Time) SimulatorUpdateComparator();
+
+	if (Simulator_EEPROM_Write_End_Time <= Simulator_Time) SimulatorCompleteEEPROMWrite();
+
+	if (Simulator_UART_Shift_End_Time <= Simulator_Time) SimulatorCompleteUARTShift();
+
+	// Switch the core to the HFINTOSC once it is stable
+	if (Simulator_Oscillator_Stable_Time <= Simulator_Time)
+	{
+		SimulatorSetBit(SIMULATOR_REGISTER_osccon, 2, 1); // Set HFIOFS
+		Simulator_Clock_Frequency_Index = (Simulator_Registers[SIMULATOR_REGISTER_osccon] >> 4) & 0x07;
+		Simulator_Oscillator_Stable_Time = SIMULATOR_TIME_NEVER;
+	}
+
+	// The watchdog timer wakes the core up, but it resets the processor if the core is running
+	if (Simulator_Watchdog_Timeout_Time <= Simulator_Time)
+	{
+		if (Simulator_Power_Mode == SIMULATOR_POWER_MODE_RUN)
+		{
+			fprintf(stderr, "Error : the watchdog timer reset the processor at %.6f s.\n", (double) Simulator_Time / SIMULATOR_PICOSECONDS_PER_SECOND);
+			exit(EXIT_FAILURE);
+		}
+		SimulatorSetBit(SIMULATOR_REGISTER_rcon, 3, 0); // Clear TO
+		Simulator_Is_Watchdog_Wake_Up = 1;
+		Simulator_Watchdog_Timeout_Time += SIMULATOR_WATCHDOG_PERIOD;
+	}
+
+	// The button is connected to RA0/INT0
+	while (Simulator_Button_Event_Time <= Simulator_Time)
+	{
+		Simulator_Port_A_Inputs ^= 0x01;
+		Is_Rising_Edge = Simulator_Port_A_Inputs & 0x01;
+		if (Is_Rising_Edge) Simulator_Button_Presses_Count++;
+		if (Is_Rising_Edge == SimulatorGetBit(SIMULATOR_REGISTER_intcon2, 6)) SimulatorSetBit(SIMULATOR_REGISTER_intcon, 1, 1); // Set INT0IF on the edge selected by INTEDG0
+		SimulatorScheduleButtonEvent();
+	}
+
+	if (Simulator_Time >= Simulator_End_Time) throw TSimulatorEndOfScenario();
+}
+
+/** Apply the time elapsed since the last synchronization to the peripherals and the consumed charge. This must be done before any change of the simulated state. */
+static void SimulatorSynchronize(void)
+{
+	if (Simulator_Unsynchronized_Duration == 0) return;
+
+	SimulatorIntegrateCurrent(Simulator_Unsynchronized_Duration);
+	SimulatorTickTimers(Simulator_Unsynchronized_Duration);
+	Simulator_Unsynchronized_Duration = 0;
+}
+
+/** Compute when the next event will occur after the simulated state changed. */
+static inline void SimulatorScheduleNextEvent(void)
+{
+	Simulator_Next_Event_Time = Simulator_Time + SimulatorGetNextEventDelay();
+}
+
+/** Let the simulated time elapse, updating the peripherals and the consumed charge.
+ * @param Duration How long to wait (in picoseconds).
+ */
+static void SimulatorAdvanceTime(unsigned long long Duration)
+{
+	unsigned long long Step;
+
+	while (Duration > 0)
+	{
+		// Nothing changes before the next event, so the peripherals update can be delayed
+		if (Simulator_Time + Duration < Simulator_Next_Event_Time)
+		{
+			Simulator_Time += Duration;
+			Simulator_Unsynchronized_Duration += Duration;
+			return;
+		}
+
+		// Go to the next event and handle it
+		Step = Simulator_Next_Event_Time - Simulator_Time;
+		Simulator_Time += Step;
+		Simulator_Unsynchronized_Duration += Step;
+		Duration -= Step;
+		SimulatorSynchronize();
+		SimulatorProcessEvents();
+		SimulatorScheduleNextEvent();
+	}
+}
+
+/** Let the core execute instructions, without servicing interrupts.
+ * @param Cycles How many instruction cycles to execute.
+ */
+static void SimulatorExecuteCycles(unsigned long Cycles)
+{
+	Simulator_Statistics.Cycles += Cycles;
+	if (Simulator_Interrupt_Level != SIMULATOR_INTERRUPT_LEVEL_NONE)
+	{
+		Simulator_Statistics.Interrupt_Cycles[Simulator_Interrupt_Current_Source] += Cycles;
+		Simulator_Interrupt_Invocation_Cycles[Simulator_Interrupt_Current_Source] += Cycles;
+	}
+
+	SimulatorAdvanceTime(Cycles * SimulatorGetInstructionCyclePeriod());
+}
+
+/** Tell whether an interrupt source is both enabled and triggered.
+ * @param Source The source.
+ * @return 1 if the source requests an interrupt, 0 otherwise.
+ */
+static inline unsigned char SimulatorIsInterruptRequested(int Source)
+{
+	const TSimulatorInterruptSourceDescription *Pointer_Source = &Simulator_Interrupt_Sources[Source];
+
+	return SimulatorGetBit(Pointer_Source->Enable_Register_Index, Pointer_Source->Enable_Bit_Index) && SimulatorGetBit(Pointer_Source->Flag_Register_Index, Pointer_Source->Flag_Bit_Index);
+}
+
+/** Get the handler an interrupt source is vectored to.
+ * @param Source The source.
+ * @return SIMULATOR_INTERRUPT_LEVEL_HIGH when priorities are disabled or for a high priority source, SIMULATOR_INTERRUPT_LEVEL_LOW for a low priority source.
+ */
+static inline unsigned char SimulatorGetInterruptLevel(int Source)
+{
+	const TSimulatorInterruptSourceDescription *Pointer_Source = &Simulator_Interrupt_Sources[Source];
+
+	if (!SimulatorGetBit(SIMULATOR_REGISTER_rcon, 7) || SimulatorGetBit(Pointer_Source->Priority_Register_Index, Pointer_Source->Priority_Bit_Index)) return SIMULATOR_INTERRUPT_LEVEL_HIGH;
+	return SIMULATOR_INTERRUPT_LEVEL_LOW;
+}
+
+/** Tell whether an enabled interrupt source can wake the core up. This does not depend on the global interrupt enable bits.
+ * @return 1 if an interrupt is requested, 0 otherwise.
+ */
+static unsigned char SimulatorIsWakeUpRequested(void)
+{
+	int i;
+
+	for (i = 0; i < SIMULATOR_INTERRUPT_SOURCES_COUNT; i++)
+	{
+		if (SimulatorIsInterruptRequested(i)) return 1;
+	}
+	return 0;
+}
+
+/** Find the first interrupt source which is enabled, triggered, and allowed to call its handler right now (the global enable bits and the running handler are taken into account).
+ * @param Pointer_Level On output, contain the handler level to call.
+ * @return The source, or SIMULATOR_INTERRUPT_SOURCES_COUNT if no interrupt can be dispatched.
+ */
+static TSimulatorInterruptSource SimulatorGetDispatchableInterrupt(unsigned char *Pointer_Level)
+{
+	unsigned char Is_Priority_Enabled = SimulatorGetBit(SIMULATOR_REGISTER_rcon, 7), Level;
+	int i;
+
+	// GIE (or GIEH) gates all interrupts
+	if (!SimulatorGetBit(SIMULATOR_REGISTER_intcon, 7)) return SIMULATOR_INTERRUPT_SOURCES_COUNT;
+
+	for (i = 0; i < SIMULATOR_INTERRUPT_SOURCES_COUNT; i++)
+	{
+		if (!SimulatorIsInterruptRequested(i)) continue;
+		Level = SimulatorGetInterruptLevel(i);
+
+		// Only a high priority interrupt can preempt a running handler (the low priority one)
+		if (Level <= Simulator_Interrupt_Level) continue;
+
+		// Without priorities, PEIE gates the peripheral interrupts, with priorities GIEL gates the low priority ones
+		if (Is_Priority_Enabled)
+		{
+			if ((Level == SIMULATOR_INTERRUPT_LEVEL_LOW) && !SimulatorGetBit(SIMULATOR_REGISTER_intcon, 6)) continue;
+		}
+		else if (Simulator_Interrupt_Sources[i].Is_Peripheral && !SimulatorGetBit(SIMULATOR_REGISTER_intcon, 6)) continue;
+
+		*Pointer_Level = Level;
+		return (TSimulatorInterruptSource) i;
+	}
+	return SIMULATOR_INTERRUPT_SOURCES_COUNT;
+}
+
+/** Get all interrupt sources which are enabled, triggered and serviced by the running handler.
+ * @return A bit field with one bit set per pending source.
+ */
+static unsigned int SimulatorGetPendingInterrupts(void)
+{
+	unsigned int Sources = 0;
+	int i;
+
+	for (i = 0; i < SIMULATOR_INTERRUPT_SOURCES_COUNT; i++)
+	{
+		if (SimulatorIsInterruptRequested(i) && (SimulatorGetInterruptLevel(i) == Simulator_Interrupt_Level)) Sources |= 1 << i;
+	}
+	return Sources;
+}
+
+static void SimulatorDispatchInterrupts(void);
+
+/** Execute instruction cycles one by one, servicing the interrupts which can preempt the current code after each cycle.
+ * @param Cycles How many cycles to execute.
+ */
+static void SimulatorExecutePreemptibleCycles(unsigned long Cycles)
+{
+	unsigned long i;
+
+	for (i = 0; i < Cycles; i++)
+	{
+		SimulatorExecuteCycles(1);
+		SimulatorDispatchInterrupts();
+	}
+}
+
+/** Call the firmware interrupt handlers as long as an interrupt is pending and allowed. A high priority interrupt preempts the low priority handler. */
+static void SimulatorDispatchInterrupts(void)
+{
+	TSimulatorInterruptSource Source, Preempted_Source;
+	unsigned long Preempted_Invocation_Cycles[SIMULATOR_INTERRUPT_SOURCES_COUNT];
+	unsigned int Preempted_Triggering_Sources;
+	unsigned char Level, Preempted_Level, Enable_Bit_Index;
+	int i;
+
+	while (1)
+	{
+		Source = SimulatorGetDispatchableInterrupt(&Level);
+		if (Source == SIMULATOR_INTERRUPT_SOURCES_COUNT) return;
+
+		// Save the preempted handler state
+		Preempted_Level = Simulator_Interrupt_Level;
+		Preempted_Source = Simulator_Interrupt_Current_Source;
+		Preempted_Triggering_Sources = Simulator_Interrupt_Triggering_Sources;
+		memcpy(Preempted_Invocation_Cycles, Simulator_Interrupt_Invocation_Cycles, sizeof(Preempted_Invocation_Cycles));
+
+		// The hardware clears GIE (or GIEH) when vectoring to the high priority handler, and GIEL when vectoring to the low priority one
+		if (Level == SIMULATOR_INTERRUPT_LEVEL_LOW) Enable_Bit_Index = 6;
+		else Enable_Bit_Index = 7;
+		SimulatorSetBit(SIMULATOR_REGISTER_intcon, Enable_Bit_Index, 0);
+		Simulator_Interrupt_Level = Level;
+		Simulator_Interrupt_Current_Source = Source;
+		Simulator_Interrupt_Triggering_Sources = SimulatorGetPendingInterrupts();
+		for (i = 0; i < SIMULATOR_INTERRUPT_SOURCES_COUNT; i++) Simulator_Interrupt_Invocation_Cycles[i] = 0;
+
+		if (Level == SIMULATOR_INTERRUPT_LEVEL_LOW)
+		{
+			// The high priority interrupt can preempt the low priority handler context saving and restoring, so they are executed one cycle at a time
+			SimulatorExecutePreemptibleCycles(SIMULATOR_INTERRUPT_ENTRY_CYCLES);
+			interrupt_low();
+			SimulatorExecutePreemptibleCycles(SIMULATOR_INTERRUPT_EXIT_CYCLES + Simulator_Pending_Cycles);
+		}
+		else
+		{
+			SimulatorExecuteCycles(SIMULATOR_INTERRUPT_ENTRY_CYCLES);
+			interrupt();
+			SimulatorExecuteCycles(SIMULATOR_INTERRUPT_EXIT_CYCLES + Simulator_Pending_Cycles);
+		}
+		Simulator_Pending_Cycles = 0;
+
+		for (i = 0; i < SIMULATOR_INTERRUPT_SOURCES_COUNT; i++)
+		{
+			if (Simulator_Interrupt_Invocation_Cycles[i] > Simulator_Statistics.Interrupt_Maximum_Cycles[i]) Simulator_Statistics.Interrupt_Maximum_Cycles[i] = Simulator_Interrupt_Invocation_Cycles[i];
+		}
+
+		// RETFIE sets the cleared enable bit again and resumes the preempted code
+		Simulator_Interrupt_Level = Preempted_Level;
+		Simulator_Interrupt_Current_Source = Preempted_Source;
+		Simulator_Interrupt_Triggering_Sources = Preempted_Triggering_Sources;
+		memcpy(Simulator_Interrupt_Invocation_Cycles, Preempted_Invocation_Cycles, sizeof(Preempted_Invocation_Cycles));
+		SimulatorSetBit(SIMULATOR_REGISTER_intcon, Enable_Bit_Index, 1);
+	}
+}
+
+/** Count an interrupt source as serviced if it triggered the running handler invocation.
+ * @param Source The source.
+ */
+static void SimulatorCountServicedInterrupt(int Source)
+{
+	if ((Simulator_Interrupt_Level == SIMULATOR_INTERRUPT_LEVEL_NONE) || !(Simulator_Interrupt_Triggering_Sources & (1 << Source))) return;
+
+	Simulator_Statistics.Interrupt_Count[Source]++;
+	Simulator_Interrupt_Triggering_Sources &= ~(1 << Source);
+}
+
+/** Get a register value as seen by the firmware, without any side effect.
+ * @param Register_Index The register.
+ * @return The register value.
+ */
+static unsigned char SimulatorGetRegisterValue(unsigned char Register_Index)
+{
+	// Timer counters must be up to date
+	if ((Register_Index == SIMULATOR_REGISTER_tmr0l) || (Register_Index == SIMULATOR_REGISTER_tmr0h) || (Register_Index == SIMULATOR_REGISTER_tmr1l) || (Register_Index == SIMULATOR_REGISTER_tmr1h) || (Register_Index == SIMULATOR_REGISTER_tmr3l) || (Register_Index == SIMULATOR_REGISTER_tmr3h)) SimulatorSynchronize();
+
+	// The stack pointer follows the firmware calls, the overflow and underflow flags being kept in the register
+	if (Register_Index == SIMULATOR_REGISTER_stkptr)
+	{
+		if (Simulator_Stack_Depth > SIMULATOR_STACK_SIZE) return (Simulator_Registers[SIMULATOR_REGISTER_stkptr] & 0xC0) | SIMULATOR_STACK_SIZE;
+		return (Simulator_Registers[SIMULATOR_REGISTER_stkptr] & 0xC0) | Simulator_Stack_Depth;
+	}
+
+	// Input pins reflect the outside world
+	if (Register_Index == SIMULATOR_REGISTER_porta) return (Simulator_Registers[SIMULATOR_REGISTER_porta] & ~Simulator_Registers[SIMULATOR_REGISTER_trisa]) | (Simulator_Port_A_Inputs & Simulator_Registers[SIMULATOR_REGISTER_trisa]);
+	return Simulator_Registers[Register_Index];
+}
+
+/** Change a register value as the firmware would do, triggering the peripherals side effects.
+ * @param Register_Index The register.
+ * @param Value The value to write.
+ */
+static void SimulatorSetRegisterValue(unsigned char Register_Index, unsigned char Value)
+{
+	unsigned char Previous_Value = Simulator_Registers[Register_Index], Divider, Frequency_Index;
+	unsigned long long Tad, Delay;
+	int i;
+
+	SimulatorSynchronize();
+
+	// Count the serviced interrupts when the handler clears the flag of a source that triggered it
+	for (i = 0; i < SIMULATOR_INTERRUPT_SOURCES_COUNT; i++)
+	{
+		if ((Simulator_Interrupt_Sources[i].Flag_Register_Index == Register_Index) && ((Previous_Value & ~Value) & (1 << Simulator_Interrupt_Sources[i].Flag_Bit_Index))) SimulatorCountServicedInterrupt(i);
+	}
+
+	switch (Register_Index)
+	{
+		case SIMULATOR_REGISTER_adcon0:
+			Simulator_Registers[Register_Index] = Value;
+			// Turning the ADC off or clearing GO/DONE aborts the conversion
+			if (!(Value & 0x01) || !(Value & 0x02))
+			{
+				Simulator_ADC_Conversion_End_Time = SIMULATOR_TIME_NEVER;
+				SimulatorSetBit(SIMULATOR_REGISTER_adcon0, 1, 0);
+			}
+			// Start a conversion
+			else if (!(Previous_Value & 0x02))
+			{
+				Divider = Simulator_ADC_Clock_Dividers[Simulator_Registers[SIMULATOR_REGISTER_adcon2] & 0x07];
+				if (Divider == 0) Tad = SIMULATOR_ADC_FRC_PERIOD;
+				else Tad = Divider * SimulatorGetInstructionCyclePeriod() / 4;
+				Simulator_ADC_Conversion_End_Time = Simulator_Time + (Simulator_ADC_Acquisition_Tad[(Simulator_Registers[SIMULATOR_REGISTER_adcon2] >> 3) & 0x07] + SIMULATOR_ADC_CONVERSION_TAD) * Tad;
+			}
+			break;
+
+		case SIMULATOR_REGISTER_vrefcon0:
+			// FVR1ST is read-only
+			Simulator_Registers[Register_Index] = (Value & ~0x40) | (Previous_Value & 0x40);
+			if ((Value & 0x80) && !(Previous_Value & 0x80))
+			{
+				Simulator_Fixed_Voltage_Reference_Stable_Time = Simulator_Time + SIMULATOR_FIXED_VOLTAGE_REFERENCE_SETTLING_TIME;
+				Simulator_Statistics.Fixed_Voltage_Reference_Enables_Count++;
+			}
+			else if (!(Value & 0x80))
+			{
+				SimulatorSetBit(SIMULATOR_REGISTER_vrefcon0, 6, 0);
+				Simulator_Fixed_Voltage_Reference_Stable_Time = SIMULATOR_TIME_NEVER;
+			}
+			break;
+
+		case SIMULATOR_REGISTER_wdtcon:
+			Simulator_Registers[Register_Index] = Value;
+			if ((Value & 0x01) && !(Previous_Value & 0x01)) Simulator_Watchdog_Timeout_Time = Simulator_Time + SIMULATOR_WATCHDOG_PERIOD;
+			else if (!(Value & 0x01)) Simulator_Watchdog_Timeout_Time = SIMULATOR_TIME_NEVER;
+			break;
+
+		case SIMULATOR_REGISTER_osccon:
+			// OSTS and HFIOFS are read-only, OSTS is always set because the primary clock is the internal oscillator
+			Simulator_Registers[Register_Index] = (Value & ~0x0C) | 0x08 | (Previous_Value & 0x04);
+			Frequency_Index = (Value >> 4) & 0x07;
+
+			// The LFINTOSC is always running, the HFINTOSC is stopped when it is not used
+			if (Frequency_Index == 0)
+			{
+				SimulatorSetBit(SIMULATOR_REGISTER_osccon, 2, 0);
+				Simulator_Clock_Frequency_Index = 0;
+				Simulator_Oscillator_Stable_Time = SIMULATOR_TIME_NEVER;
+			}
+			// Start the HFINTOSC, the core is switched to it when it is stable
+			else if (!(Previous_Value & 0x04))
+			{
+				if (Simulator_Oscillator_Stable_Time == SIMULATOR_TIME_NEVER) Simulator_Oscillator_Stable_Time = Simulator_Time + SIMULATOR_HFINTOSC_STARTUP_TIME;
+			}
+			// Only the HFINTOSC postscaler changes
+			else Simulator_Clock_Frequency_Index = Frequency_Index;
+			break;
+
+		// Measure the screen refresh delay when a display is enabled (the selection pins are active low), and count the displayed characters changes
+		case SIMULATOR_REGISTER_portb:
+			Simulator_Registers[Register_Index] = Value;
+			for (i = 0; i < 2; i++)
+			{
+				if (!(Previous_Value & ~Value & (0x20 >> i))) continue;
+				if (Simulator_Registers[SIMULATOR_REGISTER_portc] != Simulator_Displayed_Segments[i]) Simulator_Statistics.Display_Changes_Count++;
+				Simulator_Displayed_Segments[i] = Simulator_Registers[SIMULATOR_REGISTER_portc];
+			}
+			if ((Previous_Value & ~Value & 0x30) && (Simulator_Refresh_Tick_Time != SIMULATOR_TIME_NEVER))
+			{
+				Delay = Simulator_Time - Simulator_Refresh_Tick_Time;
+				if ((Simulator_Statistics.Refreshes_Count == 0) || (Delay < Simulator_Statistics.Refresh_Minimum_Delay)) Simulator_Statistics.Refresh_Minimum_Delay = Delay;
+				if (Delay > Simulator_Statistics.Refresh_Maximum_Delay) Simulator_Statistics.Refresh_Maximum_Delay = Delay;
+				Simulator_Statistics.Refreshes_Count++;
+				Simulator_Refresh_Tick_Time = SIMULATOR_TIME_NEVER;
+			}
+			break;
+
+		// Writing to a timer resets its prescaler
+		case SIMULATOR_REGISTER_tmr0l:
+			Simulator_Timer_Prescaler_Times[SIMULATOR_TIMER_0] = 0;
+			Simulator_Registers[Register_Index] = Value;
+			break;
+
+		case SIMULATOR_REGISTER_tmr1l:
+			Simulator_Timer_Prescaler_Times[SIMULATOR_TIMER_1] = 0;
+			Simulator_Registers[Register_Index] = Value;
+			break;
+
+		case SIMULATOR_REGISTER_tmr3l:
+			Simulator_Timer_Prescaler_Times[SIMULATOR_TIMER_3] = 0;
+			Simulator_Registers[Register_Index] = Value;
+			break;
+
+		// C1OUT is read-only
+		case SIMULATOR_REGISTER_cm1con0:
+			Simulator_Registers[Register_Index] = (Value & ~0x40) | (Previous_Value & 0x40);
+			break;
+
+		// MC1OUT and MC2OUT are read-only
+		case SIMULATOR_REGISTER_cm2con1:
+			Simulator_Registers[Register_Index] = (Value & 0x3F) | (Previous_Value & 0xC0);
+			break;
+
+		// RD and WR can only be set by software, the hardware clears them
+		case SIMULATOR_REGISTER_eecon1:
+			Simulator_Registers[Register_Index] = (Value & ~0x03) | (Previous_Value & 0x02);
+			if (Value & 0xC0)
+			{
+				fprintf(stderr, "Error : only the data EEPROM is simulated, EECON1 = 0x%02X.\n", Value);
+				exit(EXIT_FAILURE);
+			}
+
+			// A read is immediate
+			if (Value & 0x01) Simulator_Registers[SIMULATOR_REGISTER_eedata] = Simulator_EEPROM[Simulator_Registers[SIMULATOR_REGISTER_eeadr]];
+
+			// A write starts only if it is allowed and if the unlock sequence has just been written
+			if ((Value & 0x02) && !(Previous_Value & 0x02))
+			{
+				if (!(Value & 0x04) || (Simulator_EEPROM_Unlock_Step != 2))
+				{
+					fprintf(stderr, "Error : data EEPROM write started without WREN or without the unlock sequence at %.6f s.\n", (double) Simulator_Time / SIMULATOR_PICOSECONDS_PER_SECOND);
+					exit(EXIT_FAILURE);
+				}
+				Simulator_EEPROM_Write_Address = Simulator_Registers[SIMULATOR_REGISTER_eeadr];
+				Simulator_EEPROM_Write_Value = Simulator_Registers[SIMULATOR_REGISTER_eedata];
+				Simulator_EEPROM_Write_End_Time = Simulator_Time + SIMULATOR_EEPROM_WRITE_TIME;
+				SimulatorSetBit(SIMULATOR_REGISTER_eecon1, 1, 1);
+			}
+			break;
+
+		// EECON2 is not a physical register, it only receives the unlock sequence
+		case SIMULATOR_REGISTER_eecon2:
+			if (Value == 0x55) Simulator_EEPROM_Unlock_Step = 1;
+			else if ((Value == 0xAA) && (Simulator_EEPROM_Unlock_Step == 1)) Simulator_EEPROM_Unlock_Step = 2;
+			else Simulator_EEPROM_Unlock_Step = 0;
+			break;
+
+		// TXIF is read-only, the handler services the EUSART transmit interrupt by loading TXREG or by disabling the interrupt
+		case SIMULATOR_REGISTER_pir1:
+			Simulator_Registers[Register_Index] = (Value & ~0x10) | (Previous_Value & 0x10);
+			break;
+
+		case SIMULATOR_REGISTER_pie1:
+			Simulator_Registers[Register_Index] = Value;
+			if (Previous_Value & ~Value & 0x10) SimulatorCountServicedInterrupt(SIMULATOR_INTERRUPT_SOURCE_UART_TRANSMIT);
+			break;
+
+		case SIMULATOR_REGISTER_txreg:
+			Simulator_Registers[Register_Index] = Value;
+			Simulator_UART_Is_Transmit_Register_Full = 1;
+			if (Pointer_Simulator_UART_Transmit_Monitor != NULL) Pointer_Simulator_UART_Transmit_Monitor(Value);
+			SimulatorCountServicedInterrupt(SIMULATOR_INTERRUPT_SOURCE_UART_TRANSMIT);
+			SimulatorUpdateUART();
+			break;
+
+		// TRMT is read-only
+		case SIMULATOR_REGISTER_txsta:
+			Simulator_Registers[Register_Index] = (Value & ~0x02) | (Previous_Value & 0x02);
+			SimulatorUpdateUART();
+			break;
+
+		case SIMULATOR_REGISTER_rcsta:
+			Simulator_Registers[Register_Index] = Value;
+			SimulatorUpdateUART();
+			break;
+
+		default:
+			Simulator_Registers[Register_Index] = Value;
+			break;
+	}
+
+	// Changing the bit rate in the middle of a byte makes the receiver lose it
+	if (((Register_Index == SIMULATOR_REGISTER_txsta) || (Register_Index == SIMULATOR_REGISTER_baudcon) || (Register_Index == SIMULATOR_REGISTER_spbrg) || (Register_Index == SIMULATOR_REGISTER_spbrgh)) && (Value != Previous_Value) && (Simulator_UART_Shift_End_Time != SIMULATOR_TIME_NEVER)) Simulator_UART_Is_Shift_Corrupted = 1;
+
+	// The unlock sequence must be written right before the write is started
+	if ((Register_Index != SIMULATOR_REGISTER_eecon2) && (Register_Index != SIMULATOR_REGISTER_eecon1)) Simulator_EEPROM_Unlock_Step = 0;
+
+	// The comparator output follows its configuration and its reference voltage changes immediately
+	if ((Register_Index == SIMULATOR_REGISTER_cm1con0) || (Register_Index == SIMULATOR_REGISTER_cm2con1) || (Register_Index == SIMULATOR_REGISTER_vrefcon0) || (Register_Index == SIMULATOR_REGISTER_vrefcon1) || (Register_Index == SIMULATOR_REGISTER_vrefcon2)) SimulatorUpdateComparator();
+
+	SimulatorScheduleNextEvent();
+}
+
+/** Put the registers in their power-on reset state. */
+static void SimulatorResetRegisters(void)
+{
+	int i;
+
+	for (i = 0; i < SIMULATOR_REGISTERS_COUNT; i++) Simulator_Registers[i] = 0;
+	Simulator_Registers[SIMULATOR_REGISTER_trisa] = 0xFF;
+	Simulator_Registers[SIMULATOR_REGISTER_trisb] = 0xFF;
+	Simulator_Registers[SIMULATOR_REGISTER_trisc] = 0xFF;
+	Simulator_Registers[SIMULATOR_REGISTER_ansel] = 0xFF;
+	Simulator_Registers[SIMULATOR_REGISTER_anselh] = 0x0F;
+	Simulator_Registers[SIMULATOR_REGISTER_t0con] = 0xFF;
+	Simulator_Registers[SIMULATOR_REGISTER_osccon] = 0x3C; // 1MHz HFINTOSC, stable
+	Simulator_Registers[SIMULATOR_REGISTER_rcon] = 0x1C;
+	Simulator_Registers[SIMULATOR_REGISTER_intcon2] = 0xF5;
+	Simulator_Registers[SIMULATOR_REGISTER_intcon3] = 0xC0;
+	Simulator_Registers[SIMULATOR_REGISTER_ipr1] = 0x7F;
+	Simulator_Registers[SIMULATOR_REGISTER_ipr2] = 0xFF;
+	Simulator_Registers[SIMULATOR_REGISTER_vrefcon0] = 0x10;
+	Simulator_Registers[SIMULATOR_REGISTER_txsta] = 0x02;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Register access operators
+//--------------------------------------------------------------------------------------------------
+TSimulatorBit::operator unsigned char() const
+{
+	return SimulatorReadRegisterBit(Register_Index, Bit_Index);
+}
+
+TSimulatorBit &TSimulatorBit::operator=(unsigned char Value)
+{
+	SimulatorWriteRegisterBit(Register_Index, Bit_Index, Value);
+	return *this;
+}
+
+TSimulatorBit &TSimulatorBit::operator=(const TSimulatorBit &Bit)
+{
+	SimulatorWriteRegisterBit(Register_Index, Bit_Index, SimulatorReadRegisterBit(Bit.Register_Index, Bit.Bit_Index));
+	return *this;
+}
+
+TSimulatorRegister::TSimulatorRegister(unsigned char Register_Index)
+{
+	Index = Register_Index;
+	#define SIMULATOR_INITIALIZE_BIT(Name, Position) Name.Register_Index = Register_Index; Name.Bit_Index = Position;
+	SIMULATOR_BITS(SIMULATOR_INITIALIZE_BIT)
+	#undef SIMULATOR_INITIALIZE_BIT
+}
+
+TSimulatorRegister::operator unsigned char() const
+{
+	return SimulatorReadRegister(Index);
+}
+
+TSimulatorRegister &TSimulatorRegister::operator=(unsigned char Value)
+{
+	SimulatorWriteRegister(Index, Value);
+	return *this;
+}
+
+TSimulatorRegister &TSimulatorRegister::operator=(const TSimulatorRegister &Register)
+{
+	SimulatorWriteRegister(Index, SimulatorReadRegister(Register.Index));
+	return *this;
+}
+
+TSimulatorRegister &TSimulatorRegister::operator&=(unsigned char Value)
+{
+	SimulatorWriteRegister(Index, Simulator_Registers[Index] & Value);
+	return *this;
+}
+
+TSimulatorRegister &TSimulatorRegister::operator|=(unsigned char Value)
+{
+	SimulatorWriteRegister(Index, Simulator_Registers[Index] | Value);
+	return *this;
+}
+
+TSimulatorRegister &TSimulatorRegister::operator^=(unsigned char Value)
+{
+	SimulatorWriteRegister(Index, Simulator_Registers[Index] ^ Value);
+	return *this;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Firmware library replacement
+//--------------------------------------------------------------------------------------------------
+void delay_us(unsigned char Microseconds)
+{
+	SimulatorConsumeCycles(Microseconds * (SIMULATOR_FIRMWARE_CLOCK_FREQUENCY / 1000000.0) / 4);
+}
+
+void delay_10us(unsigned char Tens_Of_Microseconds)
+{
+	unsigned char i;
+
+	for (i = 0; i < Tens_Of_Microseconds; i++) delay_us(10);
+}
+
+void delay_ms(unsigned char Milliseconds)
+{
+	unsigned char i;
+	int j;
+
+	// Let interrupts be serviced during the delay loop
+	for (i = 0; i < Milliseconds; i++)
+	{
+		for (j = 0; j < 10; j++) SimulatorConsumeCycles(SIMULATOR_FIRMWARE_CLOCK_FREQUENCY / 4 / 10000);
+	}
+}
+
+void delay_s(unsigned char Seconds)
+{
+	unsigned char i, j;
+
+	for (i = 0; i < Seconds; i++)
+	{
+		for (j = 0; j < 4; j++) delay_ms(250);
+	}
+}
+
+/** Called by the code generated with -finstrument-functions on each firmware function entry. The cycles are applied on the next register access because the scenario end can't be thrown from here. */
+extern "C" void __cyg_profile_func_enter(void *, void *)
+{
+	Simulator_Pending_Cycles += SIMULATOR_FUNCTION_CALL_CYCLES;
+
+	// A push to the full stack sets STKFUL, the stack overflow reset being disabled
+	Simulator_Stack_Depth++;
+	if (Simulator_Stack_Depth > Simulator_Statistics.Stack_Maximum_Depth) Simulator_Statistics.Stack_Maximum_Depth = Simulator_Stack_Depth;
+	if (Simulator_Stack_Depth > SIMULATOR_STACK_SIZE) SimulatorSetBit(SIMULATOR_REGISTER_stkptr, 7, 1);
+}
+
+/** Called by the code generated with -finstrument-functions on each firmware function exit. */
+extern "C" void __cyg_profile_func_exit(void *, void *)
+{
+	Simulator_Pending_Cycles += SIMULATOR_FUNCTION_CALL_CYCLES;
+	if (Simulator_Stack_Depth > 0) Simulator_Stack_Depth--;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void SimulatorRun(const TSimulatorScenario *Pointer_Scenario, TSimulatorStatistics *Pointer_Statistics)
+{
+	int i;
+
+	// Power-on reset
+	Pointer_Simulator_Scenario = Pointer_Scenario;
+	SimulatorResetRegisters();
+	Simulator_Port_A_Inputs = 0;
+	Simulator_Time = 0;
+	Simulator_End_Time = Pointer_Scenario->Duration * SIMULATOR_PICOSECONDS_PER_SECOND;
+	Simulator_Power_Mode = SIMULATOR_POWER_MODE_RUN;
+	for (i = 0; i < SIMULATOR_TIMERS_COUNT; i++) Simulator_Timer_Prescaler_Times[i] = 0;
+	Simulator_ADC_Conversion_End_Time = SIMULATOR_TIME_NEVER;
+	Simulator_Fixed_Voltage_Reference_Stable_Time = SIMULATOR_TIME_NEVER;
+	Simulator_Comparator_Sampling_Time = SIMULATOR_TIME_NEVER;
+	memset(Simulator_EEPROM, 0xFF, sizeof(Simulator_EEPROM)); // The data EEPROM is blank
+	Simulator_EEPROM_Write_End_Time = SIMULATOR_TIME_NEVER;
+	Simulator_EEPROM_Unlock_Step = 0;
+	Simulator_UART_Shift_End_Time = SIMULATOR_TIME_NEVER;
+	Simulator_UART_Is_Transmit_Register_Full = 0;
+	Simulator_Oscillator_Stable_Time = SIMULATOR_TIME_NEVER;
+	Simulator_Clock_Frequency_Index = 3; // 1MHz
+	Simulator_Watchdog_Timeout_Time = SIMULATOR_TIME_NEVER;
+	Simulator_Refresh_Tick_Time = SIMULATOR_TIME_NEVER;
+	Simulator_Button_Presses_Count = 0;
+	SimulatorScheduleButtonEvent();
+	Simulator_Interrupt_Level = SIMULATOR_INTERRUPT_LEVEL_NONE;
+	Simulator_Unsynchronized_Duration = 0;
+	Simulator_Pending_Cycles = 0;
+	Simulator_Stack_Depth = 0;
+	Simulator_Noise_Seed = 1;
+	Simulator_Displayed_Segments[0] = Simulator_Displayed_Segments[1] = 0xFF;
+	Simulator_Statistics = TSimulatorStatistics();
+	SimulatorScheduleNextEvent();
+
+	// Run the firmware until the scenario end unwinds it
+	try
+	{
+		FirmwareMain();
+	}
+	catch (TSimulatorEndOfScenario &)
+	{
+		SimulatorSynchronize();
+	}
+
+	Simulator_Statistics.Duration = (double) Simulator_Time / SIMULATOR_PICOSECONDS_PER_SECOND;
+	*Pointer_Statistics = Simulator_Statistics;
+
+	// Let the host read the firmware data, the registers accesses must neither end the scenario again nor run the interrupt handlers
+	Simulator_End_Time = SIMULATOR_TIME_NEVER;
+	SimulatorSetBit(SIMULATOR_REGISTER_intcon, 7, 0);
+	Simulator_Stack_Depth = 0;
+}
+
+void SimulatorSetUARTReceiver(TSimulatorUARTReceiver Receiver)
+{
+	Pointer_Simulator_UART_Receiver = Receiver;
+}
+
+void SimulatorSetUARTTransmitMonitor(TSimulatorUARTReceiver Monitor)
+{
+	Pointer_Simulator_UART_Transmit_Monitor = Monitor;
+}
+
+void SimulatorReadStatistics(TSimulatorStatistics *Pointer_Statistics)
+{
+	// Apply the function calls done since the last register access
+	SimulatorConsumeCycles(0);
+	SimulatorSynchronize();
+
+	Simulator_Statistics.Duration = (double) Simulator_Time / SIMULATOR_PICOSECONDS_PER_SECOND;
+	*Pointer_Statistics = Simulator_Statistics;
+}
+
+void SimulatorConsumeCycles(unsigned long Cycles)
+{
+	unsigned long Pending_Cycles = Simulator_Pending_Cycles;
+
+	// The function calls done since the last register access could have been interrupted
+	Simulator_Pending_Cycles = 0;
+	SimulatorExecutePreemptibleCycles(Pending_Cycles);
+
+	SimulatorExecuteCycles(Cycles);
+	SimulatorDispatchInterrupts();
+}
+
+void SimulatorExecuteSleep(void)
+{
+	SimulatorConsumeCycles(1);
+
+	// The SLEEP instruction clears the watchdog timer, sets TO and clears PD
+	SimulatorSynchronize();
+	if (Simulator_Watchdog_Timeout_Time != SIMULATOR_TIME_NEVER) Simulator_Watchdog_Timeout_Time = Simulator_Time + SIMULATOR_WATCHDOG_PERIOD;
+	SimulatorSetBit(SIMULATOR_REGISTER_rcon, 3, 1);
+	SimulatorSetBit(SIMULATOR_REGISTER_rcon, 2, 0);
+
+	// The core does not sleep if a wake-up interrupt is already pending
+	if (!SimulatorIsWakeUpRequested())
+	{
+		if (SimulatorGetBit(SIMULATOR_REGISTER_osccon, 7)) Simulator_Power_Mode = SIMULATOR_POWER_MODE_IDLE;
+		else
+		{
+			Simulator_Power_Mode = SIMULATOR_POWER_MODE_SLEEP;
+
+			// The baud rate generator is stopped, the receiver can't read the byte being shifted out
+			if (Simulator_UART_Shift_End_Time != SIMULATOR_TIME_NEVER) Simulator_UART_Is_Shift_Corrupted = 1;
+
+			// Conversions clocked from the instruction clock are aborted
+			if (Simulator_ADC_Clock_Dividers[Simulator_Registers[SIMULATOR_REGISTER_adcon2] & 0x07] != 0)
+			{
+				Simulator_ADC_Conversion_End_Time = SIMULATOR_TIME_NEVER;
+				SimulatorSetBit(SIMULATOR_REGISTER_adcon0, 1, 0);
+			}
+		}
+
+		SimulatorScheduleNextEvent();
+
+		// Any enabled interrupt wakes the core, even if interrupts are globally disabled, the watchdog timer too
+		Simulator_Is_Watchdog_Wake_Up = 0;
+		while (!SimulatorIsWakeUpRequested() && !Simulator_Is_Watchdog_Wake_Up) SimulatorAdvanceTime(Simulator_Next_Event_Time - Simulator_Time);
+
+		SimulatorSynchronize();
+		Simulator_Power_Mode = SIMULATOR_POWER_MODE_RUN;
+		SimulatorScheduleNextEvent();
+		Simulator_Statistics.Wakeups_Count++;
+	}
+
+	SimulatorDispatchInterrupts();
+}
+
+void SimulatorExecuteClearWatchdog(void)
+{
+	SimulatorSynchronize();
+	if (Simulator_Watchdog_Timeout_Time != SIMULATOR_TIME_NEVER) Simulator_Watchdog_Timeout_Time = Simulator_Time + SIMULATOR_WATCHDOG_PERIOD;
+	SimulatorSetBit(SIMULATOR_REGISTER_rcon, 3, 1); // Set TO
+	SimulatorSetBit(SIMULATOR_REGISTER_rcon, 2, 1); // Set PD
+	SimulatorScheduleNextEvent();
+	SimulatorConsumeCycles(1);
+}
+
+unsigned char SimulatorReadRegister(unsigned char Register_Index)
+{
+	unsigned char Value = SimulatorGetRegisterValue(Register_Index);
+
+	// In 16-bit read mode, reading TMR1L latches TMR1H so the counter is read atomically
+	if (SimulatorGetBit(SIMULATOR_REGISTER_t1con, 7))
+	{
+		if (Register_Index == SIMULATOR_REGISTER_tmr1l) Simulator_Timer_1_High_Byte_Buffer = SimulatorGetRegisterValue(SIMULATOR_REGISTER_tmr1h);
+		else if (Register_Index == SIMULATOR_REGISTER_tmr1h) Value = Simulator_Timer_1_High_Byte_Buffer;
+	}
+
+	SimulatorConsumeCycles(1);
+	return Value;
+}
+
+void SimulatorWriteRegister(unsigned char Register_Index, unsigned char Value)
+{
+	SimulatorSetRegisterValue(Register_Index, Value);
+	SimulatorConsumeCycles(1);
+}
+
+unsigned char SimulatorReadRegisterBit(unsigned char Register_Index, unsigned char Bit_Index)
+{
+	unsigned char Value = (SimulatorGetRegisterValue(Register_Index) >> Bit_Index) & 1;
+	int i;
+
+	// Attribute the following handler code to the interrupt source whose flag has just been found set, a source that triggered while the handler was running is serviced by the same invocation
+	if ((Simulator_Interrupt_Level != SIMULATOR_INTERRUPT_LEVEL_NONE) && Value)
+	{
+		for (i = 0; i < SIMULATOR_INTERRUPT_SOURCES_COUNT; i++)
+		{
+			if ((Simulator_Interrupt_Sources[i].Flag_Register_Index != Register_Index) || (Simulator_Interrupt_Sources[i].Flag_Bit_Index != Bit_Index)) continue;
+			if ((Simulator_Interrupt_Triggering_Sources & (1 << i)) || (SimulatorGetPendingInterrupts() & (1 << i)))
+			{
+				Simulator_Interrupt_Triggering_Sources |= 1 << i;
+				Simulator_Interrupt_Current_Source = (TSimulatorInterruptSource) i;
+				break;
+			}
+		}
+	}
+
+	SimulatorConsumeCycles(1);
+	return Value;
+}
+
+void SimulatorWriteRegisterBit(unsigned char Register_Index, unsigned char Bit_Index, unsigned char Value)
+{
+	unsigned char Register_Value = Simulator_Registers[Register_Index];
+
+	if (Value) Register_Value |= 1 << Bit_Index;
+	else Register_Value &= ~(1 << Bit_Index);
+	SimulatorSetRegisterValue(Register_Index, Register_Value);
+	SimulatorConsumeCycles(1);
+}
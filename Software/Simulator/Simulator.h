@@ -0,0 +1,289 @@
+/** @file Simulator.h
+ * Host-side model of the PIC18F13K22 peripherals used by the thermometer firmware. It keeps a simulated register file, runs the timers, the watchdog timer, the ADC, the fixed voltage reference, the DAC, comparator 1, the data EEPROM, the EUSART transmitter and the return address stack pointer, dispatches interrupts to the firmware interrupt() handler and integrates the current drawn by the board in each power mode.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#ifndef H_SIMULATOR_H
+#define H_SIMULATOR_H
+
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+/** All simulated special function registers. */
+#define SIMULATOR_REGISTERS(X) \
+	X(porta) X(portb) X(portc) X(trisa) X(trisb) X(trisc) X(ansel) X(anselh) \
+	X(adcon0) X(adcon1) X(adcon2) X(adresh) X(adresl) \
+	X(t0con) X(tmr0l) X(tmr0h) X(t1con) X(tmr1l) X(tmr1h) X(t3con) X(tmr3l) X(tmr3h) \
+	X(osccon) X(rcon) X(wdtcon) X(stkptr) X(intcon) X(intcon2) X(intcon3) X(pie1) X(pir1) X(ipr1) X(pie2) X(pir2) X(ipr2) \
+	X(vrefcon0) X(vrefcon1) X(vrefcon2) X(cm1con0) X(cm2con1) \
+	X(eeadr) X(eedata) X(eecon1) X(eecon2) \
+	X(txsta) X(rcsta) X(baudcon) X(spbrg) X(spbrgh) X(txreg)
+
+/** All register bit names with their position (a name designates the same bit position in every register it is used with, like the BoostC bit constants do). */
+#define SIMULATOR_BITS(X) \
+	X(RA0, 0) X(RA1, 1) X(RA2, 2) X(RA3, 3) X(RA4, 4) X(RA5, 5) \
+	X(RB4, 4) X(RB5, 5) X(RB6, 6) X(RB7, 7) \
+	X(RC0, 0) X(RC1, 1) X(RC2, 2) X(RC3, 3) X(RC4, 4) X(RC5, 5) X(RC6, 6) X(RC7, 7) \
+	X(AN0, 0) X(AN1, 1) X(AN2, 2) X(AN3, 3) X(AN4, 4) X(AN5, 5) X(AN6, 6) X(AN7, 7) X(AN8, 0) X(AN9, 1) X(AN10, 2) X(AN11, 3) \
+	X(ADON, 0) X(GO, 1) X(GO_DONE, 1) X(CHS0, 2) X(CHS1, 3) X(CHS2, 4) X(CHS3, 5) \
+	X(NVCFG0, 0) X(NVCFG1, 1) X(PVCFG0, 2) X(PVCFG1, 3) \
+	X(ADCS0, 0) X(ADCS1, 1) X(ADCS2, 2) X(ACQT0, 3) X(ACQT1, 4) X(ACQT2, 5) X(ADFM, 7) \
+	X(T0PS0, 0) X(T0PS1, 1) X(T0PS2, 2) X(PSA, 3) X(T0SE, 4) X(T0CS, 5) X(T08BIT, 6) X(TMR0ON, 7) \
+	X(TMR1ON, 0) X(TMR1CS, 1) X(T1SYNC, 2) X(T1OSCEN, 3) X(T1CKPS0, 4) X(T1CKPS1, 5) X(T1RUN, 6) X(RD16, 7) \
+	X(TMR3ON, 0) X(TMR3CS, 1) X(T3SYNC, 2) X(T3CCP1, 3) X(T3CKPS0, 4) X(T3CKPS1, 5) \
+	X(SCS0, 0) X(SCS1, 1) X(HFIOFS, 2) X(OSTS, 3) X(IRCF0, 4) X(IRCF1, 5) X(IRCF2, 6) X(IDLEN, 7) \
+	X(BOR, 0) X(POR, 1) X(PD, 2) X(TO, 3) X(RI, 4) X(SBOREN, 6) X(IPEN, 7) \
+	X(SWDTEN, 0) \
+	X(STKUNF, 6) X(STKFUL, 7) \
+	X(RABIF, 0) X(INT0IF, 1) X(TMR0IF, 2) X(RABIE, 3) X(INT0IE, 4) X(TMR0IE, 5) X(PEIE, 6) X(GIEL, 6) X(GIE, 7) X(GIEH, 7) \
+	X(RABIP, 0) X(TMR0IP, 2) X(INTEDG2, 4) X(INTEDG1, 5) X(INTEDG0, 6) X(RABPU, 7) \
+	X(INT1IF, 0) X(INT2IF, 1) X(INT1IE, 3) X(INT2IE, 4) X(INT1IP, 6) X(INT2IP, 7) \
+	X(TMR1IE, 0) X(TMR2IE, 1) X(CCP1IE, 2) X(SSPIE, 3) X(TXIE, 4) X(RCIE, 5) X(ADIE, 6) \
+	X(TMR1IF, 0) X(TMR2IF, 1) X(CCP1IF, 2) X(SSPIF, 3) X(TXIF, 4) X(RCIF, 5) X(ADIF, 6) \
+	X(TMR1IP, 0) X(TMR2IP, 1) X(CCP1IP, 2) X(SSPIP, 3) X(TXIP, 4) X(RCIP, 5) X(ADIP, 6) \
+	X(TMR3IE, 1) X(BCLIE, 3) X(EEIE, 4) X(C2IE, 5) X(C1IE, 6) X(OSCFIE, 7) \
+	X(TMR3IF, 1) X(BCLIF, 3) X(EEIF, 4) X(C2IF, 5) X(C1IF, 6) X(OSCFIF, 7) \
+	X(TMR3IP, 1) X(BCLIP, 3) X(EEIP, 4) X(C2IP, 5) X(C1IP, 6) X(OSCFIP, 7) \
+	X(FVR1S0, 4) X(FVR1S1, 5) X(FVR1ST, 6) X(FVR1EN, 7) \
+	X(D1NSS, 0) X(D1PSS0, 2) X(D1PSS1, 3) X(DAC1OE, 5) X(D1LPS, 6) X(D1EN, 7) \
+	X(DAC1R0, 0) X(DAC1R1, 1) X(DAC1R2, 2) X(DAC1R3, 3) X(DAC1R4, 4) \
+	X(C1CH0, 0) X(C1CH1, 1) X(C1R, 2) X(C1SP, 3) X(C1POL, 4) X(C1OE, 5) X(C1OUT, 6) X(C1ON, 7) \
+	X(C2SYNC, 0) X(C1SYNC, 1) X(C2HYS, 2) X(C1HYS, 3) X(C2RSEL, 4) X(C1RSEL, 5) X(MC2OUT, 6) X(MC1OUT, 7) \
+	X(RD, 0) X(WR, 1) X(WREN, 2) X(WRERR, 3) X(FREE, 4) X(CFGS, 6) X(EEPGD, 7) \
+	X(TX9D, 0) X(TRMT, 1) X(BRGH, 2) X(SENDB, 3) X(SYNC, 4) X(TXEN, 5) X(TX9, 6) X(CSRC, 7) \
+	X(RX9D, 0) X(OERR, 1) X(FERR, 2) X(ADDEN, 3) X(CREN, 4) X(SREN, 5) X(RX9, 6) X(SPEN, 7) \
+	X(ABDEN, 0) X(WUE, 1) X(BRG16, 3) X(CKTXP, 4) X(DTRXP, 5) X(RCIDL, 6) X(ABDOVF, 7)
+
+/** All interrupt sources the simulator can dispatch, with their enable, flag and priority bits (the last parameter tells whether the source is gated by PEIE). INT0 is always a high priority source, IPEN is used as its priority bit because it is set whenever priorities matter. */
+#define SIMULATOR_INTERRUPT_SOURCES(X) \
+	X(TIMER_0, "Timer 0", intcon, TMR0IE, intcon, TMR0IF, intcon2, TMR0IP, 0) \
+	X(INT0, "INT0", intcon, INT0IE, intcon, INT0IF, rcon, IPEN, 0) \
+	X(PORT_CHANGE, "Port change", intcon, RABIE, intcon, RABIF, intcon2, RABIP, 0) \
+	X(TIMER_1, "Timer 1", pie1, TMR1IE, pir1, TMR1IF, ipr1, TMR1IP, 1) \
+	X(TIMER_2, "Timer 2", pie1, TMR2IE, pir1, TMR2IF, ipr1, TMR2IP, 1) \
+	X(ADC, "ADC", pie1, ADIE, pir1, ADIF, ipr1, ADIP, 1) \
+	X(UART_TRANSMIT, "EUSART TX", pie1, TXIE, pir1, TXIF, ipr1, TXIP, 1) \
+	X(TIMER_3, "Timer 3", pie2, TMR3IE, pir2, TMR3IF, ipr2, TMR3IP, 1) \
+	X(COMPARATOR_1, "Comparator 1", pie2, C1IE, pir2, C1IF, ipr2, C1IP, 1) \
+	X(EEPROM, "EEPROM", pie2, EEIE, pir2, EEIF, ipr2, EEIP, 1)
+
+/** Repeat a button press until the scenario end. */
+#define SIMULATOR_BUTTON_PRESSES_UNLIMITED 0xFFFFFFFFUL
+
+/** The data EEPROM size in bytes. */
+#define SIMULATOR_EEPROM_SIZE 256
+
+/** The bit rate of the receiver connected to the EUSART TX pin. */
+#define SIMULATOR_UART_BAUD_RATE 2400
+
+/** How many return addresses the hardware stack can hold. */
+#define SIMULATOR_STACK_SIZE 31
+
+/** How many picoseconds last one second. */
+#define SIMULATOR_PICOSECONDS_PER_SECOND 1000000000000ULL
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** Identify each simulated register. */
+typedef enum
+{
+	#define SIMULATOR_DECLARE_REGISTER_INDEX(Name) SIMULATOR_REGISTER_##Name,
+	SIMULATOR_REGISTERS(SIMULATOR_DECLARE_REGISTER_INDEX)
+	#undef SIMULATOR_DECLARE_REGISTER_INDEX
+	SIMULATOR_REGISTERS_COUNT
+} TSimulatorRegisterIndex;
+
+/** Identify each interrupt source. */
+typedef enum
+{
+	#define SIMULATOR_DECLARE_INTERRUPT_SOURCE(Identifier, Name, Enable_Register, Enable_Bit, Flag_Register, Flag_Bit, Priority_Register, Priority_Bit, Is_Peripheral) SIMULATOR_INTERRUPT_SOURCE_##Identifier,
+	SIMULATOR_INTERRUPT_SOURCES(SIMULATOR_DECLARE_INTERRUPT_SOURCE)
+	#undef SIMULATOR_DECLARE_INTERRUPT_SOURCE
+	SIMULATOR_INTERRUPT_SOURCES_COUNT
+} TSimulatorInterruptSource;
+
+/** Identify the consumers the charge drawn from the battery is split between. */
+typedef enum
+{
+	SIMULATOR_CONSUMER_CORE,
+	SIMULATOR_CONSUMER_DISPLAY,
+	SIMULATOR_CONSUMER_LEDS,
+	SIMULATOR_CONSUMER_FIXED_VOLTAGE_REFERENCE,
+	SIMULATOR_CONSUMER_ADC,
+	SIMULATOR_CONSUMER_COMPARATOR, //!< Comparator 1 and the DAC generating its threshold.
+	SIMULATOR_CONSUMER_SENSOR,
+	SIMULATOR_CONSUMER_EEPROM, //!< The data EEPROM cells programming.
+	SIMULATOR_CONSUMERS_COUNT
+} TSimulatorConsumer;
+
+/** The processor core power modes. */
+typedef enum
+{
+	SIMULATOR_POWER_MODE_RUN,
+	SIMULATOR_POWER_MODE_IDLE,
+	SIMULATOR_POWER_MODE_SLEEP,
+	SIMULATOR_POWER_MODES_COUNT
+} TSimulatorPowerMode;
+
+/** A single bit of a simulated register. Reading or writing it goes through the simulator so that accesses cost cycles and trigger the peripherals side effects. */
+struct TSimulatorBit
+{
+	unsigned char Register_Index;
+	unsigned char Bit_Index;
+
+	operator unsigned char() const;
+	TSimulatorBit &operator=(unsigned char Value);
+	TSimulatorBit &operator=(const TSimulatorBit &Bit);
+};
+
+/** A simulated 8-bit special function register, all the bit names are available as members. */
+struct TSimulatorRegister
+{
+	unsigned char Index;
+	#define SIMULATOR_DECLARE_BIT(Name, Position) TSimulatorBit Name;
+	SIMULATOR_BITS(SIMULATOR_DECLARE_BIT)
+	#undef SIMULATOR_DECLARE_BIT
+
+	explicit TSimulatorRegister(unsigned char Register_Index);
+	operator unsigned char() const;
+	TSimulatorRegister &operator=(unsigned char Value);
+	TSimulatorRegister &operator=(const TSimulatorRegister &Register);
+	TSimulatorRegister &operator&=(unsigned char Value);
+	TSimulatorRegister &operator|=(unsigned char Value);
+	TSimulatorRegister &operator^=(unsigned char Value);
+};
+
+/** A button press sequence (Count presses of Duration milliseconds separated by Period milliseconds, the first one occurring at Start milliseconds). */
+typedef struct
+{
+	unsigned long Start;
+	unsigned long Count; //!< Set to SIMULATOR_BUTTON_PRESSES_UNLIMITED to repeat the press until the end of the scenario.
+	unsigned long Period;
+	unsigned long Duration; //!< How long the user keeps the button pushed.
+} TSimulatorButtonPresses;
+
+/** Describe the environment the firmware is run in. */
+typedef struct
+{
+	const char *Pointer_String_Name; //!< The scenario name.
+	unsigned long Duration; //!< How many seconds to simulate.
+	TSimulatorButtonPresses Button_Presses; //!< When the user pushes the button.
+	double (*Temperature)(double Time); //!< Return the sensor temperature in Celsius degrees at the provided time (in seconds).
+	double ADC_Noise; //!< Peak amplitude of the noise added to each ADC sample (in LSB).
+	double Supply_Voltage; //!< The battery voltage in volts.
+} TSimulatorScenario;
+
+/** Everything measured during a simulation run. */
+typedef struct
+{
+	double Duration; //!< Simulated time in seconds.
+	double Charge[SIMULATOR_CONSUMERS_COUNT]; //!< Charge drawn by each consumer in uA.s.
+	double Power_Mode_Time[SIMULATOR_POWER_MODES_COUNT]; //!< Time spent in each core power mode in seconds.
+	unsigned long long Cycles; //!< All executed instruction cycles.
+	unsigned long long Interrupt_Cycles[SIMULATOR_INTERRUPT_SOURCES_COUNT]; //!< Instruction cycles spent servicing each interrupt source.
+	unsigned long Interrupt_Maximum_Cycles[SIMULATOR_INTERRUPT_SOURCES_COUNT]; //!< The longest servicing of each interrupt source.
+	unsigned long Interrupt_Count[SIMULATOR_INTERRUPT_SOURCES_COUNT]; //!< How many times each interrupt source has been serviced.
+	unsigned long Wakeups_Count; //!< How many times the core left the idle or sleep mode.
+	unsigned long Conversions_Count; //!< How many ADC conversions have been done.
+	unsigned long Fixed_Voltage_Reference_Enables_Count; //!< How many times the fixed voltage reference has been powered up.
+	double Fixed_Voltage_Reference_Time; //!< How long the fixed voltage reference has been powered in seconds.
+	unsigned long Refreshes_Count; //!< How many times a 7-segment display has been enabled after a Timer 0 overflow.
+	unsigned long long Refresh_Minimum_Delay; //!< The shortest time between a Timer 0 overflow and the next display enabling in picoseconds.
+	unsigned long long Refresh_Maximum_Delay; //!< The longest time between a Timer 0 overflow and the next display enabling in picoseconds.
+	unsigned long Display_Changes_Count; //!< How many times a 7-segment display has been enabled with other segments than the previous time.
+	unsigned long EEPROM_Writes_Count; //!< How many data EEPROM bytes have been written.
+	unsigned long EEPROM_Cell_Writes_Count[SIMULATOR_EEPROM_SIZE]; //!< How many times each data EEPROM byte has been written.
+	unsigned long UART_Bytes_Count; //!< How many bytes the EUSART has shifted out.
+	unsigned long UART_Framing_Errors_Count; //!< How many shifted out bytes the receiver could not read, because the bit rate was wrong or changed during the byte.
+	double UART_Enabled_Time; //!< How long the EUSART transmitter has been powered in seconds.
+	unsigned int Stack_Maximum_Depth; //!< The most return addresses the firmware had on the hardware stack (more than SIMULATOR_STACK_SIZE means that the stack overflowed).
+} TSimulatorStatistics;
+
+/** Called each time the receiver connected to the EUSART TX pin reads a byte.
+ * @param Byte The received byte.
+ */
+typedef void (*TSimulatorUARTReceiver)(unsigned char Byte);
+
+//--------------------------------------------------------------------------------------------------
+// Variables
+//--------------------------------------------------------------------------------------------------
+#define SIMULATOR_DECLARE_REGISTER(Name) extern TSimulatorRegister Name;
+SIMULATOR_REGISTERS(SIMULATOR_DECLARE_REGISTER)
+#undef SIMULATOR_DECLARE_REGISTER
+
+/** The human-readable interrupt sources name. */
+extern const char *Simulator_Interrupt_Source_Names[SIMULATOR_INTERRUPT_SOURCES_COUNT];
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** The firmware entry point (the firmware main() function is renamed by the host system.h). */
+void FirmwareMain(void);
+
+/** The firmware interrupt handler (the high priority one when interrupt priorities are enabled). */
+void interrupt(void);
+
+/** The firmware low priority interrupt handler, only called when interrupt priorities are enabled. */
+void interrupt_low(void);
+
+/** Run the firmware from power-on reset until the scenario duration is elapsed. The firmware functions can be called afterwards to read its data, the interrupts being disabled and the time not bounded anymore.
+ * @param Pointer_Scenario The scenario to simulate.
+ * @param Pointer_Statistics On output, contain the measurements done during the run.
+ * @warning The firmware static variables are not reset, so a scenario must be run only once per process.
+ */
+void SimulatorRun(const TSimulatorScenario *Pointer_Scenario, TSimulatorStatistics *Pointer_Statistics);
+
+/** Connect a receiver to the EUSART TX pin, it reads the bytes sent at SIMULATOR_UART_BAUD_RATE bauds.
+ * @param Receiver The function called on each received byte, NULL disconnects the receiver.
+ */
+void SimulatorSetUARTReceiver(TSimulatorUARTReceiver Receiver);
+
+/** Watch the bytes the firmware writes to the EUSART TXREG register, before they are shifted out on the serial line.
+ * @param Monitor The function called on each written byte, NULL disconnects the monitor.
+ */
+void SimulatorSetUARTTransmitMonitor(TSimulatorUARTReceiver Monitor);
+
+/** Get the measurements done since the power-on reset, the firmware functions called after the run included.
+ * @param Pointer_Statistics On output, contain the measurements.
+ */
+void SimulatorReadStatistics(TSimulatorStatistics *Pointer_Statistics);
+
+/** Execute instructions on the simulated core. Peripherals are updated and pending interrupts are dispatched.
+ * @param Cycles How many instruction cycles to execute.
+ */
+void SimulatorConsumeCycles(unsigned long Cycles);
+
+/** Execute the SLEEP instruction. Enter idle or sleep mode according to OSCCON.IDLEN and return when an enabled interrupt or the watchdog timer wakes the core. */
+void SimulatorExecuteSleep(void);
+
+/** Execute the CLRWDT instruction. */
+void SimulatorExecuteClearWatchdog(void);
+
+/** Read a register, costing one instruction cycle.
+ * @param Register_Index The register to read.
+ * @return The register value.
+ */
+unsigned char SimulatorReadRegister(unsigned char Register_Index);
+
+/** Write a register, costing one instruction cycle.
+ * @param Register_Index The register to write.
+ * @param Value The value to write.
+ */
+void SimulatorWriteRegister(unsigned char Register_Index, unsigned char Value);
+
+/** Read a single register bit, costing one instruction cycle.
+ * @param Register_Index The register to read.
+ * @param Bit_Index The bit to read.
+ * @return The bit value.
+ */
+unsigned char SimulatorReadRegisterBit(unsigned char Register_Index, unsigned char Bit_Index);
+
+/** Set or clear a single register bit, costing one instruction cycle.
+ * @param Register_Index The register to modify.
+ * @param Bit_Index The bit to modify.
+ * @param Value The bit value.
+ */
+void SimulatorWriteRegisterBit(unsigned char Register_Index, unsigned char Bit_Index, unsigned char Value);
+
+#endif
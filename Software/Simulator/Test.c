@@ -0,0 +1,726 @@
+/** @file Test.c
+ * Check firmware algorithms against straightforward reference implementations on the simulated processor : the conversion of all ADC codes to character codes, the temperature sampling intervals when scans are aborted, the data EEPROM records ring over the thermometer lifetime, the last 24 hours peaks, the temperature history across resets, the conversion of values to their two most significant digits and the battery runtime estimate. Main.c is included to reach its private functions, so this file is built with the firmware options.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../Main.c"
+#include "Simulator.h"
+
+// The host system.h renamed the firmware main() function, the test program needs its own entry point
+#undef main
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+/** How many codes the 10-bit ADC can return. */
+#define TEST_ADC_CODES_COUNT 1024
+
+/** The instruction cycles a 16-bit software division costs : a shift and subtract loop of 16 iterations of about 13 cycles, plus the operands sign handling. */
+#define TEST_SOFTWARE_DIVISION_CYCLES 230
+
+/** How many temperature scans the sampling test starts. */
+#define TEST_SAMPLING_SCANS_COUNT 32
+/** Abort one temperature scan out of this count, like entering low power mode in the middle of a scan does. */
+#define TEST_SAMPLING_ABORTED_SCANS_PERIOD 4
+/** The longest sampling interval the temperature module allows, in sampling periods. */
+#define TEST_SAMPLING_MAXIMUM_PERIODS 128
+
+/** How many years of state saves the data EEPROM test writes. */
+#define TEST_EEPROM_YEARS 10
+/** How many times a data EEPROM cell can be written (the PIC18F13K22 guaranteed minimum). */
+#define TEST_EEPROM_CELL_ENDURANCE 100000
+/** How many sequence numbers a record can have before they wrap around (0xFF is the erased slot value). */
+#define TEST_EEPROM_SEQUENCES_COUNT 255
+
+/** How many random temperature traces the window test feeds. */
+#define TEST_WINDOW_TRACES_COUNT 4
+/** How many minutes a window test trace lasts (100 days, so the buckets sequence numbers wrap around). */
+#define TEST_WINDOW_TRACE_MINUTES (100UL * 24 * 60)
+/** The most samples a window test trace adds in one minute. */
+#define TEST_WINDOW_MAXIMUM_SAMPLES_PER_MINUTE 4
+/** How many samples the window can span at most. */
+#define TEST_WINDOW_MAXIMUM_SAMPLES_COUNT (WINDOW_BUCKETS_COUNT * WINDOW_BUCKET_PERIOD * TEST_WINDOW_MAXIMUM_SAMPLES_PER_MINUTE)
+
+/** How many samples the history test stores. */
+#define TEST_HISTORY_SAMPLES_COUNT 20000
+/** The history test simulates a reset once every this amount of samples on average. */
+#define TEST_HISTORY_RESETS_PERIOD 500
+/** The history test compares all stored samples once every this amount of samples, and after each reset. */
+#define TEST_HISTORY_CHECKS_PERIOD 97
+
+/** The values test converts all values from zero to this one. */
+#define TEST_VALUES_MAXIMUM 2000000UL
+
+/** How many random battery uses the runtime test estimates. */
+#define TEST_RUNTIME_ESTIMATES_COUNT 1000000
+/** The smallest average current drawn by a random battery use, in uA. */
+#define TEST_RUNTIME_MINIMUM_CURRENT 20.0
+/** The largest average current drawn by a random battery use, in uA. */
+#define TEST_RUNTIME_MAXIMUM_CURRENT 30000.0
+/** The battery capacity in the uAs / 16 units EnergyReadConsumedCharge() returns. */
+#define TEST_RUNTIME_BATTERY_CHARGE (ENERGY_BATTERY_CAPACITY * 3600000.0 / 16)
+/** The battery voltage conversion result corresponding to ENERGY_BATTERY_FULL_VOLTAGE, computed like the energy module does. */
+#define TEST_RUNTIME_FULL_VOLTAGE_VALUE ((unsigned short) (1024UL * 1023 / ENERGY_BATTERY_FULL_VOLTAGE))
+
+//--------------------------------------------------------------------------------------------------
+// Private types
+//--------------------------------------------------------------------------------------------------
+/** A sample recorded by the window test. */
+typedef struct
+{
+	unsigned long Bucket_Index; //!< The bucket the sample was added to, it never wraps around.
+	signed short Temperature; //!< The sample in tenths of Celsius degrees.
+} TTestWindowSample;
+
+/** A test case. */
+typedef struct
+{
+	const char *Pointer_String_Name; //!< The test name.
+	int (*Run)(void); //!< Return 0 if the test passed, or -1 if it failed.
+} TTest;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** A constant temperature, the tests drive the firmware functions directly.
+ * @return The temperature in Celsius degrees.
+ */
+static double TestTemperatureStable(double)
+{
+	return 20;
+}
+
+/** Get the executed instruction cycles count.
+ * @return The cycles count.
+ */
+static unsigned long long TestReadCyclesCount(void)
+{
+	TSimulatorStatistics Statistics;
+
+	SimulatorReadStatistics(&Statistics);
+	return Statistics.Cycles;
+}
+
+/** Divide like the BoostC library does, charging the software division cost to the simulated core.
+ * @param Dividend The dividend.
+ * @param Divisor The divisor.
+ * @return The quotient, rounded toward zero.
+ */
+static signed short TestDivide(signed short Dividend, signed short Divisor)
+{
+	SimulatorConsumeCycles(TEST_SOFTWARE_DIVISION_CYCLES);
+	return Dividend / Divisor;
+}
+
+/** The temperature to character codes conversion the firmware used before the divisions were removed, it is the reference the current conversion must match.
+ * @param Temperature The temperature in tenths of Celsius degrees.
+ * @param Pointer_Left_Character On output, will contain the left character code.
+ * @param Pointer_Right_Character On output, will contain the right character code.
+ */
+static void TestConvertTemperatureWithDivisions(signed short Temperature, unsigned char *Pointer_Left_Character, unsigned char *Pointer_Right_Character)
+{
+	signed char Value;
+	unsigned char Divided_By_Ten;
+
+	// Display the units followed by the decimal point when there is room for the decimal
+	if ((Temperature > -10) && (Temperature < 100))
+	{
+		if (Temperature < 0)
+		{
+			*Pointer_Left_Character = SCREEN_CHARACTER_CODE_MINUS | SCREEN_CHARACTER_FLAG_DOT;
+			*Pointer_Right_Character = (unsigned char) -Temperature;
+		}
+		else
+		{
+			Divided_By_Ten = (unsigned char) TestDivide(Temperature, 10);
+			*Pointer_Left_Character = Divided_By_Ten | SCREEN_CHARACTER_FLAG_DOT;
+			*Pointer_Right_Character = (unsigned char) Temperature - Divided_By_Ten * 10;
+		}
+		return;
+	}
+
+	// Display Celsius degrees
+	Value = (signed char) TestDivide(Temperature, 10);
+	if ((Value < -9) || (Value > 99))
+	{
+		*Pointer_Left_Character = SCREEN_CHARACTER_CODE_MINUS;
+		*Pointer_Right_Character = SCREEN_CHARACTER_CODE_MINUS;
+		return;
+	}
+
+	if (Value < 0)
+	{
+		*Pointer_Left_Character = SCREEN_CHARACTER_CODE_MINUS;
+		Value = -Value;
+	}
+	else if (Value >= 10)
+	{
+		Divided_By_Ten = (unsigned char) TestDivide(Value, 10);
+		*Pointer_Left_Character = Divided_By_Ten;
+		Value -= Divided_By_Ten * 10;
+	}
+	else *Pointer_Left_Character = SCREEN_CHARACTER_CODE_EMPTY;
+	*Pointer_Right_Character = (unsigned char) Value;
+}
+
+/** Convert each ADC code to the displayed character codes and compare them with the conversion based on software divisions, then report the cycles both conversions take.
+ * @return 0 if all codes are converted like the reference does,
+ * @return -1 if a code is converted differently.
+ */
+static int TestConvertADCCodes(void)
+{
+	unsigned long long Cycles, Minimum_Cycles[2] = {~0ULL, ~0ULL}, Maximum_Cycles[2] = {0, 0}, Total_Cycles[2] = {0, 0};
+	unsigned char Left_Character, Right_Character, Expected_Left_Character, Expected_Right_Character;
+	unsigned long Mismatches_Count = 0;
+	signed short Temperature;
+	int Code, i;
+
+	for (Code = 0; Code < TEST_ADC_CODES_COUNT; Code++)
+	{
+		// One ADC LSB is one millivolt or one tenth of Celsius degree, with the TMP36 500mV offset
+		Temperature = (signed short) (Code - 500);
+
+		Cycles = TestReadCyclesCount();
+		ConvertTemperatureToCharacterCodes(Temperature, &Left_Character, &Right_Character);
+		Cycles = TestReadCyclesCount() - Cycles;
+		if (Cycles < Minimum_Cycles[0]) Minimum_Cycles[0] = Cycles;
+		if (Cycles > Maximum_Cycles[0]) Maximum_Cycles[0] = Cycles;
+		Total_Cycles[0] += Cycles;
+
+		Cycles = TestReadCyclesCount();
+		TestConvertTemperatureWithDivisions(Temperature, &Expected_Left_Character, &Expected_Right_Character);
+		Cycles = TestReadCyclesCount() - Cycles;
+		if (Cycles < Minimum_Cycles[1]) Minimum_Cycles[1] = Cycles;
+		if (Cycles > Maximum_Cycles[1]) Maximum_Cycles[1] = Cycles;
+		Total_Cycles[1] += Cycles;
+
+		if ((Left_Character != Expected_Left_Character) || (Right_Character != Expected_Right_Character))
+		{
+			printf("Error : ADC code %d (%d tenths of Celsius degree) is converted to 0x%02X 0x%02X instead of 0x%02X 0x%02X.\n", Code, Temperature, Left_Character, Right_Character, Expected_Left_Character, Expected_Right_Character);
+			Mismatches_Count++;
+		}
+	}
+
+	printf("ADC codes       : %d converted, %lu mismatches\n", TEST_ADC_CODES_COUNT, Mismatches_Count);
+	printf("Cycles          : conversion        minimum   average   maximum\n");
+	for (i = 0; i < 2; i++) printf("                  %-16s %8llu %9.1f %9llu\n", i == 0 ? "division-free" : "with divisions", Minimum_Cycles[i], (double) Total_Cycles[i] / TEST_ADC_CODES_COUNT, Maximum_Cycles[i]);
+	printf("                  (calls, returns and %d cycles per software division, the other arithmetic instructions are not simulated)\n", TEST_SOFTWARE_DIVISION_CYCLES);
+
+	if (Mismatches_Count > 0) return -1;
+	return 0;
+}
+
+/** Complete some temperature scans and abort the others, the next scan must always be started after the current sampling interval.
+ * @return 0 if no sampling interval exceeded the longest allowed one,
+ * @return -1 if a sampling interval was too long.
+ */
+static int TestAbortTemperatureScans(void)
+{
+	unsigned int Periods_Count, Scan;
+	int Return_Value = 0;
+
+	ADCInitialize();
+	TemperatureInitialize();
+
+	printf("Sampling periods before each scan (* : the scan is aborted) :\n");
+	for (Scan = 0; Scan < TEST_SAMPLING_SCANS_COUNT; Scan++)
+	{
+		// Call the module at the end of each sampling period until it requests a sample
+		Periods_Count = 1;
+		while (!TemperatureIsSamplingNeeded())
+		{
+			Periods_Count++;
+			if (Periods_Count > TEST_SAMPLING_MAXIMUM_PERIODS) break;
+		}
+		if (Periods_Count > TEST_SAMPLING_MAXIMUM_PERIODS)
+		{
+			printf("\nError : no sample was requested during the %d sampling periods before scan %u.\n", TEST_SAMPLING_MAXIMUM_PERIODS, Scan);
+			Return_Value = -1;
+			break;
+		}
+
+		StartMeasurements();
+		while (!ADCIsReady());
+		HandleMeasurementsTick(); // The next tick queues the conversions
+		if ((Scan % TEST_SAMPLING_ABORTED_SCANS_PERIOD) == TEST_SAMPLING_ABORTED_SCANS_PERIOD - 1)
+		{
+			ADCSetPowerMode(1); // Enter low power mode before the conversions end
+			printf("%u* ", Periods_Count);
+		}
+		else
+		{
+			// Service the conversions like the interrupt handler does, until the whole scan is done
+			while (!(Pending_Events & EVENT_TEMPERATURE_SAMPLE_AVAILABLE))
+			{
+				if (pir1.ADIF) interrupt_low();
+			}
+			Pending_Events &= ~EVENT_TEMPERATURE_SAMPLE_AVAILABLE;
+			printf("%u ", Periods_Count);
+		}
+	}
+	printf("\n");
+
+	return Return_Value;
+}
+
+/** Save a new state at each saving period during the thermometer lifetime, and read it back after each save like a reset followed by a boot would. Each save changes all record bytes, so each slot byte is written.
+ * @return 0 if each saved state was recovered and no cell exceeded its endurance,
+ * @return -1 if a state was lost or a cell was worn out.
+ */
+static int TestWearEEPROM(void)
+{
+	TSavedState Written_State, Read_State;
+	TSimulatorStatistics Statistics;
+	unsigned long Saves_Count = (unsigned long) (TEST_EEPROM_YEARS * 365.25 * 24 * 60 / STATE_SAVING_PERIOD), Save, Maximum_Cell_Writes_Count = 0;
+	unsigned int i, Written_Cells_Count = 0;
+
+	// The simulated data EEPROM is blank at power-on reset
+	if (EEPROMReadRecord((unsigned char *) &Read_State, sizeof(Read_State)) == 0)
+	{
+		printf("Error : a record was found in the blank data EEPROM.\n");
+		return -1;
+	}
+
+	srand(0);
+	for (Save = 0; Save < Saves_Count; Save++)
+	{
+		for (i = 0; i < sizeof(Written_State); i++) ((unsigned char *) &Written_State)[i] = (unsigned char) rand();
+		EEPROMWriteRecord((unsigned char *) &Written_State, sizeof(Written_State));
+
+		// The ring position and the sequence number are the only EEPROM module data lost on reset, reading the record at boot sets them again
+		memset(&Read_State, 0, sizeof(Read_State));
+		if ((EEPROMReadRecord((unsigned char *) &Read_State, sizeof(Read_State)) != 0) || (memcmp(&Written_State, &Read_State, sizeof(Read_State)) != 0))
+		{
+			printf("Error : the state written by save %lu (sequence number %lu) was not read back.\n", Save, Save % TEST_EEPROM_SEQUENCES_COUNT);
+			return -1;
+		}
+	}
+
+	SimulatorReadStatistics(&Statistics);
+	for (i = 0; i < EEPROM_RECORDS_AREA_SIZE; i++)
+	{
+		if (Statistics.EEPROM_Cell_Writes_Count[i] == 0) continue;
+		Written_Cells_Count++;
+		if (Statistics.EEPROM_Cell_Writes_Count[i] > Maximum_Cell_Writes_Count) Maximum_Cell_Writes_Count = Statistics.EEPROM_Cell_Writes_Count[i];
+	}
+
+	printf("Saves           : %lu in %d years (one every %d minutes), %u bytes records, sequence numbers wrapped around %lu times\n", Saves_Count, TEST_EEPROM_YEARS, STATE_SAVING_PERIOD, (unsigned int) sizeof(TSavedState), Saves_Count / TEST_EEPROM_SEQUENCES_COUNT);
+	printf("EEPROM writes   : %lu bytes over %u cells, most written cell %lu times (%d cycles endurance)\n", Statistics.EEPROM_Writes_Count, Written_Cells_Count, Maximum_Cell_Writes_Count, TEST_EEPROM_CELL_ENDURANCE);
+
+	if (Maximum_Cell_Writes_Count > TEST_EEPROM_CELL_ENDURANCE)
+	{
+		printf("Error : the most written cell is worn out.\n");
+		return -1;
+	}
+	return 0;
+}
+
+/** The samples the history test stored, rounded like the history does. */
+static signed short Test_History_Samples[TEST_HISTORY_SAMPLES_COUNT];
+
+/** Compare the stored history with the newest samples the history test recorded.
+ * @param Recorded_Samples_Count How many samples the test recorded.
+ * @return 0 if the history holds the newest recorded samples,
+ * @return -1 if a sample is missing or wrong.
+ */
+static int TestCheckHistory(unsigned long Recorded_Samples_Count)
+{
+	unsigned short Samples_Count = HistoryGetSamplesCount(), Age;
+	signed short Temperature;
+
+	// The ring holds at least the keyframe block being written and the previous one once it is full
+	if ((Samples_Count > Recorded_Samples_Count) || ((Recorded_Samples_Count > HISTORY_KEYFRAME_PERIOD) && (Samples_Count < HISTORY_KEYFRAME_PERIOD)))
+	{
+		printf("Error : the history holds %u samples after %lu samples were recorded.\n", Samples_Count, Recorded_Samples_Count);
+		return -1;
+	}
+
+	for (Age = 0; Age < Samples_Count; Age++)
+	{
+		Temperature = HistoryReadSample(Age);
+		if (Temperature != Test_History_Samples[Recorded_Samples_Count - 1 - Age])
+		{
+			printf("Error : the sample of age %u is %d instead of %d after %lu samples were recorded.\n", Age, Temperature, Test_History_Samples[Recorded_Samples_Count - 1 - Age], Recorded_Samples_Count);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/** Store a random temperature trace in the history, save the ring pointers like the main loop does, and restore them at random times like a reset followed by a boot would. The samples stored since the last save are lost on reset, the older ones must be recovered.
+ * @return 0 if the history always held the newest samples,
+ * @return -1 if a sample was lost or wrong.
+ */
+static int TestKeepHistory(void)
+{
+	THistoryState Saved_State;
+	unsigned long Recorded_Samples_Count = 0, Saved_Samples_Count = 0, Resets_Count = 0, Saves_Count = 0, Sample;
+	signed short Temperature = 200, Value;
+	unsigned char Status;
+	int i;
+
+	HistoryGetState(&Saved_State);
+	srand(2);
+	for (Sample = 0; Sample < TEST_HISTORY_SAMPLES_COUNT; Sample++)
+	{
+		// Mostly drift slowly, sometimes jump far enough to need a keyframe or to saturate the stored byte
+		if (rand() % 16 == 0) Temperature = (signed short) (rand() % 4001 - 2000);
+		else Temperature += (signed short) (rand() % 81 - 40);
+
+		for (i = 0; i < HISTORY_SAMPLING_PERIOD; i++)
+		{
+			Status = HistoryCountMinute(Temperature);
+			if (Status != 0) break;
+		}
+		if (Status == 0)
+		{
+			printf("Error : no sample was stored after %d minutes.\n", HISTORY_SAMPLING_PERIOD);
+			return -1;
+		}
+
+		// Round the reference half away from zero
+		if (Temperature < 0) Value = -((-Temperature + HISTORY_RESOLUTION / 2) / HISTORY_RESOLUTION);
+		else Value = (Temperature + HISTORY_RESOLUTION / 2) / HISTORY_RESOLUTION;
+		if (Value < -128) Value = -128;
+		else if (Value > 127) Value = 127;
+		Test_History_Samples[Recorded_Samples_Count] = Value * HISTORY_RESOLUTION;
+		Recorded_Samples_Count++;
+
+		// The main loop saves right away when samples were dropped, and otherwise at its own pace
+		if ((Status == 2) || (rand() % 4 == 0))
+		{
+			HistoryGetState(&Saved_State);
+			Saved_Samples_Count = Recorded_Samples_Count;
+			Saves_Count++;
+		}
+
+		if (rand() % TEST_HISTORY_RESETS_PERIOD == 0)
+		{
+			HistorySetState(&Saved_State);
+			Recorded_Samples_Count = Saved_Samples_Count;
+			Resets_Count++;
+			if (TestCheckHistory(Recorded_Samples_Count) != 0) return -1;
+		}
+		else if ((Sample % TEST_HISTORY_CHECKS_PERIOD == 0) && (TestCheckHistory(Recorded_Samples_Count) != 0)) return -1;
+	}
+
+	printf("Samples         : %d stored, %lu ring pointers saves, %lu resets, %u samples in %u bytes at the end\n", TEST_HISTORY_SAMPLES_COUNT, Saves_Count, Resets_Count, HistoryGetSamplesCount(), HistoryGetStoredSize());
+	return 0;
+}
+
+/** The samples of the window test trace that are still in the window, stored in a ring. */
+static TTestWindowSample Test_Window_Samples[TEST_WINDOW_MAXIMUM_SAMPLES_COUNT];
+
+/** Compare the window peaks with the peaks found by scanning all samples of the buckets still in the window.
+ * @param Current_Bucket_Index The bucket the next samples will be added to.
+ * @param Pointer_First_Sample_Index The oldest recorded sample index in the ring, on output the samples that left the window are removed.
+ * @param Pointer_Samples_Count How many samples are recorded, on output the samples that left the window are removed.
+ * @return 0 if the peaks are the same,
+ * @return -1 if a peak is different.
+ */
+static int TestCheckWindowPeaks(unsigned long Current_Bucket_Index, unsigned long *Pointer_First_Sample_Index, unsigned long *Pointer_Samples_Count)
+{
+	signed short Maximum = -32768, Minimum = 32767;
+	unsigned long i, Index;
+
+	// Forget the samples of the buckets that left the window
+	while ((*Pointer_Samples_Count > 0) && (Test_Window_Samples[*Pointer_First_Sample_Index].Bucket_Index + WINDOW_BUCKETS_COUNT <= Current_Bucket_Index))
+	{
+		*Pointer_First_Sample_Index = (*Pointer_First_Sample_Index + 1) % TEST_WINDOW_MAXIMUM_SAMPLES_COUNT;
+		(*Pointer_Samples_Count)--;
+	}
+
+	for (i = 0; i < *Pointer_Samples_Count; i++)
+	{
+		Index = (*Pointer_First_Sample_Index + i) % TEST_WINDOW_MAXIMUM_SAMPLES_COUNT;
+		if (Test_Window_Samples[Index].Temperature > Maximum) Maximum = Test_Window_Samples[Index].Temperature;
+		if (Test_Window_Samples[Index].Temperature < Minimum) Minimum = Test_Window_Samples[Index].Temperature;
+	}
+
+	if ((WindowGetMaximum() != Maximum) || (WindowGetMinimum() != Minimum))
+	{
+		printf("Error : in bucket %lu, the window peaks are %d and %d instead of %d and %d.\n", Current_Bucket_Index, WindowGetMinimum(), WindowGetMaximum(), Minimum, Maximum);
+		return -1;
+	}
+	return 0;
+}
+
+/** Feed random temperature traces to the window and check its peaks after each sample and each minute against a scan of all samples in the window. The traces drift slowly, jump from time to time and stop for hours like in standby.
+ * @return 0 if the window peaks were always right,
+ * @return -1 if a window peak was wrong.
+ */
+static int TestScanWindow(void)
+{
+	unsigned long Minute, Samples_Count = 0, First_Sample_Index = 0, Index, Bucket_Index = 0, Checks_Count = 0, Gap_Minutes_Left_Count = 0;
+	signed short Temperature = 200;
+	int Trace, Samples_Per_Minute, i;
+
+	srand(1);
+	for (Trace = 0; Trace < TEST_WINDOW_TRACES_COUNT; Trace++)
+	{
+		for (Minute = 0; Minute < TEST_WINDOW_TRACE_MINUTES; Minute++)
+		{
+			// Stop sampling for up to two days from time to time
+			if (Gap_Minutes_Left_Count > 0) Gap_Minutes_Left_Count--;
+			else if ((rand() % 2000) == 0) Gap_Minutes_Left_Count = rand() % (2 * 24 * 60);
+			else
+			{
+				Samples_Per_Minute = rand() % (TEST_WINDOW_MAXIMUM_SAMPLES_PER_MINUTE + 1);
+				for (i = 0; i < Samples_Per_Minute; i++)
+				{
+					if ((rand() % 1000) == 0) Temperature = (signed short) (rand() % 1500 - 500);
+					else Temperature = (signed short) (Temperature + rand() % 7 - 3);
+
+					WindowAddSample(Temperature);
+					Index = (First_Sample_Index + Samples_Count) % TEST_WINDOW_MAXIMUM_SAMPLES_COUNT;
+					Test_Window_Samples[Index].Bucket_Index = Bucket_Index;
+					Test_Window_Samples[Index].Temperature = Temperature;
+					Samples_Count++;
+
+					if (TestCheckWindowPeaks(Bucket_Index, &First_Sample_Index, &Samples_Count) != 0) return -1;
+					Checks_Count++;
+				}
+			}
+
+			// The firmware counts the minutes whether it is sampling or not
+			WindowCountMinute();
+			if (((Trace * TEST_WINDOW_TRACE_MINUTES + Minute + 1) % WINDOW_BUCKET_PERIOD) == 0) Bucket_Index++;
+			if (TestCheckWindowPeaks(Bucket_Index, &First_Sample_Index, &Samples_Count) != 0) return -1;
+			Checks_Count++;
+		}
+	}
+
+	printf("Window          : %d traces of %lu days, %lu buckets, %lu peaks checks\n", TEST_WINDOW_TRACES_COUNT, TEST_WINDOW_TRACE_MINUTES / (24 * 60), Bucket_Index, Checks_Count);
+	return 0;
+}
+
+/** The value to character codes conversion the firmware used before the divisions were removed, it is the reference the current conversion must match.
+ * @param Value The value.
+ * @param Pointer_Left_Character On output, will contain the left character code.
+ * @param Pointer_Right_Character On output, will contain the right character code.
+ */
+static void TestConvertValueWithDivisions(unsigned long Value, unsigned char *Pointer_Left_Character, unsigned char *Pointer_Right_Character)
+{
+	unsigned char Exponent = 0;
+
+	while (Value >= 100)
+	{
+		if (Exponent == 3)
+		{
+			*Pointer_Left_Character = SCREEN_CHARACTER_CODE_MINUS;
+			*Pointer_Right_Character = SCREEN_CHARACTER_CODE_MINUS;
+			return;
+		}
+		Value /= 10;
+		Exponent++;
+	}
+
+	*Pointer_Left_Character = (unsigned char) (Value / 10);
+	*Pointer_Right_Character = (unsigned char) (Value % 10);
+	if (Exponent & 1) *Pointer_Right_Character |= SCREEN_CHARACTER_FLAG_DOT;
+	if (Exponent & 2) *Pointer_Left_Character |= SCREEN_CHARACTER_FLAG_DOT;
+}
+
+/** Convert a value and compare the character codes with the conversion based on software divisions.
+ * @param Value The value.
+ * @return 0 if the value is converted like the reference does,
+ * @return -1 if the value is converted differently.
+ */
+static int TestCheckValue(unsigned long Value)
+{
+	unsigned char Left_Character, Right_Character, Expected_Left_Character, Expected_Right_Character;
+
+	ConvertValueToCharacterCodes(Value, &Left_Character, &Right_Character);
+	TestConvertValueWithDivisions(Value, &Expected_Left_Character, &Expected_Right_Character);
+	if ((Left_Character != Expected_Left_Character) || (Right_Character != Expected_Right_Character))
+	{
+		printf("Error : value %lu is converted to 0x%02X 0x%02X instead of 0x%02X 0x%02X.\n", Value, Left_Character, Right_Character, Expected_Left_Character, Expected_Right_Character);
+		return -1;
+	}
+	return 0;
+}
+
+/** Convert the values shown by the diagnostics and battery pages, from zero to well beyond the largest displayed value, then the largest 32-bit values.
+ * @return 0 if all values are converted like the reference does,
+ * @return -1 if a value is converted differently.
+ */
+static int TestConvertValues(void)
+{
+	static const unsigned long Large_Values[] = {99999999UL, 100000000UL, 0x7FFFFFFFUL, 0xFFFFFFFFUL};
+	unsigned long Value, Mismatches_Count = 0;
+	unsigned int i;
+
+	for (Value = 0; Value <= TEST_VALUES_MAXIMUM; Value++)
+	{
+		if (TestCheckValue(Value) != 0) Mismatches_Count++;
+	}
+	for (i = 0; i < sizeof(Large_Values) / sizeof(Large_Values[0]); i++)
+	{
+		if (TestCheckValue(Large_Values[i]) != 0) Mismatches_Count++;
+	}
+
+	printf("Values          : %lu converted, %lu mismatches\n", TEST_VALUES_MAXIMUM + 1 + i, Mismatches_Count);
+
+	if (Mismatches_Count > 0) return -1;
+	return 0;
+}
+
+/** Estimate the remaining runtime of random battery uses and compare it with the runtime computed with floating point numbers from the same accounting and battery voltage.
+ * @return 0 if all estimates are within the firmware arithmetic resolution of the reference,
+ * @return -1 if an estimate is wrong.
+ */
+static int TestEstimateRuntime(void)
+{
+	TEnergyState State;
+	double Current, Consumed_Charge, Remaining_Charge, Voltage_Remaining_Charge = TEST_RUNTIME_BATTERY_CHARGE, Unit_Charge, Expected_Days, Tolerance, Error, Maximum_Error = 0;
+	unsigned long Seconds, Estimates_Count = 0, Unknown_Count = 0, Bounded_Count = 0;
+	unsigned short Days, Voltage_Value;
+	unsigned char Is_Unknown_Expected;
+	int i, j;
+
+	// Convert the battery voltage like the measurements do
+	ADCInitialize();
+	TemperatureInitialize();
+	StartMeasurements();
+	while (!ADCIsReady());
+	HandleMeasurementsTick();
+	while (ADCReadBatteryVoltageValue() == 0)
+	{
+		if (pir1.ADIF) interrupt_low();
+	}
+	Voltage_Value = ADCReadBatteryVoltageValue();
+	if (Voltage_Value > TEST_RUNTIME_FULL_VOLTAGE_VALUE) Voltage_Remaining_Charge = TEST_RUNTIME_BATTERY_CHARGE * (ADC_BATTERY_LOW_VOLTAGE_VALUE - Voltage_Value) / (ADC_BATTERY_LOW_VOLTAGE_VALUE - TEST_RUNTIME_FULL_VOLTAGE_VALUE);
+
+	srand(1);
+	for (i = 0; i < TEST_RUNTIME_ESTIMATES_COUNT; i++)
+	{
+		// Draw an average current spread evenly over the decades, and a battery use duration up to a bit more than the time the capacity lasts at this current (in the 4096s steps of the data EEPROM)
+		Current = TEST_RUNTIME_MINIMUM_CURRENT * pow(TEST_RUNTIME_MAXIMUM_CURRENT / TEST_RUNTIME_MINIMUM_CURRENT, (double) rand() / RAND_MAX);
+		State.Elapsed_Time = (unsigned short) fmin(1 + TEST_RUNTIME_BATTERY_CHARGE * 16 / Current * 1.1 * rand() / RAND_MAX / 4096, 0xFFFF);
+		Consumed_Charge = Current * ((double) State.Elapsed_Time * 4096) / 16;
+		for (j = 0; j < ENERGY_CONSUMERS_COUNT; j++) State.Consumed_Charges[j] = (unsigned short) fmin(Consumed_Charge / ENERGY_CONSUMERS_COUNT / 65536, 0xFFFF);
+		EnergySetState(&State);
+
+		Days = EnergyComputeRemainingRuntime();
+
+		// Compute the reference from the accounting the firmware restored
+		Consumed_Charge = 0;
+		for (j = 0; j < ENERGY_CONSUMERS_COUNT; j++) Consumed_Charge += EnergyReadConsumedCharge((TEnergyConsumer) j);
+		Seconds = EnergyReadElapsedTime();
+		Unit_Charge = Consumed_Charge * 64 / Seconds; // The firmware averages the charge over 64s units
+		Remaining_Charge = fmin(TEST_RUNTIME_BATTERY_CHARGE - Consumed_Charge, Voltage_Remaining_Charge);
+		if (Remaining_Charge < TEST_RUNTIME_BATTERY_CHARGE - Consumed_Charge) Bounded_Count++;
+		Is_Unknown_Expected = (Consumed_Charge >= TEST_RUNTIME_BATTERY_CHARGE) || (Unit_Charge < 1);
+		Expected_Days = 0;
+		Tolerance = 0;
+		if (!Is_Unknown_Expected)
+		{
+			Expected_Days = Remaining_Charge / (Unit_Charge * 86400 / 64);
+			Tolerance = 1 + Expected_Days / floor(Unit_Charge); // The average charge per unit is truncated
+			if (Expected_Days - Tolerance >= ENERGY_RUNTIME_UNKNOWN) Is_Unknown_Expected = 1;
+			else if ((Days == ENERGY_RUNTIME_UNKNOWN) && (Expected_Days + Tolerance >= ENERGY_RUNTIME_UNKNOWN)) Is_Unknown_Expected = 1; // Close to the largest runtime, both results are right
+		}
+		Estimates_Count++;
+
+		if (Is_Unknown_Expected)
+		{
+			Unknown_Count++;
+			if (Days == ENERGY_RUNTIME_UNKNOWN) continue;
+			printf("Error : the runtime of %.0f charge units drawn in %lu s is estimated to %u days instead of being unknown.\n", Consumed_Charge, Seconds, Days);
+			return -1;
+		}
+		Error = fabs(Days - Expected_Days);
+		if (Error > Maximum_Error) Maximum_Error = Error;
+		if ((Days == ENERGY_RUNTIME_UNKNOWN) || (Error > Tolerance))
+		{
+			printf("Error : the runtime of %.0f charge units drawn in %lu s is estimated to %u days instead of %.1f days.\n", Consumed_Charge, Seconds, Days, Expected_Days);
+			return -1;
+		}
+	}
+
+	printf("Battery voltage : %.3f V (conversion result %u), the remaining charge is bounded to %.1f%% of the capacity\n", 1024.0 * 1023 / Voltage_Value / 1000, Voltage_Value, Voltage_Remaining_Charge * 100 / TEST_RUNTIME_BATTERY_CHARGE);
+	printf("Estimates       : %lu checked, %lu unknown, %lu bounded by the battery voltage, %.1f days of largest error\n", Estimates_Count, Unknown_Count, Bounded_Count, Maximum_Error);
+	return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The scenario run to bring the simulated processor out of reset, it ends before the firmware executes its first instruction. */
+static const TSimulatorScenario Test_Scenario = {"Power-on reset", 0, {0, 0, 0, 0}, TestTemperatureStable, 0, 3.0};
+
+/** All test cases. */
+static const TTest Tests[] =
+{
+	{"ADC codes conversion", TestConvertADCCodes},
+	{"Aborted temperature scans", TestAbortTemperatureScans},
+	{"Data EEPROM wear", TestWearEEPROM},
+	{"Last 24 hours peaks", TestScanWindow},
+	{"Temperature history", TestKeepHistory},
+	{"Values conversion", TestConvertValues},
+	{"Battery runtime", TestEstimateRuntime}
+};
+
+/** Run a test in a child process, because the firmware static variables can't be reset between tests.
+ * @param Pointer_Test The test to run.
+ * @return 0 if the test passed,
+ * @return -1 if the test failed.
+ */
+static int TestRun(const TTest *Pointer_Test)
+{
+	TSimulatorStatistics Statistics;
+	pid_t Process_ID;
+	int Status;
+
+	printf("=== %s\n", Pointer_Test->Pointer_String_Name);
+	fflush(stdout);
+	Process_ID = fork();
+	if (Process_ID < 0)
+	{
+		perror("fork");
+		return -1;
+	}
+
+	// Child process
+	if (Process_ID == 0)
+	{
+		SimulatorRun(&Test_Scenario, &Statistics);
+		Status = Pointer_Test->Run();
+		fflush(stdout);
+		_exit(Status == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// Parent process
+	if ((waitpid(Process_ID, &Status, 0) < 0) || !WIFEXITED(Status) || (WEXITSTATUS(Status) != EXIT_SUCCESS))
+	{
+		printf("Error : test \"%s\" failed.\n\n", Pointer_Test->Pointer_String_Name);
+		return -1;
+	}
+	printf("\n");
+	return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Entry point
+//--------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	unsigned int i, Tests_Count = sizeof(Tests) / sizeof(Tests[0]);
+	int Return_Value = EXIT_SUCCESS;
+
+	for (i = 0; i < Tests_Count; i++)
+	{
+		// Run only the tests whose name contains the optional filter
+		if ((argc > 1) && (strstr(Tests[i].Pointer_String_Name, argv[1]) == NULL)) continue;
+
+		if (TestRun(&Tests[i]) != 0) Return_Value = EXIT_FAILURE;
+	}
+
+	return Return_Value;
+}
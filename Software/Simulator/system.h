@@ -0,0 +1,62 @@
+/** @file system.h
+ * Host replacement for the BoostC system header. It maps the PIC18F13K22 registers, the inline assembly and the delay functions used by the firmware to the simulator.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#ifndef H_SYSTEM_H
+#define H_SYSTEM_H
+
+#include <type_traits>
+#include "Simulator.h"
+
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+/** Inline assembly is not available on the host, the used instructions are mapped to simulator calls instead. */
+#define asm
+/** Enter idle or sleep mode. */
+#define sleep SimulatorExecuteSleep()
+/** Clear the watchdog timer. */
+#define clrwdt SimulatorExecuteClearWatchdog()
+/** Do nothing during one instruction cycle. */
+#define nop SimulatorConsumeCycles(1)
+
+/** BoostC stores the rom data in program memory and reads it with table reads, the host keeps it in a constant array. */
+#define rom const
+
+/** The firmware entry point is called by the simulator. */
+#define main FirmwareMain
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Wait for the requested amount of microseconds (computed for the BoostC CLOCK_FREQ, as the real library does).
+ * @param Microseconds How many microseconds to wait.
+ */
+void delay_us(unsigned char Microseconds);
+
+/** Wait for the requested amount of tens of microseconds.
+ * @param Tens_Of_Microseconds How many tens of microseconds to wait.
+ */
+void delay_10us(unsigned char Tens_Of_Microseconds);
+
+/** Wait for the requested amount of milliseconds.
+ * @param Milliseconds How many milliseconds to wait.
+ */
+void delay_ms(unsigned char Milliseconds);
+
+/** Wait for the requested amount of seconds.
+ * @param Seconds How many seconds to wait.
+ */
+void delay_s(unsigned char Seconds);
+
+/** BoostC allows to increment enumerations like integers, C++ needs an explicit operator. */
+template <typename TEnumeration> __attribute__((no_instrument_function)) inline typename std::enable_if<std::is_enum<TEnumeration>::value, TEnumeration>::type operator++(TEnumeration &Value, int)
+{
+	TEnumeration Previous_Value = Value;
+
+	Value = (TEnumeration) (Value + 1);
+	return Previous_Value;
+}
+
+#endif
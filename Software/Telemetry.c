@@ -0,0 +1,346 @@
+/** @file Telemetry.c
+ * @see Telemetry.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "ADC.h"
+#include "CRC.h"
+#include "Processor.h"
+#include "Telemetry.h"
+#include "Timer.h"
+
+#if TELEMETRY_IS_ENABLED
+
+//--------------------------------------------------------------------------------------------------
+// Private constants and macros
+//--------------------------------------------------------------------------------------------------
+/** Compute the 16-bit baud rate generator value making TELEMETRY_BAUD_RATE from a clock frequency (in high speed mode, a bit lasts 4 * (value + 1) clock periods).
+ * @param Frequency The clock frequency in Hz.
+ */
+#define TELEMETRY_BAUD_RATE_GENERATOR_VALUE(Frequency) (((Frequency) + 2UL * TELEMETRY_BAUD_RATE) / (4UL * TELEMETRY_BAUD_RATE) - 1)
+
+/** Keep a buffer index in the ring. */
+#define TELEMETRY_BUFFER_INDEX_MASK (TELEMETRY_BUFFER_SIZE - 1)
+
+/** How many bytes a frame takes in addition to its payload (the start byte, the header and the CRC). */
+#define TELEMETRY_FRAME_OVERHEAD 3
+
+/** How many bytes the frames queued at each burst period end take at most (the absolute temperatures, the peaks and the battery voltage). */
+#define TELEMETRY_PERIODIC_FRAMES_SIZE (6 * ADC_TEMPERATURE_SENSORS_COUNT + 2 + 3 * TELEMETRY_FRAME_OVERHEAD)
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The baud rate generator value for each clock frequency (the 31KHz frequency is too slow for the serial line, it is never used during a burst). */
+static const unsigned short Telemetry_Baud_Rate_Generator_Values[PROCESSOR_CLOCK_FREQUENCIES_COUNT] = {TELEMETRY_BAUD_RATE_GENERATOR_VALUE(31000), TELEMETRY_BAUD_RATE_GENERATOR_VALUE(250000), TELEMETRY_BAUD_RATE_GENERATOR_VALUE(1000000), TELEMETRY_BAUD_RATE_GENERATOR_VALUE(16000000)};
+
+/** The frames waiting to be transmitted. */
+static unsigned char Telemetry_Buffer[TELEMETRY_BUFFER_SIZE];
+
+/** Where the next complete frame will be written, only the main loop changes it. */
+static volatile unsigned char Telemetry_Buffer_Write_Index = 0;
+
+/** Where the next byte to transmit is read, only the transmission code changes it. */
+static volatile unsigned char Telemetry_Buffer_Read_Index = 0;
+
+/** Where the next byte of the frame being queued is written, the frame is handed to the transmission code when it is complete. */
+static unsigned char Telemetry_Frame_Write_Index;
+
+/** The CRC of the frame being queued. */
+static unsigned char Telemetry_Frame_CRC;
+
+/** The next frame sequence number. */
+static unsigned char Telemetry_Sequence = 0;
+
+/** The temperatures of the last queued temperature frame, the next differences are computed from them (in tenths of Celsius degrees). */
+static signed short Telemetry_Sent_Temperatures[ADC_TEMPERATURE_SENSORS_COUNT];
+
+/** How many differences frames can still be sent before the next absolute one (0 forces an absolute frame). */
+static unsigned char Telemetry_Deltas_Frames_Left_Count = 0;
+
+/** How many minutes are left before the next burst. */
+static unsigned char Telemetry_Burst_Minutes_Left_Count = TELEMETRY_BURST_PERIOD;
+
+/** The clock frequency the baud rate generator is configured for. */
+static TProcessorClockFrequency Telemetry_Clock_Frequency;
+
+/** Tell whether the system is in low power mode. */
+static unsigned char Telemetry_Is_Low_Power_Enabled = 0;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Configure the baud rate generator for the current clock frequency.
+ * @note Writing the baud rate generator corrupts the byte being shifted out.
+ */
+static void TelemetrySetBaudRate(void)
+{
+	unsigned short Value;
+	
+	Telemetry_Clock_Frequency = ProcessorGetClockFrequency();
+	Value = Telemetry_Baud_Rate_Generator_Values[Telemetry_Clock_Frequency];
+	spbrgh = Value >> 8;
+	spbrg = (unsigned char) Value;
+}
+
+/** Power the serial port up if it is not transmitting yet. */
+static void TelemetryEnableTransmitter(void)
+{
+	if (rcsta.SPEN) return;
+	
+	TelemetrySetBaudRate();
+	rcsta.SPEN = 1;
+	txsta.TXEN = 1;
+}
+
+/** Move the next queued byte to the transmit register.
+ * @note The transmit register must be empty and the buffer must not be empty.
+ */
+static void TelemetryLoadNextByte(void)
+{
+	// The byte being shifted out is already corrupted when the clock frequency changes, so the baud rate generator can be updated before the next byte
+	if (ProcessorGetClockFrequency() != Telemetry_Clock_Frequency) TelemetrySetBaudRate();
+	
+	txreg = Telemetry_Buffer[Telemetry_Buffer_Read_Index];
+	Telemetry_Buffer_Read_Index = (Telemetry_Buffer_Read_Index + 1) & TELEMETRY_BUFFER_INDEX_MASK;
+}
+
+/** Power the serial port down when the last byte is shifted out (called by the telemetry software timer on each tick after the buffer was emptied). */
+static void TelemetryStopBurst(void)
+{
+	// A new burst was started, it will start the timer again when the buffer is empty
+	if (pie1.TXIE)
+	{
+		TimerStop(TIMER_ID_TELEMETRY);
+		return;
+	}
+	
+	// There is no interrupt telling that the shift register is empty
+	if (!txsta.TRMT) return;
+	
+	TimerStop(TIMER_ID_TELEMETRY);
+	txsta.TXEN = 0;
+	rcsta.SPEN = 0;
+	ProcessorRequestClockFrequency(PROCESSOR_CLOCK_CLIENT_TELEMETRY, PROCESSOR_CLOCK_FREQUENCY_31KHZ);
+}
+
+/** Transmit all queued frames, keeping the core idle while each byte is being shifted out, then power the serial port down. */
+static void TelemetryTransmitBuffer(void)
+{
+	unsigned char Is_Low_Priority_Interrupt_Enabled;
+	
+	// The serial line needs the HFINTOSC, the tick which keeps it running may be stopped (a running burst already holds a higher frequency)
+	if (!rcsta.SPEN) ProcessorRequestClockFrequency(PROCESSOR_CLOCK_CLIENT_TELEMETRY, PROCESSOR_CLOCK_FREQUENCY_250KHZ);
+	
+	// The transmit interrupt wakes the idle core up, it must not call the low priority interrupt handler
+	Is_Low_Priority_Interrupt_Enabled = intcon.GIEL;
+	intcon.GIEL = 0;
+	TelemetryEnableTransmitter();
+	pie1.TXIE = 1;
+	
+	while (Telemetry_Buffer_Read_Index != Telemetry_Buffer_Write_Index)
+	{
+		while (!pir1.TXIF) ProcessorWaitForInterrupt();
+		TelemetryLoadNextByte();
+	}
+	
+	pie1.TXIE = 0;
+	intcon.GIEL = Is_Low_Priority_Interrupt_Enabled;
+	
+	// Wait for the last bytes to be shifted out, the last one may still be waiting in the transmit register
+	while (!txsta.TRMT);
+	TimerStop(TIMER_ID_TELEMETRY); // An interrupted burst end is not waited for anymore
+	txsta.TXEN = 0;
+	rcsta.SPEN = 0;
+	
+	ProcessorRequestClockFrequency(PROCESSOR_CLOCK_CLIENT_TELEMETRY, PROCESSOR_CLOCK_FREQUENCY_31KHZ);
+}
+
+/** Append a byte to the frame being queued.
+ * @param Byte The byte to append.
+ */
+static void TelemetryWriteByte(unsigned char Byte)
+{
+	Telemetry_Buffer[Telemetry_Frame_Write_Index] = Byte;
+	Telemetry_Frame_Write_Index = (Telemetry_Frame_Write_Index + 1) & TELEMETRY_BUFFER_INDEX_MASK;
+	Telemetry_Frame_CRC = CRCUpdate(Telemetry_Frame_CRC, Byte);
+}
+
+/** Get the room left in the buffer.
+ * @return How many bytes can be queued.
+ */
+static unsigned char TelemetryGetFreeBytesCount(void)
+{
+	// A byte is kept free to tell a full buffer from an empty one
+	return (Telemetry_Buffer_Read_Index - Telemetry_Buffer_Write_Index - 1) & TELEMETRY_BUFFER_INDEX_MASK;
+}
+
+/** Start queuing a frame if the buffer has enough room for it.
+ * @param Type The frame type.
+ * @param Payload_Size The frame payload size in bytes.
+ * @return 0 if the frame can be written,
+ * @return 1 if the frame is dropped because the buffer is full.
+ */
+static unsigned char TelemetryStartFrame(TTelemetryFrameType Type, unsigned char Payload_Size)
+{
+	unsigned char Header;
+	
+	// A dropped frame takes a sequence number too, so the receiver can tell that it is lost
+	Header = (Type << 5) | Telemetry_Sequence;
+	Telemetry_Sequence = (Telemetry_Sequence + 1) & TELEMETRY_SEQUENCE_MASK;
+	
+	if (Payload_Size + TELEMETRY_FRAME_OVERHEAD > TelemetryGetFreeBytesCount()) return 1;
+	
+	Telemetry_Frame_Write_Index = Telemetry_Buffer_Write_Index;
+	Telemetry_Frame_CRC = 0;
+	TelemetryWriteByte(TELEMETRY_FRAME_START);
+	TelemetryWriteByte(Header);
+	return 0;
+}
+
+/** Append a 16-bit value to the frame being queued, low byte first.
+ * @param Value The value to append.
+ */
+static void TelemetryWriteWord(unsigned short Value)
+{
+	TelemetryWriteByte((unsigned char) Value);
+	TelemetryWriteByte(Value >> 8);
+}
+
+/** Append the CRC to the frame being queued and let the transmission code see the frame. */
+static void TelemetryEndFrame(void)
+{
+	Telemetry_Buffer[Telemetry_Frame_Write_Index] = Telemetry_Frame_CRC;
+	Telemetry_Buffer_Write_Index = (Telemetry_Frame_Write_Index + 1) & TELEMETRY_BUFFER_INDEX_MASK;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void TelemetryInitialize(void)
+{
+	txsta = 0x04; // Asynchronous mode, 8-bit transmission, high speed baud rate, the transmitter is enabled at each burst start
+	rcsta = 0; // Keep the serial port powered down
+	baudcon = 0x08; // 16-bit baud rate generator, the TX line idles high
+	ipr1.TXIP = 0; // The frames are not time critical
+}
+
+unsigned char TelemetryCountMinute(void)
+{
+	Telemetry_Burst_Minutes_Left_Count--;
+	if (Telemetry_Burst_Minutes_Left_Count > 0) return 0;
+	
+	Telemetry_Burst_Minutes_Left_Count = TELEMETRY_BURST_PERIOD;
+	return 1;
+}
+
+void TelemetrySendTemperatures(signed short *Pointer_Temperatures)
+{
+	unsigned char i, Is_Delta_Possible;
+	signed short Delta;
+	
+	// Send the differences only when they all fit in a byte
+	Is_Delta_Possible = Telemetry_Deltas_Frames_Left_Count > 0;
+	for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++)
+	{
+		Delta = Pointer_Temperatures[i] - Telemetry_Sent_Temperatures[i];
+		if ((Delta < -128) || (Delta > 127)) Is_Delta_Possible = 0;
+	}
+	
+	if (Is_Delta_Possible)
+	{
+		if (TelemetryStartFrame(TELEMETRY_FRAME_TYPE_TEMPERATURE_DELTAS, ADC_TEMPERATURE_SENSORS_COUNT) != 0)
+		{
+			Telemetry_Deltas_Frames_Left_Count = 0; // The receiver can't apply the next differences without this frame
+			return;
+		}
+		for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++) TelemetryWriteByte((unsigned char) (Pointer_Temperatures[i] - Telemetry_Sent_Temperatures[i]));
+		Telemetry_Deltas_Frames_Left_Count--;
+	}
+	else
+	{
+		if (TelemetryStartFrame(TELEMETRY_FRAME_TYPE_TEMPERATURES, 2 * ADC_TEMPERATURE_SENSORS_COUNT) != 0) return;
+		for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++) TelemetryWriteWord(Pointer_Temperatures[i]);
+		Telemetry_Deltas_Frames_Left_Count = TELEMETRY_KEYFRAME_PERIOD - 1;
+	}
+	TelemetryEndFrame();
+	
+	for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++) Telemetry_Sent_Temperatures[i] = Pointer_Temperatures[i];
+}
+
+void TelemetrySendPeaks(signed short *Pointer_Maximum_Temperatures, signed short *Pointer_Minimum_Temperatures)
+{
+	unsigned char i;
+	
+	if (TelemetryStartFrame(TELEMETRY_FRAME_TYPE_PEAKS, 4 * ADC_TEMPERATURE_SENSORS_COUNT) != 0) return;
+	for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++)
+	{
+		TelemetryWriteWord(Pointer_Maximum_Temperatures[i]);
+		TelemetryWriteWord(Pointer_Minimum_Temperatures[i]);
+	}
+	TelemetryEndFrame();
+}
+
+void TelemetrySendBatteryVoltage(unsigned short Value)
+{
+	if (TelemetryStartFrame(TELEMETRY_FRAME_TYPE_BATTERY_VOLTAGE, 2) != 0) return;
+	TelemetryWriteWord(Value);
+	TelemetryEndFrame();
+}
+
+void TelemetrySendState(unsigned char State)
+{
+	if (TelemetryStartFrame(TELEMETRY_FRAME_TYPE_STATE, 1) != 0) return;
+	TelemetryWriteByte(State);
+	TelemetryEndFrame();
+	
+	// Do not let the user actions make the periodic frames be dropped
+	if (TelemetryGetFreeBytesCount() < TELEMETRY_PERIODIC_FRAMES_SIZE) TelemetryStartBurst();
+}
+
+void TelemetryStartBurst(void)
+{
+	unsigned char Is_Low_Priority_Interrupt_Enabled;
+	
+	if (Telemetry_Buffer_Read_Index == Telemetry_Buffer_Write_Index) return;
+	
+	// The interrupt handlers are not called in low power mode
+	if (Telemetry_Is_Low_Power_Enabled)
+	{
+		TelemetryTransmitBuffer();
+		return;
+	}
+	
+	// The main loop switches between 31KHz and 1MHz while the tick keeps the 250KHz frequency, so hold the highest one until the serial port is powered down : a frequency switch corrupts the byte being shifted out
+	ProcessorRequestClockFrequency(PROCESSOR_CLOCK_CLIENT_TELEMETRY, PROCESSOR_CLOCK_FREQUENCY_1MHZ);
+	
+	// The telemetry software timer must not power the serial port down between the check that it is powered and the transmit interrupt enabling
+	Is_Low_Priority_Interrupt_Enabled = intcon.GIEL;
+	intcon.GIEL = 0;
+	TelemetryEnableTransmitter();
+	pie1.TXIE = 1;
+	intcon.GIEL = Is_Low_Priority_Interrupt_Enabled;
+}
+
+void TelemetryTransmitByte(void)
+{
+	// The interrupt flag can't be cleared, so disable the interrupt and power the serial port down when the last byte is shifted out
+	if (Telemetry_Buffer_Read_Index == Telemetry_Buffer_Write_Index)
+	{
+		pie1.TXIE = 0;
+		TimerStart(TIMER_ID_TELEMETRY, 1, TelemetryStopBurst);
+		return;
+	}
+	
+	TelemetryLoadNextByte();
+}
+
+void TelemetrySetLowPowerMode(unsigned char Is_Low_Power_Enabled)
+{
+	Telemetry_Is_Low_Power_Enabled = Is_Low_Power_Enabled;
+	
+	// Transmit the queued frames and finish the running burst before the tick is stopped
+	if (Is_Low_Power_Enabled && ((Telemetry_Buffer_Read_Index != Telemetry_Buffer_Write_Index) || rcsta.SPEN)) TelemetryTransmitBuffer();
+}
+
+#endif
\ No newline at end of file
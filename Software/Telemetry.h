@@ -0,0 +1,105 @@
+/** @file Telemetry.h
+ * Stream the samples, the peaks, the battery voltage and the user actions on the EUSART as compact binary frames. The frames are queued in a ring buffer and transmitted in bursts by the transmit interrupt, so the serial port is powered down between the bursts and the main loop never waits for the serial line.
+ * A frame is made of the TELEMETRY_FRAME_START byte, a header byte (the frame type in the 3 upper bits, a sequence number in the 5 lower bits), the payload (multi-byte values are sent low byte first) and the CRC-8 of all the previous bytes. A frame that does not fit in the buffer is dropped, its sequence number is skipped so the receiver can count the lost frames.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#ifndef H_TELEMETRY_H
+#define H_TELEMETRY_H
+
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+#ifndef TELEMETRY_IS_ENABLED
+	/** Set to 1 to stream the telemetry frames on the EUSART TX pin. The TX pin is RB7, which drives the minimum temperature led : the led follows the serial line during the bursts (the line idles high), and the receiver sees the led state between the bursts. */
+	#define TELEMETRY_IS_ENABLED 0
+#endif
+
+#ifndef TELEMETRY_BURST_PERIOD
+	/** How many minutes separate two bursts (the value must be in range [1..255]). Each burst sends the current temperatures, the peaks and the battery voltage, followed by the user actions queued since the previous burst. */
+	#define TELEMETRY_BURST_PERIOD 1
+#endif
+
+#ifndef TELEMETRY_BUFFER_SIZE
+	/** The frames ring buffer size in bytes, it must be a power of 2 in range [16..128] and hold the periodic frames (6 * ADC_TEMPERATURE_SENSORS_COUNT + 11 bytes) followed by a state frame (4 bytes), one byte being kept unused. */
+	#define TELEMETRY_BUFFER_SIZE 32
+#endif
+
+#ifndef TELEMETRY_KEYFRAME_PERIOD
+	/** The temperatures are sent as differences with the previously sent ones, an absolute frame is sent at least every this amount of temperature frames so a receiver can start decoding anytime (the value must be in range [1..255]). */
+	#define TELEMETRY_KEYFRAME_PERIOD 16
+#endif
+
+#ifndef TELEMETRY_BAUD_RATE
+	/** The serial line bit rate, with 8 data bits, no parity and 1 stop bit. The 250KHz clock must be able to generate it (1200, 2400 or 4800 bauds). */
+	#define TELEMETRY_BAUD_RATE 2400
+#endif
+
+/** The first byte of each frame. */
+#define TELEMETRY_FRAME_START 0xA5
+
+/** The sequence numbers mask, they are stored in the header lower bits. */
+#define TELEMETRY_SEQUENCE_MASK 0x1F
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** All frame types, with their payload. */
+typedef enum
+{
+	TELEMETRY_FRAME_TYPE_TEMPERATURES, //!< The temperature of each sensor (16 bits, in tenths of Celsius degrees).
+	TELEMETRY_FRAME_TYPE_TEMPERATURE_DELTAS, //!< The temperature of each sensor minus the previously sent one (8 bits, in tenths of Celsius degrees).
+	TELEMETRY_FRAME_TYPE_PEAKS, //!< The all-time maximum then minimum temperatures of each sensor (16 bits each, in tenths of Celsius degrees).
+	TELEMETRY_FRAME_TYPE_BATTERY_VOLTAGE, //!< The last battery voltage conversion result (16 bits, see ADCReadBatteryVoltageValue()).
+	TELEMETRY_FRAME_TYPE_STATE, //!< The main loop state after a user action (8 bits, the displayed sensor in the upper nibble and the state in the lower one).
+	TELEMETRY_FRAME_TYPES_COUNT
+} TTelemetryFrameType;
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Configure the EUSART in asynchronous mode, the serial port is kept powered down until the first burst. */
+void TelemetryInitialize(void);
+
+/** Tell the telemetry that a minute elapsed.
+ * @return 1 if a burst period elapsed, the caller must queue the periodic frames and start a burst,
+ * @return 0 if no burst is due.
+ */
+unsigned char TelemetryCountMinute(void);
+
+/** Queue the sensors temperatures, as differences with the previously sent temperatures when they all fit in a byte.
+ * @param Pointer_Temperatures The temperature of each sensor in tenths of Celsius degrees.
+ */
+void TelemetrySendTemperatures(signed short *Pointer_Temperatures);
+
+/** Queue the sensors all-time peaks.
+ * @param Pointer_Maximum_Temperatures The maximum temperature of each sensor in tenths of Celsius degrees.
+ * @param Pointer_Minimum_Temperatures The minimum temperature of each sensor in tenths of Celsius degrees.
+ */
+void TelemetrySendPeaks(signed short *Pointer_Maximum_Temperatures, signed short *Pointer_Minimum_Temperatures);
+
+/** Queue the battery voltage.
+ * @param Value The battery voltage conversion result.
+ */
+void TelemetrySendBatteryVoltage(unsigned short Value);
+
+/** Queue the main loop state. The queued frames are transmitted before the next burst period end if the buffer can't hold the periodic frames anymore.
+ * @param State The state value.
+ */
+void TelemetrySendState(unsigned char State);
+
+/** Power the serial port up and transmit the queued frames. When the system is running, the frames are transmitted by the transmit interrupt and the serial port is powered down one tick after the last byte. In low power mode, the core is kept idle until all frames are transmitted.
+ * @note This function must not be called from an interrupt handler.
+ */
+void TelemetryStartBurst(void);
+
+/** Transmit the next queued byte, or wait for the last byte to be shifted out when the buffer is empty. This function must be called by the low priority transmit interrupt handler. */
+void TelemetryTransmitByte(void);
+
+/** Tell the module whether the system is in low power mode. The queued frames are transmitted right away when low power mode is entered, as the tick powering the serial port down is going to be stopped.
+ * @param Is_Low_Power_Enabled Set to 1 when the system enters low power mode, set to 0 when the system is woken up.
+ * @note The low priority interrupts are masked while the frames are transmitted.
+ */
+void TelemetrySetLowPowerMode(unsigned char Is_Low_Power_Enabled);
+
+#endif
\ No newline at end of file
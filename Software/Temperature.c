@@ -3,35 +3,198 @@
  * @author Adrien RICCIARDI
  */
 #include <system.h>
+#include "ADC.h"
 #include "Temperature.h"
 
+//--------------------------------------------------------------------------------------------------
+// Private constants and macros
+//--------------------------------------------------------------------------------------------------
+#ifndef TEMPERATURE_OVERSAMPLING_BITS
+	/** Each temperature sample is the average of 4^TEMPERATURE_OVERSAMPLING_BITS conversions, reducing the noise by 2^TEMPERATURE_OVERSAMPLING_BITS (the value must be in range [0..3] to keep the sum in 16 bits). */
+	#define TEMPERATURE_OVERSAMPLING_BITS 2
+#endif
+
+/** How many conversions make a temperature sample. */
+#define TEMPERATURE_OVERSAMPLING_CONVERSIONS (1 << (2 * TEMPERATURE_OVERSAMPLING_BITS))
+
+#ifndef TEMPERATURE_SAMPLING_MINIMUM_PERIODS
+	/** The shortest interval between two samples, in sampling periods (sampling software timer period when the system is running, wake-up timer period in low power mode). */
+	#define TEMPERATURE_SAMPLING_MINIMUM_PERIODS 1
+#endif
+
+#ifndef TEMPERATURE_SAMPLING_MAXIMUM_PERIODS
+	/** The longest interval between two samples, in sampling periods (the value must be in range [TEMPERATURE_SAMPLING_MINIMUM_PERIODS..128]). Set it to TEMPERATURE_SAMPLING_MINIMUM_PERIODS to sample at a fixed rate. */
+	#define TEMPERATURE_SAMPLING_MAXIMUM_PERIODS 8
+#endif
+
+#ifndef TEMPERATURE_SAMPLING_HYSTERESIS
+	/** The temperature is considered as stable while it does not move more than this value (in tenths of Celsius degrees) from the temperature measured when fast sampling was last needed. */
+	#define TEMPERATURE_SAMPLING_HYSTERESIS 2
+#endif
+
+/** Use the samples as is. */
+#define TEMPERATURE_FILTER_NONE 0
+/** Use the median of the 3 last samples of each sensor, a single sample spike is dropped and a temperature step is followed one sample late. */
+#define TEMPERATURE_FILTER_MEDIAN 1
+/** Use an exponential moving average of the samples of each sensor, the noise of all samples is lowered but the temperature changes are followed with some lag. */
+#define TEMPERATURE_FILTER_EXPONENTIAL 2
+
+#ifndef TEMPERATURE_FILTER
+	/** Select the filter applied to the successive samples of each sensor, so the noise reaches neither the displayed temperature nor the peaks. */
+	#define TEMPERATURE_FILTER TEMPERATURE_FILTER_MEDIAN
+#endif
+
+#ifndef TEMPERATURE_FILTER_EXPONENTIAL_SHIFT
+	/** With TEMPERATURE_FILTER_EXPONENTIAL, the newest sample weighs 1 / 2^TEMPERATURE_FILTER_EXPONENTIAL_SHIFT in the average (the value must be in range [1..6] to keep the average in 16 bits). */
+	#define TEMPERATURE_FILTER_EXPONENTIAL_SHIFT 2
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The sum of the conversions done for the sensor being sampled. */
+static unsigned short Temperature_Conversions_Sum;
+
+/** How many conversions are left to terminate the sensor being sampled. */
+static unsigned char Temperature_Conversions_Left_Count;
+
+/** The sensor whose conversions are being done (the ADC driver converts the queued sensors in order). */
+static unsigned char Temperature_Sampled_Sensor_Index;
+
+/** Tell whether a sensor of the current scan left its hysteresis band. */
+static unsigned char Temperature_Is_Moving;
+
+/** The last complete sample temperature of each sensor (in tenths of Celsius degrees). */
+static signed short Temperature_Values[ADC_TEMPERATURE_SENSORS_COUNT];
+
+/** The temperature the stability of each sensor is checked against (in tenths of Celsius degrees). */
+static signed short Temperature_Reference_Values[ADC_TEMPERATURE_SENSORS_COUNT];
+
+/** The current interval between two samples (in sampling periods). */
+static unsigned char Temperature_Sampling_Interval = TEMPERATURE_SAMPLING_MINIMUM_PERIODS;
+
+/** How many sampling periods are left before the next sample. */
+static unsigned char Temperature_Sampling_Periods_Left_Count = 1;
+
+#if TEMPERATURE_FILTER == TEMPERATURE_FILTER_MEDIAN
+	/** The two previous samples of each sensor, the oldest one first (in ADC LSB, the TMP36 offset being included). */
+	static unsigned short Temperature_Previous_Samples[ADC_TEMPERATURE_SENSORS_COUNT][2];
+#elif TEMPERATURE_FILTER == TEMPERATURE_FILTER_EXPONENTIAL
+	/** The samples average of each sensor (in 1 / 2^TEMPERATURE_FILTER_EXPONENTIAL_SHIFT ADC LSB, the TMP36 offset being included). */
+	static unsigned short Temperature_Averages[ADC_TEMPERATURE_SENSORS_COUNT];
+#endif
+
+#if TEMPERATURE_FILTER != TEMPERATURE_FILTER_NONE
+	/** Tell whether a complete scan has been filtered, the first sample of each sensor initializing its filter. */
+	static unsigned char Temperature_Is_Filter_Started = 0;
+#endif
+
 //--------------------------------------------------------------------------------------------------
 // Private functions
 //--------------------------------------------------------------------------------------------------
-/** Initialize Fixed Voltage Reference device at 1,024V. */
-inline void TemperatureEnableFixedVoltageReference(void)
+/** Lengthen the sampling interval while the temperature of all sensors is stable, go back to the shortest interval as soon as the temperature of one sensor moves. */
+static void TemperatureAdaptSamplingInterval(void)
 {
-	vrefcon1 = 0; // Disable DAC1
-	vrefcon0 = 0x90; // Enable FVR at 1,024V
-	while (!vrefcon0.FVR1ST); // Wait for the voltage to become stable
+	if (Temperature_Is_Moving) Temperature_Sampling_Interval = TEMPERATURE_SAMPLING_MINIMUM_PERIODS;
+	else if (Temperature_Sampling_Interval < TEMPERATURE_SAMPLING_MAXIMUM_PERIODS)
+	{
+		Temperature_Sampling_Interval <<= 1;
+		if (Temperature_Sampling_Interval > TEMPERATURE_SAMPLING_MAXIMUM_PERIODS) Temperature_Sampling_Interval = TEMPERATURE_SAMPLING_MAXIMUM_PERIODS;
+	}
+	
+	Temperature_Sampling_Periods_Left_Count = Temperature_Sampling_Interval;
 }
 
-/** Disable the Fixed Voltage Reference device to save power. */
-inline void TemperatureDisableFixedVoltageReference(void)
-{
-	vrefcon0.FVR1EN = 0;
-}
+#if TEMPERATURE_FILTER != TEMPERATURE_FILTER_NONE
+	/** Filter a sensor sample with its previous samples.
+	 * @param Sensor_Index The sampled sensor.
+	 * @param Sample The sample value in ADC LSB.
+	 * @return The filtered sample value in ADC LSB.
+	 */
+	static unsigned short TemperatureFilterSample(unsigned char Sensor_Index, unsigned short Sample)
+	{
+	#if TEMPERATURE_FILTER == TEMPERATURE_FILTER_MEDIAN
+		unsigned short *Pointer_Previous_Samples = Temperature_Previous_Samples[Sensor_Index];
+		unsigned short Lowest, Highest;
+		
+		// The first sample fills the previous samples
+		if (!Temperature_Is_Filter_Started)
+		{
+			Pointer_Previous_Samples[0] = Sample;
+			Pointer_Previous_Samples[1] = Sample;
+		}
+		
+		// Sort the previous samples and shift the new one in
+		Lowest = Pointer_Previous_Samples[0];
+		Highest = Pointer_Previous_Samples[1];
+		Pointer_Previous_Samples[0] = Highest;
+		Pointer_Previous_Samples[1] = Sample;
+		if (Lowest > Highest)
+		{
+			Highest = Lowest;
+			Lowest = Pointer_Previous_Samples[0];
+		}
+		
+		// Keep the middle sample
+		if (Sample < Lowest) return Lowest;
+		if (Sample > Highest) return Highest;
+		return Sample;
+	#else
+		unsigned short *Pointer_Average = &Temperature_Averages[Sensor_Index];
+		
+		// The first sample initializes the average, the next ones are weighted with shifts only
+		if (!Temperature_Is_Filter_Started) *Pointer_Average = Sample << TEMPERATURE_FILTER_EXPONENTIAL_SHIFT;
+		else *Pointer_Average += Sample - (*Pointer_Average >> TEMPERATURE_FILTER_EXPONENTIAL_SHIFT);
+		
+		return (*Pointer_Average + (1 << (TEMPERATURE_FILTER_EXPONENTIAL_SHIFT - 1))) >> TEMPERATURE_FILTER_EXPONENTIAL_SHIFT; // Round to the nearest LSB
+	#endif
+	}
+#endif
 
-/** Read a 10-bit value from the temperature sensor ADC channel. */
-inline unsigned short TemperatureADCReadValue(void)
+/** Accumulate a temperature sensor conversion result and compute the temperature when the sample is complete (called by the ADC driver at the end of each conversion).
+ * @param Value The conversion result.
+ */
+static void TemperatureProcessConversion(unsigned short Value)
 {
-	unsigned short Result;
-
-	// Sample analog value
-	adcon0.GO = 1; // Start conversion
-	while (adcon0.GO); // Wait for the conversion to finish
-
-	return (adresh << 8) | adresl;
+	signed short Temperature, Difference;
+	
+	Temperature_Conversions_Sum += Value;
+	Temperature_Conversions_Left_Count--;
+	if (Temperature_Conversions_Left_Count > 0) return;
+	
+	// Decimate the conversions (the rounded average is computed with a shift)
+	Temperature = (signed short) ((Temperature_Conversions_Sum + (TEMPERATURE_OVERSAMPLING_CONVERSIONS >> 1)) >> (2 * TEMPERATURE_OVERSAMPLING_BITS));
+#if TEMPERATURE_FILTER != TEMPERATURE_FILTER_NONE
+	Temperature = (signed short) TemperatureFilterSample(Temperature_Sampled_Sensor_Index, (unsigned short) Temperature); // Drop the noise the oversampling left
+#endif
+	
+	// The TMP36 generates an output voltage of 10mV/C with an offset of 500mV for 0C
+	// The ADC is configured to sample voltages from 0 to 1,024V by mapping these values from 0 to 1023, so one LSB represents 1mV or 0,1C
+	// Thus, the thermometer can theoritically measures temperatures from -50C to 102,3C
+	Temperature = Temperature - 500; // Remove TMP36 offset of 500mV
+	Temperature_Values[Temperature_Sampled_Sensor_Index] = Temperature;
+	
+	// Check whether the sensor temperature left its hysteresis band
+	Difference = Temperature - Temperature_Reference_Values[Temperature_Sampled_Sensor_Index];
+	if ((Difference > TEMPERATURE_SAMPLING_HYSTERESIS) || (Difference < -TEMPERATURE_SAMPLING_HYSTERESIS))
+	{
+		Temperature_Reference_Values[Temperature_Sampled_Sensor_Index] = Temperature;
+		Temperature_Is_Moving = 1;
+	}
+	
+	// Prepare the next sensor conversions
+	Temperature_Sampled_Sensor_Index++;
+	Temperature_Conversions_Sum = 0;
+	Temperature_Conversions_Left_Count = TEMPERATURE_OVERSAMPLING_CONVERSIONS;
+	
+	// The scan is complete
+	if (Temperature_Sampled_Sensor_Index >= ADC_TEMPERATURE_SENSORS_COUNT)
+	{
+	#if TEMPERATURE_FILTER != TEMPERATURE_FILTER_NONE
+		Temperature_Is_Filter_Started = 1;
+	#endif
+		TemperatureAdaptSamplingInterval();
+	}
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -39,61 +202,38 @@ inline unsigned short TemperatureADCReadValue(void)
 //--------------------------------------------------------------------------------------------------
 void TemperatureInitialize(void)
 {
-	// Initialize ADC pin as analog input
-	ansel.AN1 = 1;
-	trisa.RA1 = 1;
+	unsigned char i;
 	
-	// Configure ADC module
-	adcon2 = 0x88; // Conversion result is right justified, charge the sampling capacitor for almost 2 Tad, use a Fosc/2 conversion clock
-	adcon1 = 0x08; // Positive reference voltage comes from Fixed Voltage Reference, negative voltage is Vss
-	adcon0 = 0x04; // Select channel 1
-	
-	// Configure Timer 3 to generate a 1Hz interrupt
-	// The timer is clocked from the internal frequency divided by 4, so 250KHz
-	// Dividing this frequency by 65536 and a prescaler of 4 gives a 250000 / 65536 / 4 = 0.954 Hz
-	t3con = 0x20; // Select internal clock and a prescaler of 4, do not enable the timer
-	
-	// Enable module
-	TemperatureSetLowPowerMode(0);
+	// Make sure the first samples are considered as moving
+	for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++) Temperature_Reference_Values[i] = -32768;
 }
 
-signed char TemperatureReadValue(void)
+unsigned char TemperatureIsSamplingNeeded(void)
 {
-	signed short Value;
-	
-	// Sample voltage
-	Value = (signed short) TemperatureADCReadValue();
+	Temperature_Sampling_Periods_Left_Count--;
+	if (Temperature_Sampling_Periods_Left_Count == 0)
+	{
+		// Wait for the current interval again if the scan is aborted (when low power mode is entered), a complete scan adapting the interval
+		Temperature_Sampling_Periods_Left_Count = Temperature_Sampling_Interval;
+		return 1;
+	}
+	return 0;
+}
+
+void TemperatureStartSampling(void)
+{
+	unsigned char i;
 	
-	// The TMP36 generates an output voltage of 10mV/C with an offset of 500mV for 0C
-	// The ADC is configured to sample voltages from 0 to 1,024V by mapping these values from 0 to 1023
-	// Thus, the thermometer can theoritically measures temperatures from -50C to 102C
-	Value -= 500; // Remove TMP36 offset of 500mV
-	Value /= 10; // Convert to Celsius degrees
+	Temperature_Conversions_Sum = 0;
+	Temperature_Conversions_Left_Count = TEMPERATURE_OVERSAMPLING_CONVERSIONS;
+	Temperature_Sampled_Sensor_Index = 0;
+	Temperature_Is_Moving = 0;
 	
-	return (signed char) Value;
+	// Scan all sensors in the same ADC power-up
+	for (i = 0; i < ADC_TEMPERATURE_SENSORS_COUNT; i++) ADCQueueConversions((TADCChannel) (ADC_CHANNEL_TEMPERATURE + i), TEMPERATURE_OVERSAMPLING_CONVERSIONS, TemperatureProcessConversion);
 }
 
-void TemperatureSetLowPowerMode(unsigned char Is_Low_Power_Enabled)
+signed short TemperatureReadValue(unsigned char Sensor_Index)
 {
-	if (Is_Low_Power_Enabled)
-	{
-		// Disable timer 3
-		t3con.TMR3ON = 0; // Stop timer
-		pie2.TMR3IE = 0; // Disable timer interrupt
-		
-		TemperatureDisableFixedVoltageReference();
-		adcon0.ADON = 0; // Stop ADC module
-	}
-	else
-	{
-		TemperatureEnableFixedVoltageReference();
-		adcon0.ADON = 1; // Enable ADC module
-		
-		// Reenable temperature sampling timer (force the interrupt triggering to immediately sample the temperature)
-		tmr3h = 255;
-		tmr3l = 255;
-		pir2.TMR3IF = 0; // Reset timer interrupt flag to avoid spurious interrupt triggering
-		pie2.TMR3IE = 1; // Enable timer interrupt
-		t3con.TMR3ON = 1;
-	}
-}
\ No newline at end of file
+	return Temperature_Values[Sensor_Index];
+}
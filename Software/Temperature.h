@@ -6,31 +6,34 @@
 #ifndef H_TEMPERATURE_H
 #define H_TEMPERATURE_H
 
-#include <system.h>
-
 //--------------------------------------------------------------------------------------------------
 // Constants
 //--------------------------------------------------------------------------------------------------
-/** Enable the temperature sampling interrupt. */
-#define TEMPERATURE_ENABLE_INTERRUPT() pie2.TMR3IE = 1
-
-/** Disable the temperature sampling interrupt. */
-#define TEMPERATURE_DISABLE_INTERRUPT() pie2.TMR3IE = 0
+/** The sampling period when the system is running, in timer ticks (128 * 8.192ms = ~1s). */
+#define TEMPERATURE_SAMPLING_PERIOD 128
 
 //--------------------------------------------------------------------------------------------------
 // Functions
 //--------------------------------------------------------------------------------------------------
-/** Initialize the ADC channel and FVR module needed to read the temperature sensor value. */
+/** Initialize the temperature sampling state. The ADC driver must be initialized before. */
 void TemperatureInitialize(void);
 
-/** Sample the temperature from the sensor.
- * @return The read temperature converted to Celsius degrees.
+/** Tell whether a new sample must be taken. The sampling interval is lengthened while the temperature is stable and shortened as soon as it moves, so some sampling periods are skipped.
+ * @return 1 if the temperature must be sampled now,
+ * @return 0 if this sampling period must be skipped.
+ * @note Call this function once per sampling period (TEMPERATURE_SAMPLING_PERIOD ticks software timer when the system is running, wake-up timer in low power mode).
+ */
+unsigned char TemperatureIsSamplingNeeded(void);
+
+/** Queue the conversions making a sample of all temperature sensors to the ADC driver. The samples are complete when the ADC driver has terminated these conversions.
+ * @note The ADC module must be awake. The ADC interrupt can wake the core up from idle mode.
  */
-signed char TemperatureReadValue(void);
+void TemperatureStartSampling(void);
 
-/** Put the temperature module in low power mode.
- * @param Is_Low_Power_Enabled Set to 1 to enable low power mode or to 0 to run the module.
+/** Get the temperature of the last complete sample of a sensor.
+ * @param Sensor_Index The sensor index in range [0..ADC_TEMPERATURE_SENSORS_COUNT - 1].
+ * @return The read temperature in tenths of Celsius degrees.
  */
-void TemperatureSetLowPowerMode(unsigned char Is_Low_Power_Enabled);
+signed short TemperatureReadValue(unsigned char Sensor_Index);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,120 @@
+/** @file Timer.c
+ * @see Timer.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "Processor.h"
+#include "Timer.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private types
+//--------------------------------------------------------------------------------------------------
+/** A software timer. */
+typedef struct
+{
+	TTimerCallback Callback; //!< The function to call when the timer expires, the timer is stopped when it is 0.
+	unsigned char Period; //!< The timer period in ticks.
+	unsigned char Ticks_Left_Count; //!< How many ticks are left before the next expiration.
+} TTimer;
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** All software timers. */
+static TTimer Timers[TIMER_IDS_COUNT];
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void TimerInitialize(void)
+{
+	unsigned char i;
+	
+	for (i = 0; i < TIMER_IDS_COUNT; i++) Timers[i].Callback = 0;
+	
+	// Initialize the timer 0 device to generate an interrupt every 8.192ms (122Hz)
+	// The main clock is running at 1MHz, so timer clock will be 1000000/4 = 250KHz
+	// 8-bit mode is selected with a prescaler of 8, so the timer will overflow with a rate of 250000/8/256 = 122,1Hz
+	// The processor clock governor changes the prescaler with the clock frequency, the power-on 1MHz frequency is kept until the module is started
+	t0con = 0x42; // Do not enable timer, use 8-bit mode, clock from internal oscillator, use a prescaler of 8
+	intcon2.TMR0IP = 1; // The tick refreshes the screen, so it must not wait for the other interrupts
+	
+	// The stopped Timer 2 interrupt flag is set by software to process the software timers with a low priority
+	ipr1.TMR2IP = 0;
+	
+	// Run the module
+	TimerSetLowPowerMode(0);
+}
+
+void TimerStart(TTimerID Timer_ID, unsigned char Period, TTimerCallback Callback)
+{
+	unsigned char Is_Tick_Enabled;
+	
+	// Do not let the interrupt handler see a partially configured timer (the screen refresh interrupt is not masked)
+	Is_Tick_Enabled = pie1.TMR2IE;
+	pie1.TMR2IE = 0;
+	
+	Timers[Timer_ID].Period = Period;
+	Timers[Timer_ID].Ticks_Left_Count = Period;
+	Timers[Timer_ID].Callback = Callback;
+	
+	pie1.TMR2IE = Is_Tick_Enabled;
+}
+
+void TimerStop(TTimerID Timer_ID)
+{
+	unsigned char Is_Tick_Enabled;
+	
+	// The callback pointer can't be cleared atomically
+	Is_Tick_Enabled = pie1.TMR2IE;
+	pie1.TMR2IE = 0;
+	Timers[Timer_ID].Callback = 0;
+	pie1.TMR2IE = Is_Tick_Enabled;
+}
+
+void TimerTriggerTick(void)
+{
+	pir1.TMR2IF = 1;
+}
+
+void TimerProcessTick(void)
+{
+	unsigned char i;
+	
+	for (i = 0; i < TIMER_IDS_COUNT; i++)
+	{
+		if (!Timers[i].Callback) continue;
+		
+		Timers[i].Ticks_Left_Count--;
+		if (Timers[i].Ticks_Left_Count == 0)
+		{
+			Timers[i].Ticks_Left_Count = Timers[i].Period;
+			Timers[i].Callback();
+		}
+	}
+}
+
+void TimerSetLowPowerMode(unsigned char Is_Low_Power_Enabled)
+{
+	// Stop the tick
+	if (Is_Low_Power_Enabled)
+	{
+		t0con.TMR0ON = 0;
+		intcon.TMR0IE = 0;
+		pie1.TMR2IE = 0;
+		
+		ProcessorRequestClockFrequency(PROCESSOR_CLOCK_CLIENT_TIMER, PROCESSOR_CLOCK_FREQUENCY_31KHZ);
+	}
+	// Restart the tick
+	else
+	{
+		ProcessorRequestClockFrequency(PROCESSOR_CLOCK_CLIENT_TIMER, PROCESSOR_CLOCK_FREQUENCY_250KHZ); // The interrupts triggered by the tick take less than a third of the tick period at this frequency
+		
+		tmr0l = 0;
+		intcon.TMR0IF = 0; // Reset interrupt flags
+		pir1.TMR2IF = 0;
+		pie1.TMR2IE = 1;
+		intcon.TMR0IE = 1;
+		t0con.TMR0ON = 1;
+	}
+}
\ No newline at end of file
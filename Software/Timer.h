@@ -0,0 +1,71 @@
+/** @file Timer.h
+ * Multiplex all periodic jobs onto the Timer 0 tick, so a single hardware timer is needed while the system is running. The high priority Timer 0 interrupt only refreshes the screen and forwards the tick to the low priority interrupt, which processes the software timers.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#ifndef H_TIMER_H
+#define H_TIMER_H
+
+#include "Telemetry.h"
+
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+/** The tick period in microseconds (1MHz clock divided by 4, by a prescaler of 8 and by the 8-bit counter). */
+#define TIMER_TICK_PERIOD 8192
+
+//--------------------------------------------------------------------------------------------------
+// Types
+//--------------------------------------------------------------------------------------------------
+/** All software timers. Timers expiring on the same tick are handled in this order. */
+typedef enum
+{
+	TIMER_ID_BUTTON, //!< Debounce the button.
+	TIMER_ID_MEASUREMENTS, //!< Queue the conversions once the Fixed Voltage Reference is stable, it is started by the temperature sampling timer so it first expires on the next tick.
+	TIMER_ID_TEMPERATURE_SAMPLING, //!< Tell the temperature module that a sampling period elapsed.
+	TIMER_ID_SCREEN_DIMMING, //!< Count the seconds elapsed since the last user action.
+	TIMER_ID_MINUTE, //!< Signal each elapsed minute to the main loop.
+	TIMER_ID_SELECTION, //!< Signal the main loop that a page selection has been shown during half a second, it expires once.
+#if TELEMETRY_IS_ENABLED
+	TIMER_ID_TELEMETRY, //!< Power the serial port down when the last telemetry byte is shifted out.
+#endif
+	TIMER_IDS_COUNT
+} TTimerID;
+
+/** The function called when a software timer expires. It is called from the interrupt handler. */
+typedef void (*TTimerCallback)(void);
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Configure Timer 0 to generate the tick and start it. All software timers are stopped. */
+void TimerInitialize(void);
+
+/** Start a periodic software timer, or change the period of a running one.
+ * @param Timer_ID The timer to start.
+ * @param Period How many ticks separate two expirations, in range [1..255]. The first expiration occurs after a full period.
+ * @param Callback The function to call each time the timer expires.
+ */
+void TimerStart(TTimerID Timer_ID, unsigned char Period, TTimerCallback Callback);
+
+/** Stop a software timer.
+ * @param Timer_ID The timer to stop.
+ */
+void TimerStop(TTimerID Timer_ID);
+
+/** Request the software timers processing from the low priority interrupt. The Timer 2 interrupt flag is used as a software interrupt (Timer 2 itself is never started).
+ * @note This function must be called by the high priority Timer 0 interrupt.
+ */
+void TimerTriggerTick(void);
+
+/** Advance all running software timers by one tick and call the callbacks of the expired ones.
+ * @note This function must be called by the low priority Timer 2 interrupt, after its flag has been cleared.
+ */
+void TimerProcessTick(void);
+
+/** Stop or restart the tick. The software timers keep their state, so they resume where they stopped.
+ * @param Is_Low_Power_Enabled Set to 1 to stop Timer 0 or to 0 to run it again.
+ */
+void TimerSetLowPowerMode(unsigned char Is_Low_Power_Enabled);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,153 @@
+/** @file Window.c
+ * @see Window.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <system.h>
+#include "Window.h"
+
+//--------------------------------------------------------------------------------------------------
+// Private constants
+//--------------------------------------------------------------------------------------------------
+/** How many closed buckets the window holds, so how many entries a queue can hold. */
+#define WINDOW_QUEUE_SIZE (WINDOW_BUCKETS_COUNT - 1)
+
+//--------------------------------------------------------------------------------------------------
+// Private types
+//--------------------------------------------------------------------------------------------------
+/** A closed bucket peak. */
+typedef struct
+{
+	signed short Temperature; //!< The peak in tenths of Celsius degrees.
+	unsigned char Bucket_Index; //!< The bucket sequence number, it wraps around.
+} TWindowPeak;
+
+/** A monotonic queue of closed buckets peaks, stored in a ring. */
+typedef struct
+{
+	TWindowPeak Peaks[WINDOW_QUEUE_SIZE]; //!< The ring.
+	unsigned char First_Index; //!< The oldest peak index in the ring.
+	unsigned char Count; //!< How many peaks are queued.
+} TWindowQueue;
+
+//--------------------------------------------------------------------------------------------------
+// Private variables
+//--------------------------------------------------------------------------------------------------
+/** The closed buckets maxima, decreasing from the oldest to the newest. */
+static TWindowQueue Window_Maxima;
+
+/** The closed buckets minima, increasing from the oldest to the newest. */
+static TWindowQueue Window_Minima;
+
+/** The current bucket sequence number. */
+static unsigned char Window_Bucket_Index = 0;
+
+/** Tell whether a sample has been added to the current bucket. */
+static unsigned char Window_Is_Bucket_Empty = 1;
+
+/** The current bucket peaks (in tenths of Celsius degrees). */
+static signed short Window_Bucket_Maximum, Window_Bucket_Minimum;
+
+/** How many minutes are left before the current bucket is closed. */
+static unsigned char Window_Minutes_Left_Count = WINDOW_BUCKET_PERIOD;
+
+//--------------------------------------------------------------------------------------------------
+// Private functions
+//--------------------------------------------------------------------------------------------------
+/** Append a closed bucket peak to a queue, removing the queued peaks it supersedes first.
+ * @param Pointer_Queue The queue.
+ * @param Temperature The bucket peak in tenths of Celsius degrees.
+ * @param Is_Maximum Set to 1 for the maxima queue (the lower or equal peaks are removed), set to 0 for the minima queue (the greater or equal peaks are removed).
+ */
+static void WindowPushPeak(TWindowQueue *Pointer_Queue, signed short Temperature, unsigned char Is_Maximum)
+{
+	unsigned char Index;
+	
+	// A queued peak that is not better than the new one can't be a window peak anymore, as it leaves the window first
+	while (Pointer_Queue->Count > 0)
+	{
+		Index = Pointer_Queue->First_Index + Pointer_Queue->Count - 1;
+		if (Index >= WINDOW_QUEUE_SIZE) Index -= WINDOW_QUEUE_SIZE;
+		
+		if (Is_Maximum)
+		{
+			if (Pointer_Queue->Peaks[Index].Temperature > Temperature) break;
+		}
+		else if (Pointer_Queue->Peaks[Index].Temperature < Temperature) break;
+		Pointer_Queue->Count--;
+	}
+	
+	// There is always room, the expired peaks have been removed before
+	Index = Pointer_Queue->First_Index + Pointer_Queue->Count;
+	if (Index >= WINDOW_QUEUE_SIZE) Index -= WINDOW_QUEUE_SIZE;
+	Pointer_Queue->Peaks[Index].Temperature = Temperature;
+	Pointer_Queue->Peaks[Index].Bucket_Index = Window_Bucket_Index - 1; // The closed bucket is the one preceding the current one
+	Pointer_Queue->Count++;
+}
+
+/** Remove the peaks of the buckets that left the window from a queue front.
+ * @param Pointer_Queue The queue.
+ */
+static void WindowRemoveExpiredPeaks(TWindowQueue *Pointer_Queue)
+{
+	while (Pointer_Queue->Count > 0)
+	{
+		if ((unsigned char) (Window_Bucket_Index - Pointer_Queue->Peaks[Pointer_Queue->First_Index].Bucket_Index) < WINDOW_BUCKETS_COUNT) return;
+		
+		Pointer_Queue->First_Index++;
+		if (Pointer_Queue->First_Index >= WINDOW_QUEUE_SIZE) Pointer_Queue->First_Index = 0;
+		Pointer_Queue->Count--;
+	}
+}
+
+//--------------------------------------------------------------------------------------------------
+// Public functions
+//--------------------------------------------------------------------------------------------------
+void WindowAddSample(signed short Temperature)
+{
+	if (Window_Is_Bucket_Empty)
+	{
+		Window_Bucket_Maximum = Temperature;
+		Window_Bucket_Minimum = Temperature;
+		Window_Is_Bucket_Empty = 0;
+	}
+	else if (Temperature > Window_Bucket_Maximum) Window_Bucket_Maximum = Temperature;
+	else if (Temperature < Window_Bucket_Minimum) Window_Bucket_Minimum = Temperature;
+}
+
+void WindowCountMinute(void)
+{
+	Window_Minutes_Left_Count--;
+	if (Window_Minutes_Left_Count > 0) return;
+	Window_Minutes_Left_Count = WINDOW_BUCKET_PERIOD;
+	
+	// Start the next bucket, the oldest one leaving the window
+	Window_Bucket_Index++;
+	WindowRemoveExpiredPeaks(&Window_Maxima);
+	WindowRemoveExpiredPeaks(&Window_Minima);
+	
+	// Queue the closed bucket peaks
+	if (!Window_Is_Bucket_Empty)
+	{
+		WindowPushPeak(&Window_Maxima, Window_Bucket_Maximum, 1);
+		WindowPushPeak(&Window_Minima, Window_Bucket_Minimum, 0);
+		Window_Is_Bucket_Empty = 1;
+	}
+}
+
+signed short WindowGetMaximum(void)
+{
+	signed short Maximum = -32768;
+	
+	if (Window_Maxima.Count > 0) Maximum = Window_Maxima.Peaks[Window_Maxima.First_Index].Temperature;
+	if (!Window_Is_Bucket_Empty && (Window_Bucket_Maximum > Maximum)) Maximum = Window_Bucket_Maximum;
+	return Maximum;
+}
+
+signed short WindowGetMinimum(void)
+{
+	signed short Minimum = 32767;
+	
+	if (Window_Minima.Count > 0) Minimum = Window_Minima.Peaks[Window_Minima.First_Index].Temperature;
+	if (!Window_Is_Bucket_Empty && (Window_Bucket_Minimum < Minimum)) Minimum = Window_Bucket_Minimum;
+	return Minimum;
+}
\ No newline at end of file
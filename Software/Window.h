@@ -0,0 +1,43 @@
+/** @file Window.h
+ * Track the first sensor peaks over the last 24 hours. The samples are grouped in buckets whose peaks are kept in two monotonic queues (a decreasing one for the maxima, an increasing one for the minima), so each sample and each bucket end cost a constant amortized time and the window peaks are always at the queues front.
+ * @author Adrien RICCIARDI
+ * @version 1.0 : 16/10/2026
+ */
+#ifndef H_WINDOW_H
+#define H_WINDOW_H
+
+//--------------------------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------------------------
+#ifndef WINDOW_BUCKET_PERIOD
+	/** How many minutes a bucket lasts (the value must be in range [1..255]). */
+	#define WINDOW_BUCKET_PERIOD 180
+#endif
+
+#ifndef WINDOW_BUCKETS_COUNT
+	/** How many buckets the window spans, the current bucket included (the value must be in range [2..128]). Each bucket takes 6 bytes of RAM. The window covers 21 to 24 hours with the default values, depending on the current bucket progress. */
+	#define WINDOW_BUCKETS_COUNT 8
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// Functions
+//--------------------------------------------------------------------------------------------------
+/** Add a sample to the current bucket.
+ * @param Temperature The temperature in tenths of Celsius degrees.
+ */
+void WindowAddSample(signed short Temperature);
+
+/** Tell the window that a minute elapsed, the current bucket is closed every WINDOW_BUCKET_PERIOD minutes and the oldest one leaves the window. */
+void WindowCountMinute(void);
+
+/** Get the highest temperature of the window.
+ * @return The temperature in tenths of Celsius degrees, or -32768 if no sample has been added yet.
+ */
+signed short WindowGetMaximum(void);
+
+/** Get the lowest temperature of the window.
+ * @return The temperature in tenths of Celsius degrees, or 32767 if no sample has been added yet.
+ */
+signed short WindowGetMinimum(void);
+
+#endif
\ No newline at end of file